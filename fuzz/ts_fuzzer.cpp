@@ -0,0 +1,163 @@
+/**
+********************************************************************************
+* @file         ts_fuzzer.cpp
+* @brief        libFuzzer target for TS packet, PSI, descriptor, SCTE-35 and
+*               PES parsers
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "../source/ts_processor.h"
+#include "../source/ts_parse.h"
+#include "../source/ts_descriptors.h"
+#include "../source/ts_section.h"
+#include "../source/scte35.h"
+#include "../source/dvb_si.h"
+#include "../source/ts_analyzer.h"
+#include "../source/es_headers.h"
+
+/**
+********************************************************************************
+* @brief        Runs parsers over input as if it was a single TS packet, PSI
+*               section (with descriptors), splice_info_section, DVB SI
+*               tables and PES header, assembles sections across packets
+*               and runs TR 101 290 checks on them, then feeds the whole
+*               input into the demultiplexer state machine in two chunks
+*               (lazy one with subscriptions for odd first byte)
+* @param        [in] data   Fuzzer input
+* @param        [in] size   Size of input
+* @return       0
+********************************************************************************
+*/
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    // Parsers which work inside of single packet
+    if (TS_PACKET_SIZE <= size)
+    {
+        const uint8_t* payload = NULL;
+        const uint8_t* section = NULL;
+        size_t payload_size = 0;
+        size_t section_size = 0;
+        if (STATUS_OK == parse_payload(data, payload, payload_size) &&
+            STATUS_OK == parse_section(payload, payload_size, section,
+                section_size))
+        {
+            struct psi_pat pat;
+            struct psi_pmt pmt;
+            parse_pat(section, section_size, pat);
+            if (STATUS_OK == parse_pmt(section, section_size, pmt))
+            {
+                for (size_t i = 0; i < pmt.streams.size(); ++i)
+                {
+                    struct ts_stream_info info;
+                    parse_stream_info(pmt.streams[i], info);
+                }
+            }
+        }
+    }
+
+    // Section and PES parsers take exact size, so overreads are detected
+    struct psi_pat pat;
+    struct psi_pmt pmt;
+    struct pes_header pes;
+    parse_pat(data, size, pat);
+    parse_pmt(data, size, pmt);
+    parse_pes_header(data, size, pes);
+
+    struct splice_info splice;
+    parse_splice_info(data, size, splice);
+
+    std::vector<struct si_service> services;
+    std::vector<struct si_event> events;
+    uint16_t network = 0;
+    std::string network_name;
+    time_t utc = 0;
+    parse_sdt(data, size, services);
+    parse_eit(data, size, events);
+    parse_nit(data, size, network, network_name);
+    parse_tdt(data, size, utc);
+
+    // Bit reader of parameter sets must stop at the end of data
+    const STREAM_CODEC codecs[] = { CODEC_H264, CODEC_HEVC, CODEC_MPEG2V,
+        CODEC_AAC, CODEC_MPA, CODEC_AC3 };
+    struct es_props props;
+    for (size_t i = 0; i < sizeof(codecs) / sizeof(codecs[0]); ++i)
+    {
+        parse_es_props(codecs[i], data, size, props);
+    }
+
+    // Input as packets of single PID, sections may span packets
+    SectionAssembler assembler;
+    TSAnalyzer analyzer;
+    for (size_t i = 0; i + TS_PACKET_SIZE <= size; i += TS_PACKET_SIZE)
+    {
+        assembler.push(data + i);
+        analyzer.push(data + i);
+
+        uint64_t pcr = 0;
+        parse_pcr(data + i, pcr);
+
+        const uint8_t* section = NULL;
+        size_t section_size = 0;
+        while (STATUS_OK == assembler.next_section(section, section_size))
+        {
+            psi_crc32(section, section_size);
+            parse_splice_info(section, section_size, splice);
+        }
+    }
+    analyzer.finish();
+
+    // Lazy demultiplexer subscribes to streams of PMT
+    TSProcessor proc("", "", "");
+    if (0 != size && (data[0] & 0x01))
+    {
+        proc.enable_lazy();
+    }
+
+    size_t half = size / 2;
+    const uint8_t* chunks[2] = { data, data + half };
+    size_t sizes[2] = { half, size - half };
+
+    for (int i = 0; i < 2; ++i)
+    {
+        if (STATUS_OK != proc.feed(chunks[i], sizes[i]))
+        {
+            break;
+        }
+
+        struct ts_event event;
+        STATUS result = STATUS_OK;
+        while (STATUS_OK == result)
+        {
+            result = proc.next_event(event);
+            if (STATUS_OK == result && TS_EVENT_PMT == event.type)
+            {
+                const std::vector<struct ts_stream_info>& streams =
+                    proc.streams();
+                for (size_t s = 0; s < streams.size(); ++s)
+                {
+                    proc.subscribe(streams[s].pid);
+                }
+            }
+            else if (STATUS_OK == result && TS_EVENT_PES == event.type &&
+                0 != event.size)
+            {
+                // Touch event data, so overreads are detected
+                volatile uint8_t last = event.data[event.size - 1];
+                (void)last;
+            }
+        }
+
+        if (STATUS_FAIL == result)
+        {
+            break;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,226 @@
+/**
+********************************************************************************
+* @file         affinity.cpp
+* @brief        CPU affinity and NUMA-aware memory placement helpers
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "affinity.h"
+
+#include <sched.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+/**
+********************************************************************************
+* @def          MPOL_PREFERRED
+* @brief        Memory policy mode of mbind (see linux/mempolicy.h). Defined
+*               here to avoid dependency on libnuma headers
+********************************************************************************
+*/
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED  1
+#endif
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS parse_cpu_list(const char* str, std::vector<int>& cpus)
+{
+    STATUS result = STATUS_OK;
+    const char* p = str;
+
+    cpus.clear();
+    while (STATUS_OK == result && '\0' != *p)
+    {
+        char* end = NULL;
+        long first = strtol(p, &end, 10);
+        long last  = first;
+        if (end == p || first < 0 || first >= CPU_SETSIZE)
+        {
+            result = STATUS_FAIL;
+            break;
+        }
+        p = end;
+
+        if ('-' == *p)
+        {
+            last = strtol(p + 1, &end, 10);
+            if (end == p + 1 || last < first || last >= CPU_SETSIZE)
+            {
+                result = STATUS_FAIL;
+                break;
+            }
+            p = end;
+        }
+
+        for (long cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(cpu);
+        }
+
+        if (',' == *p)
+        {
+            ++p;
+        }
+        else if ('\0' != *p)
+        {
+            result = STATUS_FAIL;
+        }
+    }
+
+    if (cpus.empty())
+    {
+        result = STATUS_FAIL;
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS set_thread_cpu(pthread_attr_t* attr, int cpu)
+{
+    STATUS result = STATUS_OK;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    int r = pthread_attr_setaffinity_np(attr, sizeof(set), &set);
+    if (0 != r)
+    {
+        fprintf(stderr, "Can't set affinity to CPU %d. Error: %s\n", cpu,
+            strerror(r));
+        result = STATUS_FAIL;
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS pin_current_thread(const std::vector<int>& cpus)
+{
+    STATUS result = STATUS_OK;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (size_t i = 0; i < cpus.size(); ++i)
+    {
+        CPU_SET(cpus[i], &set);
+    }
+
+    int r = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (0 != r)
+    {
+        fprintf(stderr, "Can't set CPU affinity. Error: %s\n", strerror(r));
+        result = STATUS_FAIL;
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+int cpu_numa_node(int cpu)
+{
+    int node = NUMA_NODE_ANY;
+
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+
+    DIR* dir = opendir(path);
+    if (NULL != dir)
+    {
+        struct dirent* entry = NULL;
+        while (NULL != (entry = readdir(dir)))
+        {
+            if (0 == strncmp(entry->d_name, "node", 4) &&
+                '\0' != entry->d_name[4])
+            {
+                node = atoi(&entry->d_name[4]);
+                break;
+            }
+        }
+        closedir(dir);
+    }
+
+    return node;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void* numa_alloc(size_t size, int node)
+{
+    void* ptr = mmap(NULL, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == ptr)
+    {
+        return NULL;
+    }
+
+    if (NUMA_NODE_ANY != node)
+    {
+        const size_t bits = sizeof(unsigned long) * 8;
+        unsigned long mask[16];
+        memset(mask, 0, sizeof(mask));
+        if ((size_t)node < sizeof(mask) * 8)
+        {
+            mask[node / bits] |= 1UL << (node % bits);
+        }
+
+        /**
+        ************************************************************************
+        * @note     Failure is not critical (e.g. kernel without NUMA support),
+        *           memory stays with default placement
+        ************************************************************************
+        */
+        if (0 != syscall(SYS_mbind, ptr, size, MPOL_PREFERRED, mask,
+            sizeof(mask) * 8, 0))
+        {
+            fprintf(stderr, "Can't bind memory to NUMA node %d. Error: %s\n",
+                node, strerror(errno));
+        }
+    }
+
+    // Fault pages in now, not on the first packet
+    memset(ptr, 0, size);
+
+    return ptr;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void numa_free(void* ptr, size_t size)
+{
+    if (NULL != ptr)
+    {
+        munmap(ptr, size);
+    }
+}
@@ -0,0 +1,90 @@
+/**
+********************************************************************************
+* @file         affinity.h
+* @brief        CPU affinity and NUMA-aware memory placement helpers
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _AFFINITY_H_
+#define _AFFINITY_H_
+
+#include <vector>
+#include <stddef.h>
+#include <pthread.h>
+
+#include "ts_processor.h"
+
+/**
+********************************************************************************
+* @def          NUMA_NODE_ANY
+* @brief        Memory may be placed on any NUMA node (default policy)
+********************************************************************************
+*/
+#define NUMA_NODE_ANY   (-1)
+
+/**
+********************************************************************************
+* @brief        Parses list of CPUs in format used by taskset/cpuset, e.g.
+*               "0-3,8,10-11"
+* @param        [in] str    List of CPUs
+* @param        [out] cpus  Parsed CPU numbers in given order
+* @return       STATUS_OK on success, STATUS_FAIL - otherwise
+********************************************************************************
+*/
+STATUS parse_cpu_list(const char* str, std::vector<int>& cpus);
+
+/**
+********************************************************************************
+* @brief        Initializes thread attributes so the thread starts pinned to
+*               single CPU
+* @param        [in,out] attr   Initialized thread attributes
+* @param        [in] cpu        CPU number
+* @return       STATUS_OK on success, STATUS_FAIL - otherwise
+********************************************************************************
+*/
+STATUS set_thread_cpu(pthread_attr_t* attr, int cpu);
+
+/**
+********************************************************************************
+* @brief        Pins calling thread to the set of CPUs
+* @param        [in] cpus   CPU numbers
+* @return       STATUS_OK on success, STATUS_FAIL - otherwise
+********************************************************************************
+*/
+STATUS pin_current_thread(const std::vector<int>& cpus);
+
+/**
+********************************************************************************
+* @brief        Finds NUMA node the CPU belongs to
+* @param        [in] cpu    CPU number
+* @return       NUMA node number, NUMA_NODE_ANY if it can't be detected
+********************************************************************************
+*/
+int cpu_numa_node(int cpu);
+
+/**
+********************************************************************************
+* @brief        Allocates page aligned memory placed on given NUMA node. Pages
+*               are touched, so the memory is resident before it is used
+* @param        [in] size   Size of memory in bytes
+* @param        [in] node   NUMA node or NUMA_NODE_ANY
+* @note         Placement is a preference: if the node has no free memory
+*               kernel falls back to other nodes instead of failing
+* @return       Pointer to memory, NULL on failure
+********************************************************************************
+*/
+void* numa_alloc(size_t size, int node);
+
+/**
+********************************************************************************
+* @brief        Releases memory allocated by numa_alloc()
+* @param        [in] ptr    Pointer returned by numa_alloc() or NULL
+* @param        [in] size   Size given to numa_alloc()
+* @return       void
+********************************************************************************
+*/
+void numa_free(void* ptr, size_t size);
+
+#endif  /* !_AFFINITY_H_ */
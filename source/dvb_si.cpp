@@ -0,0 +1,685 @@
+/**
+********************************************************************************
+* @file         dvb_si.cpp
+* @brief        DVB Service Information tables (SDT, EIT, NIT, TDT/TOT)
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "dvb_si.h"
+#include "ts_cursor.h"
+
+#include <errno.h>
+#include <string.h>
+
+/**
+********************************************************************************
+* @def          SI_CRC_SIZE
+* @brief        Size of CRC32 at the end of section
+********************************************************************************
+*/
+#define SI_CRC_SIZE     4
+
+/**
+********************************************************************************
+* @def          MJD_EPOCH
+* @brief        Modified Julian Date of 1970-01-01
+********************************************************************************
+*/
+#define MJD_EPOCH       40587
+
+/**
+********************************************************************************
+* @brief        Fields following long section header (offset from table_id)
+********************************************************************************
+*/
+typedef bit_field<8, 0, 16>  sdt_original_network_id;
+typedef bit_field<8, 0, 16>  eit_transport_stream_id;
+typedef bit_field<10, 0, 16> eit_original_network_id;
+typedef bit_field<8, 4, 12>  nit_descriptors_length;
+
+/**
+********************************************************************************
+* @brief        Sizes of fixed parts of tables and their loop entries
+********************************************************************************
+*/
+#define SDT_HEADER_SIZE     11
+#define SDT_ENTRY_SIZE      5
+#define EIT_HEADER_SIZE     14
+#define EIT_ENTRY_SIZE      12
+#define NIT_HEADER_SIZE     10
+#define TDT_SIZE            8
+
+/**
+********************************************************************************
+* @brief        Converts 8-bit BCD value to binary
+* @param        [in] v  BCD value
+* @return       Binary value
+********************************************************************************
+*/
+static inline int bcd(uint8_t v)
+{
+    return (v >> 4) * 10 + (v & 0x0f);
+}
+
+/**
+********************************************************************************
+* @brief        Converts DVB string to text. Character table selection is
+*               skipped, control codes are dropped
+* @param        [in] p      String bytes
+* @param        [in] size   Length of string
+* @return       Text
+********************************************************************************
+*/
+static std::string si_text(const uint8_t* p, size_t size)
+{
+    std::string text;
+    size_t i = 0;
+
+    if (0 != size && p[0] < 0x20)
+    {
+        i = (0x10 == p[0]) ? 3 : (0x1f == p[0]) ? 2 : 1;
+    }
+
+    for (; i < size; ++i)
+    {
+        if (p[i] >= 0x20 && (p[i] < 0x80 || p[i] >= 0xa0))
+        {
+            text += static_cast<char>(p[i]);
+        }
+    }
+
+    return text;
+}
+
+/**
+********************************************************************************
+* @brief        Escapes quotes and backslashes of text for SI log
+* @param        [in] text   Text
+* @return       Escaped text
+********************************************************************************
+*/
+static std::string escape_text(const std::string& text)
+{
+    std::string escaped;
+
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        if ('"' == text[i] || '\\' == text[i])
+        {
+            escaped += '\\';
+        }
+        escaped += text[i];
+    }
+
+    return escaped;
+}
+
+/**
+********************************************************************************
+* @brief        Formats UTC time in ISO 8601
+* @param        [in] t      Time
+* @param        [out] buf   Output buffer (at least 32 bytes)
+* @return       buf
+********************************************************************************
+*/
+static const char* format_time(time_t t, char* buf)
+{
+    struct tm tm;
+    gmtime_r(&t, &tm);
+    strftime(buf, 32, "%Y-%m-%dT%H:%M:%SZ", &tm);
+
+    return buf;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+time_t si_time(const uint8_t* p)
+{
+    int mjd = (p[0] << 8) | p[1];
+
+    // All bits set mean undefined time
+    if (0xffff == mjd || mjd < MJD_EPOCH)
+    {
+        return 0;
+    }
+
+    return (time_t)(mjd - MJD_EPOCH) * 86400 + bcd(p[2]) * 3600 +
+        bcd(p[3]) * 60 + bcd(p[4]);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS parse_sdt(const uint8_t* section, size_t size,
+    std::vector<struct si_service>& services)
+{
+    STATUS result = STATUS_FAIL;
+    TSCursor cur(section, size);
+
+    services.clear();
+
+    do
+    {
+        if (size < SDT_HEADER_SIZE + SI_CRC_SIZE || !cur.require(size))
+        {
+            break;
+        }
+
+        uint16_t tsid = cur.get<psi_table_id_ext>();
+        uint16_t onid = cur.get<sdt_original_network_id>();
+        cur.skip(SDT_HEADER_SIZE);
+
+        // Service loop is parsed by its own cursor which excludes CRC
+        TSCursor loop(cur.ptr(), cur.left() - SI_CRC_SIZE);
+        while (loop.require(SDT_ENTRY_SIZE))
+        {
+            struct si_service service;
+            service.onid       = onid;
+            service.tsid       = tsid;
+            service.service_id = loop.get<bit_field<0, 0, 16> >();
+            service.running    = loop.get<bit_field<3, 0, 3> >();
+            service.type       = 0;
+            size_t desc_size   = loop.get<bit_field<3, 4, 12> >();
+            loop.skip(SDT_ENTRY_SIZE);
+
+            if (!loop.require(desc_size))
+            {
+                break;
+            }
+
+            TSCursor desc(loop.ptr(), desc_size);
+            loop.skip(desc_size);
+
+            while (desc.require(2))
+            {
+                int tag = desc.get<bit_field<0, 0, 8> >();
+                size_t len = desc.get<bit_field<1, 0, 8> >();
+                desc.skip(2);
+                if (!desc.require(len))
+                {
+                    break;
+                }
+
+                // service_descriptor: type, provider and service names
+                if (0x48 == tag && len >= 3)
+                {
+                    const uint8_t* p = desc.ptr();
+                    size_t provider = p[1];
+                    size_t name = (2 + provider < len) ? p[2 + provider] : 0;
+                    if (2 + provider < len && 3 + provider + name <= len)
+                    {
+                        service.type     = p[0];
+                        service.provider = si_text(&p[2], provider);
+                        service.name     = si_text(&p[3 + provider], name);
+                    }
+                }
+                desc.skip(len);
+            }
+
+            services.push_back(service);
+        }
+
+        if (0 != loop.left())
+        {
+            break;
+        }
+
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS parse_eit(const uint8_t* section, size_t size,
+    std::vector<struct si_event>& events)
+{
+    STATUS result = STATUS_FAIL;
+    TSCursor cur(section, size);
+
+    events.clear();
+
+    do
+    {
+        if (size < EIT_HEADER_SIZE + SI_CRC_SIZE || !cur.require(size))
+        {
+            break;
+        }
+
+        uint16_t service_id = cur.get<psi_table_id_ext>();
+        bool following = (0 != cur.get<psi_section_number>());
+        cur.skip(EIT_HEADER_SIZE);
+
+        TSCursor loop(cur.ptr(), cur.left() - SI_CRC_SIZE);
+        while (loop.require(EIT_ENTRY_SIZE))
+        {
+            struct si_event event;
+            event.service_id = service_id;
+            event.following  = following;
+            event.event_id   = loop.get<bit_field<0, 0, 16> >();
+            event.start      = si_time(loop.ptr() + 2);
+            event.duration   = bcd(loop.ptr()[7]) * 3600 +
+                bcd(loop.ptr()[8]) * 60 + bcd(loop.ptr()[9]);
+            event.running    = loop.get<bit_field<10, 0, 3> >();
+            size_t desc_size = loop.get<bit_field<10, 4, 12> >();
+            loop.skip(EIT_ENTRY_SIZE);
+
+            if (!loop.require(desc_size))
+            {
+                break;
+            }
+
+            TSCursor desc(loop.ptr(), desc_size);
+            loop.skip(desc_size);
+
+            while (desc.require(2))
+            {
+                int tag = desc.get<bit_field<0, 0, 8> >();
+                size_t len = desc.get<bit_field<1, 0, 8> >();
+                desc.skip(2);
+                if (!desc.require(len))
+                {
+                    break;
+                }
+
+                // short_event_descriptor: language, event name, text
+                const uint8_t* p = desc.ptr();
+                if (0x4d == tag && len >= 4 && 4 + (size_t)p[3] <= len &&
+                    event.name.empty())
+                {
+                    event.name = si_text(&p[4], p[3]);
+                }
+                desc.skip(len);
+            }
+
+            events.push_back(event);
+        }
+
+        if (0 != loop.left())
+        {
+            break;
+        }
+
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS parse_nit(const uint8_t* section, size_t size, uint16_t& network,
+    std::string& name)
+{
+    STATUS result = STATUS_FAIL;
+    TSCursor cur(section, size);
+
+    name.clear();
+
+    do
+    {
+        if (size < NIT_HEADER_SIZE + SI_CRC_SIZE || !cur.require(size))
+        {
+            break;
+        }
+
+        network = cur.get<psi_table_id_ext>();
+        size_t desc_size = cur.get<nit_descriptors_length>();
+        cur.skip(NIT_HEADER_SIZE);
+        if (cur.left() < desc_size + SI_CRC_SIZE)
+        {
+            break;
+        }
+
+        TSCursor desc(cur.ptr(), desc_size);
+        while (desc.require(2))
+        {
+            int tag = desc.get<bit_field<0, 0, 8> >();
+            size_t len = desc.get<bit_field<1, 0, 8> >();
+            desc.skip(2);
+            if (!desc.require(len))
+            {
+                break;
+            }
+
+            // network_name_descriptor
+            if (0x40 == tag)
+            {
+                name = si_text(desc.ptr(), len);
+            }
+            desc.skip(len);
+        }
+
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS parse_tdt(const uint8_t* section, size_t size, time_t& utc)
+{
+    STATUS result = STATUS_FAIL;
+    TSCursor cur(section, size);
+
+    if (cur.require(TDT_SIZE) && (0x70 == cur.get<psi_table_id>() ||
+        0x73 == cur.get<psi_table_id>()))
+    {
+        utc = si_time(cur.ptr() + 3);
+        result = STATUS_OK;
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+SITables::SITables(const char* const filename)
+    : m_filename(filename)
+    , m_file(NULL)
+    , m_has_clock(false)
+    , m_clock(0)
+    , m_utc(0)
+    , m_sections(0)
+    , m_decoded(0)
+    , m_crc_errors(0)
+{
+
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+SITables::~SITables()
+{
+    close();
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS SITables::init()
+{
+    STATUS result = STATUS_FAIL;
+
+    do
+    {
+        m_file = fopen(m_filename.c_str(), "w");
+        if (NULL == m_file)
+        {
+            fprintf(stderr, "Can't open SI log (%s). Error: %s\n",
+                m_filename.c_str(), strerror(errno));
+            break;
+        }
+
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void SITables::set_clock(uint64_t pts)
+{
+    m_has_clock = true;
+    m_clock = pts;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS SITables::push(const uint8_t* packet)
+{
+    STATUS result = STATUS_OK;
+    SectionAssembler& assembler =
+        m_assemblers[ts_pid::get(packet) - SI_PID_NIT];
+
+    assembler.push(packet);
+
+    const uint8_t* section = NULL;
+    size_t size = 0;
+    while (STATUS_OK == result &&
+        STATUS_OK == assembler.next_section(section, size))
+    {
+        m_sections += 1;
+        result = process_section(section, size);
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS SITables::process_section(const uint8_t* section, size_t size)
+{
+    STATUS result = STATUS_OK;
+    char t[32];
+
+    do
+    {
+        int table_id = psi_table_id::get(section);
+
+        /**
+        ************************************************************************
+        * @note     TDT has no version and is only 8 bytes, it is decoded each
+        *           time. TOT is the same time followed by descriptors and CRC
+        ************************************************************************
+        */
+        if (0x70 == table_id || 0x73 == table_id)
+        {
+            if ((0x73 == table_id && 0 != psi_crc32(section, size)) ||
+                STATUS_OK != parse_tdt(section, size, m_utc))
+            {
+                m_crc_errors += (0x73 == table_id);
+                break;
+            }
+
+            fprintf(m_file, "%s utc=%s", (0x70 == table_id) ? "TDT" : "TOT",
+                format_time(m_utc, t));
+            if (m_has_clock)
+            {
+                fprintf(m_file, " pts=%llu", (unsigned long long)m_clock);
+            }
+            fprintf(m_file, "\n");
+            m_decoded += 1;
+            break;
+        }
+
+        // Only tables which are decoded below are cached
+        bool sdt = (0x42 == table_id || 0x46 == table_id);
+        bool eit = (0x4e == table_id || 0x4f == table_id);
+        bool nit = (0x40 == table_id || 0x41 == table_id);
+        if ((!sdt && !eit && !nit) ||
+            size < PSI_HEADER_SIZE + 4 + SI_CRC_SIZE ||
+            !psi_current_next::get(section))
+        {
+            break;
+        }
+
+        /**
+        ************************************************************************
+        * @note     Key identifies section of sub-table: table_id, table ID
+        *           extension, section number, network and stream IDs (bytes
+        *           8-11 of SDT and EIT). Carousel repetition is just a lookup
+        ************************************************************************
+        */
+        uint64_t key = ((uint64_t)table_id << 56) |
+            ((uint64_t)psi_table_id_ext::get(section) << 40) |
+            ((uint64_t)psi_section_number::get(section) << 32) |
+            (nit ? 0 : sdt ? sdt_original_network_id::get(section) :
+            bit_field<8, 0, 32>::get(section));
+        uint8_t version = psi_version::get(section);
+
+        std::map<uint64_t, uint8_t>::iterator it = m_versions.find(key);
+        if (m_versions.end() != it && it->second == version)
+        {
+            break;
+        }
+
+        if (0 != psi_crc32(section, size))
+        {
+            m_crc_errors += 1;
+            break;
+        }
+        m_versions[key] = version;
+        m_decoded += 1;
+
+        if (sdt)
+        {
+            std::vector<struct si_service> services;
+            parse_sdt(section, size, services);
+            for (size_t i = 0; i < services.size(); ++i)
+            {
+                const struct si_service& s = services[i];
+                fprintf(m_file, "SDT%s onid=0x%04x tsid=0x%04x "
+                    "service=0x%04x type=0x%02x running=%d provider=\"%s\" "
+                    "name=\"%s\"\n", (0x42 == table_id) ? "" : " other",
+                    s.onid, s.tsid, s.service_id, s.type, s.running,
+                    escape_text(s.provider).c_str(),
+                    escape_text(s.name).c_str());
+
+                if (0x46 == table_id)
+                {
+                    continue;
+                }
+
+                // Services of actual stream replace previous versions
+                size_t j = 0;
+                while (j < m_services.size() &&
+                    m_services[j].service_id != s.service_id)
+                {
+                    ++j;
+                }
+
+                if (j == m_services.size())
+                {
+                    m_services.push_back(s);
+                }
+                else
+                {
+                    m_services[j] = s;
+                }
+            }
+        }
+        else if (eit)
+        {
+            std::vector<struct si_event> events;
+            parse_eit(section, size, events);
+            for (size_t i = 0; i < events.size(); ++i)
+            {
+                const struct si_event& e = events[i];
+                fprintf(m_file, "EIT%s %s service=0x%04x event=0x%04x "
+                    "start=%s duration=%u running=%d name=\"%s\"\n",
+                    (0x4e == table_id) ? "" : " other",
+                    e.following ? "following" : "present", e.service_id,
+                    e.event_id, format_time(e.start, t), e.duration,
+                    e.running, escape_text(e.name).c_str());
+            }
+        }
+        else
+        {
+            uint16_t network = 0;
+            std::string name;
+            if (STATUS_OK == parse_nit(section, size, network, name))
+            {
+                fprintf(m_file, "NIT%s network=0x%04x name=\"%s\"\n",
+                    (0x40 == table_id) ? "" : " other", network,
+                    escape_text(name).c_str());
+            }
+        }
+
+    } while(0);
+
+    if (ferror(m_file))
+    {
+        fprintf(stderr, "Can't write to SI log (%s)\n", m_filename.c_str());
+        result = STATUS_FAIL;
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+const std::vector<struct si_service>& SITables::services() const
+{
+    return m_services;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+time_t SITables::utc_time() const
+{
+    return m_utc;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS SITables::close()
+{
+    STATUS result = STATUS_OK;
+
+    if (NULL != m_file)
+    {
+        if (0 != fclose(m_file))
+        {
+            result = STATUS_FAIL;
+        }
+        m_file = NULL;
+
+        fprintf(stdout, "SI tables: %llu sections, %llu decoded, "
+            "CRC errors: %llu, %lu services (%s)\n",
+            (unsigned long long)m_sections, (unsigned long long)m_decoded,
+            (unsigned long long)m_crc_errors, m_services.size(),
+            m_filename.c_str());
+    }
+
+    return result;
+}
@@ -0,0 +1,244 @@
+/**
+********************************************************************************
+* @file         dvb_si.h
+* @brief        DVB Service Information tables (SDT, EIT, NIT, TDT/TOT)
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _DVB_SI_H_
+#define _DVB_SI_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "ts_processor.h"
+#include "ts_section.h"
+
+/**
+********************************************************************************
+* @brief        PIDs of DVB SI tables
+********************************************************************************
+*/
+#define SI_PID_NIT      0x10
+#define SI_PID_SDT      0x11
+#define SI_PID_EIT      0x12
+#define SI_PID_TDT      0x14
+
+/**
+********************************************************************************
+* @struct       si_service
+* @brief        Service of SDT
+********************************************************************************
+*/
+struct si_service
+{
+    uint16_t        onid;           ///< Original network ID
+    uint16_t        tsid;           ///< Transport stream ID
+    uint16_t        service_id;     ///< Service ID (program number)
+    uint8_t         type;           ///< Service type (0 if unknown)
+    uint8_t         running;        ///< Running status
+    std::string     provider;       ///< Service provider name
+    std::string     name;           ///< Service name
+};
+
+/**
+********************************************************************************
+* @struct       si_event
+* @brief        Event of EIT present/following
+********************************************************************************
+*/
+struct si_event
+{
+    uint16_t        service_id;     ///< Service ID
+    uint16_t        event_id;       ///< Event ID
+    bool            following;      ///< Following event (present otherwise)
+    time_t          start;          ///< Start time (UTC), 0 if undefined
+    uint32_t        duration;       ///< Duration in seconds
+    uint8_t         running;        ///< Running status
+    std::string     name;           ///< Event name
+};
+
+/**
+********************************************************************************
+* @brief        Converts DVB time (16-bit MJD and 24-bit BCD time) to UTC
+* @param        [in] p  5 bytes of time field
+* @return       Time in seconds since Epoch, 0 if time is undefined
+********************************************************************************
+*/
+time_t si_time(const uint8_t* p);
+
+/**
+********************************************************************************
+* @brief        Parses SDT section
+* @param        [in] section    Section (starting with table_id 0x42/0x46)
+* @param        [in] size       Size of the whole section including CRC
+* @param        [out] services  Services described by the section
+* @return       STATUS_OK on success, STATUS_FAIL if section is broken
+********************************************************************************
+*/
+STATUS parse_sdt(const uint8_t* section, size_t size,
+    std::vector<struct si_service>& services);
+
+/**
+********************************************************************************
+* @brief        Parses EIT present/following section
+* @param        [in] section    Section (starting with table_id 0x4e/0x4f)
+* @param        [in] size       Size of the whole section including CRC
+* @param        [out] events    Events described by the section
+* @return       STATUS_OK on success, STATUS_FAIL if section is broken
+********************************************************************************
+*/
+STATUS parse_eit(const uint8_t* section, size_t size,
+    std::vector<struct si_event>& events);
+
+/**
+********************************************************************************
+* @brief        Parses network name of NIT section
+* @param        [in] section    Section (starting with table_id 0x40/0x41)
+* @param        [in] size       Size of the whole section including CRC
+* @param        [out] network   Network ID
+* @param        [out] name      Network name (empty if absent)
+* @return       STATUS_OK on success, STATUS_FAIL if section is broken
+********************************************************************************
+*/
+STATUS parse_nit(const uint8_t* section, size_t size, uint16_t& network,
+    std::string& name);
+
+/**
+********************************************************************************
+* @brief        Parses TDT or TOT section
+* @param        [in] section    Section (starting with table_id 0x70/0x73)
+* @param        [in] size       Size of the whole section
+* @param        [out] utc       UTC time of the stream
+* @return       STATUS_OK on success, STATUS_FAIL if section is broken
+********************************************************************************
+*/
+STATUS parse_tdt(const uint8_t* section, size_t size, time_t& utc);
+
+/**
+********************************************************************************
+* @class        SITables
+* @brief        Collects DVB SI tables from NIT, SDT, EIT and TDT PIDs.
+*               Sections are cached by table_id, table ID extension, section
+*               number (and network/stream IDs), so repeated carousels cost
+*               one version compare per section; only a new version is
+*               checked by CRC, decoded and written to the SI log
+********************************************************************************
+*/
+class SITables
+{
+public:
+    /**
+    ****************************************************************************
+    * @brief    The only allowed constructor for this class
+    * @param    [in] filename   Output SI log file name
+    ****************************************************************************
+    */
+    explicit SITables(const char* const filename);
+
+    ~SITables();
+
+    /**
+    ****************************************************************************
+    * @brief    Opens output file
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS init(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Checks whether packet belongs to one of SI PIDs
+    * @param    [in] pid    PID of the packet
+    * @return   true for NIT, SDT, EIT and TDT PIDs
+    ****************************************************************************
+    */
+    bool accepts(uint16_t pid) const
+    {
+        return SI_PID_NIT <= pid && pid <= SI_PID_TDT && 0x13 != pid;
+    }
+
+    /**
+    ****************************************************************************
+    * @brief    Updates stream clock, so wall-clock time of TDT/TOT can be
+    *           mapped to PTS
+    * @param    [in] pts    PTS of the latest video (or audio) unit
+    * @return   void
+    ****************************************************************************
+    */
+    void set_clock(uint64_t pts);
+
+    /**
+    ****************************************************************************
+    * @brief    Processes packet of SI PID
+    * @param    [in] packet TS packet
+    * @return   STATUS_OK on success, STATUS_FAIL on write error
+    ****************************************************************************
+    */
+    STATUS push(const uint8_t* packet);
+
+    /**
+    ****************************************************************************
+    * @brief    Returns services of actual transport stream (SDT actual)
+    * @return   Services in order of SDT
+    ****************************************************************************
+    */
+    const std::vector<struct si_service>& services(void) const;
+
+    /**
+    ****************************************************************************
+    * @brief    Returns the latest UTC time of TDT/TOT
+    * @return   Time in seconds since Epoch, 0 if it wasn't seen yet
+    ****************************************************************************
+    */
+    time_t utc_time(void) const;
+
+    /**
+    ****************************************************************************
+    * @brief    Closes output file and prints statistics
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS close(void);
+
+private:
+    /**
+    ****************************************************************************
+    * @brief    Checks section against the cache and decodes new version
+    * @param    [in] section    Complete section
+    * @param    [in] size       Size of the section
+    * @return   STATUS_OK on success, STATUS_FAIL on write error
+    ****************************************************************************
+    */
+    STATUS process_section(const uint8_t* section, size_t size);
+
+private:    // Blocked implementations
+    SITables();
+    SITables(const SITables& r);
+    SITables& operator= (const SITables&);
+
+private:
+    std::string     m_filename;     ///< Output SI log file name
+    FILE*           m_file;         ///< Output SI log
+
+    SectionAssembler m_assemblers[SI_PID_TDT - SI_PID_NIT + 1]; ///< Per PID
+
+    std::map<uint64_t, uint8_t> m_versions; ///< Version of cached sections
+    std::vector<struct si_service> m_services; ///< Services of SDT actual
+
+    bool            m_has_clock;    ///< Stream clock is known
+    uint64_t        m_clock;        ///< PTS of the latest unit
+    time_t          m_utc;          ///< The latest TDT/TOT time
+
+    uint64_t        m_sections;     ///< Sections received
+    uint64_t        m_decoded;      ///< Sections decoded (new versions)
+    uint64_t        m_crc_errors;   ///< Sections dropped due to CRC
+};
+
+#endif  /* !_DVB_SI_H_ */
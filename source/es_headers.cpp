@@ -0,0 +1,677 @@
+/**
+********************************************************************************
+* @file         es_headers.cpp
+* @brief        Parsers of elementary stream headers (sequence parameter
+*               sets, sequence header, audio frame headers)
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "es_headers.h"
+
+#include <string.h>
+
+/**
+********************************************************************************
+* @def          NAL_MAX_SIZE
+* @brief        Size of NAL unit copied for parsing. Parameter sets are
+*               parsed up to picture size and timing, they fit into it
+********************************************************************************
+*/
+#define NAL_MAX_SIZE    512
+
+/**
+********************************************************************************
+* @class        BitReader
+* @brief        Reads bits and Exp-Golomb codes of RBSP. Reading past the end
+*               returns zero bits and sets overrun flag
+********************************************************************************
+*/
+class BitReader
+{
+public:
+    BitReader(const uint8_t* data, size_t size)
+        : m_data(data)
+        , m_bits(size * 8)
+        , m_pos(0)
+    {
+
+    }
+
+    uint32_t bits(int count)
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < count; ++i)
+        {
+            value <<= 1;
+            if (m_pos < m_bits)
+            {
+                value |= (m_data[m_pos >> 3] >> (7 - (m_pos & 7))) & 1;
+            }
+            m_pos += 1;
+        }
+
+        return value;
+    }
+
+    void skip(size_t count)
+    {
+        m_pos += count;
+    }
+
+    uint32_t ue()
+    {
+        int zeros = 0;
+        while (0 == bits(1) && zeros < 31 && !overrun())
+        {
+            ++zeros;
+        }
+
+        return ((1u << zeros) - 1) + bits(zeros);
+    }
+
+    int32_t se()
+    {
+        uint32_t code = ue();
+
+        return (code & 1) ? (int32_t)((code + 1) / 2) : -(int32_t)(code / 2);
+    }
+
+    bool overrun() const
+    {
+        return m_pos > m_bits;
+    }
+
+private:
+    const uint8_t*  m_data;     ///< RBSP
+    size_t          m_bits;     ///< Size of RBSP in bits
+    size_t          m_pos;      ///< Position of the next bit
+};
+
+/**
+********************************************************************************
+* @brief        Copies NAL unit payload removing emulation prevention bytes
+* @param        [in] data   NAL unit after start code
+* @param        [in] size   Bytes available
+* @param        [out] rbsp  Output buffer (NAL_MAX_SIZE bytes)
+* @return       Size of RBSP
+********************************************************************************
+*/
+static size_t unescape_nal(const uint8_t* data, size_t size, uint8_t* rbsp)
+{
+    size_t out = 0;
+    int zeros = 0;
+
+    for (size_t i = 0; i < size && out < NAL_MAX_SIZE; ++i)
+    {
+        if (zeros >= 2 && data[i] <= 0x03)
+        {
+            if (0x03 != data[i])
+            {
+                break;  // Next start code
+            }
+            zeros = 0;
+            continue;
+        }
+
+        zeros = (0 == data[i]) ? zeros + 1 : 0;
+        rbsp[out++] = data[i];
+    }
+
+    return out;
+}
+
+/**
+********************************************************************************
+* @brief        Skips scaling list of H.264 SPS
+* @param        [in] br     Bit reader
+* @param        [in] size   Number of coefficients
+* @return       void
+********************************************************************************
+*/
+static void skip_scaling_list(BitReader& br, int size)
+{
+    int last = 8;
+    int next = 8;
+
+    for (int i = 0; i < size && !br.overrun(); ++i)
+    {
+        if (0 != next)
+        {
+            next = (last + br.se() + 256) % 256;
+        }
+        last = (0 == next) ? last : next;
+    }
+}
+
+/**
+********************************************************************************
+* @brief        Parses H.264 sequence parameter set
+* @param        [in] rbsp   SPS without NAL header
+* @param        [in] size   Size of SPS
+* @param        [out] props Stream properties
+* @return       STATUS_OK on success, STATUS_FAIL if SPS is broken
+********************************************************************************
+*/
+static STATUS parse_h264_sps(const uint8_t* rbsp, size_t size,
+    struct es_props& props)
+{
+    BitReader br(rbsp, size);
+
+    int profile = br.bits(8);
+    br.skip(8);     // Constraint flags
+    int level = br.bits(8);
+    br.ue();        // seq_parameter_set_id
+
+    int chroma_format = 1;
+    bool separate_planes = false;
+    if (100 == profile || 110 == profile || 122 == profile ||
+        244 == profile || 44 == profile || 83 == profile || 86 == profile ||
+        118 == profile || 128 == profile || 138 == profile ||
+        139 == profile || 134 == profile || 135 == profile)
+    {
+        chroma_format = br.ue();
+        if (3 == chroma_format)
+        {
+            separate_planes = (1 == br.bits(1));
+        }
+        br.ue();    // bit_depth_luma_minus8
+        br.ue();    // bit_depth_chroma_minus8
+        br.skip(1); // qpprime_y_zero_transform_bypass_flag
+
+        if (br.bits(1))
+        {
+            int lists = (3 != chroma_format) ? 8 : 12;
+            for (int i = 0; i < lists; ++i)
+            {
+                if (br.bits(1))
+                {
+                    skip_scaling_list(br, (i < 6) ? 16 : 64);
+                }
+            }
+        }
+    }
+
+    br.ue();        // log2_max_frame_num_minus4
+    int poc_type = br.ue();
+    if (0 == poc_type)
+    {
+        br.ue();    // log2_max_pic_order_cnt_lsb_minus4
+    }
+    else if (1 == poc_type)
+    {
+        br.skip(1);
+        br.se();
+        br.se();
+        uint32_t cycle = br.ue();
+        for (uint32_t i = 0; i < cycle && !br.overrun(); ++i)
+        {
+            br.se();
+        }
+    }
+
+    br.ue();        // max_num_ref_frames
+    br.skip(1);     // gaps_in_frame_num_value_allowed_flag
+    uint32_t width_mbs = br.ue() + 1;
+    uint32_t height_units = br.ue() + 1;
+    int frame_mbs_only = br.bits(1);
+    if (!frame_mbs_only)
+    {
+        br.skip(1); // mb_adaptive_frame_field_flag
+    }
+    br.skip(1);     // direct_8x8_inference_flag
+
+    uint32_t crop[4] = { 0, 0, 0, 0 };
+    if (br.bits(1))
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            crop[i] = br.ue();
+        }
+    }
+
+    // Timing info of VUI gives frame rate
+    uint32_t units = 0;
+    uint32_t scale = 0;
+    if (br.bits(1))
+    {
+        if (br.bits(1) && 255 == br.bits(8))
+        {
+            br.skip(32);    // Sample aspect ratio
+        }
+
+        if (br.bits(1))
+        {
+            br.skip(1);     // overscan_appropriate_flag
+        }
+
+        if (br.bits(1))
+        {
+            br.skip(4);     // video_format, video_full_range_flag
+            if (br.bits(1))
+            {
+                br.skip(24);    // Colour description
+            }
+        }
+
+        if (br.bits(1))
+        {
+            br.ue();
+            br.ue();
+        }
+
+        if (br.bits(1))
+        {
+            units = br.bits(32);
+            scale = br.bits(32);
+        }
+    }
+
+    if (br.overrun() || width_mbs > 1024 || height_units > 1024)
+    {
+        return STATUS_FAIL;
+    }
+
+    int crop_x = (0 == chroma_format || separate_planes ||
+        3 == chroma_format) ? 1 : 2;
+    int crop_y = (2 - frame_mbs_only) * ((1 == chroma_format) ? 2 : 1);
+
+    props.profile = profile;
+    props.level   = level;
+    props.width   = width_mbs * 16 - crop_x * (crop[0] + crop[1]);
+    props.height  = (2 - frame_mbs_only) * height_units * 16 -
+        crop_y * (crop[2] + crop[3]);
+
+    // Frame rate is half of field rate of time_scale
+    if (0 != units && 0 != scale)
+    {
+        props.frame_rate_num = scale;
+        props.frame_rate_den = units * 2;
+    }
+
+    return STATUS_OK;
+}
+
+/**
+********************************************************************************
+* @brief        Parses HEVC sequence parameter set
+* @param        [in] rbsp   SPS without NAL header
+* @param        [in] size   Size of SPS
+* @param        [out] props Stream properties
+* @return       STATUS_OK on success, STATUS_FAIL if SPS is broken
+********************************************************************************
+*/
+static STATUS parse_hevc_sps(const uint8_t* rbsp, size_t size,
+    struct es_props& props)
+{
+    BitReader br(rbsp, size);
+
+    br.skip(4);     // sps_video_parameter_set_id
+    int sub_layers = br.bits(3);
+    br.skip(1);     // sps_temporal_id_nesting_flag
+
+    // profile_tier_level()
+    br.skip(3);     // general_profile_space, general_tier_flag
+    int profile = br.bits(5);
+    br.skip(32 + 48);
+    int level = br.bits(8);
+
+    bool sub_profile[8];
+    bool sub_level[8];
+    for (int i = 0; i < sub_layers; ++i)
+    {
+        sub_profile[i] = (1 == br.bits(1));
+        sub_level[i] = (1 == br.bits(1));
+    }
+
+    if (0 < sub_layers)
+    {
+        br.skip(2 * (8 - sub_layers));
+    }
+
+    for (int i = 0; i < sub_layers; ++i)
+    {
+        br.skip((sub_profile[i] ? 88 : 0) + (sub_level[i] ? 8 : 0));
+    }
+
+    br.ue();        // sps_seq_parameter_set_id
+    uint32_t chroma_format = br.ue();
+    if (3 == chroma_format)
+    {
+        br.skip(1); // separate_colour_plane_flag
+    }
+    uint32_t width = br.ue();
+    uint32_t height = br.ue();
+
+    uint32_t window[4] = { 0, 0, 0, 0 };
+    if (br.bits(1))
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            window[i] = br.ue();
+        }
+    }
+
+    if (br.overrun() || width > 16384 || height > 16384)
+    {
+        return STATUS_FAIL;
+    }
+
+    int sub_width = (1 == chroma_format || 2 == chroma_format) ? 2 : 1;
+    int sub_height = (1 == chroma_format) ? 2 : 1;
+
+    props.profile = profile;
+    props.level   = level;
+    props.width   = width - sub_width * (window[0] + window[1]);
+    props.height  = height - sub_height * (window[2] + window[3]);
+
+    return STATUS_OK;
+}
+
+/**
+********************************************************************************
+* @brief        Finds SPS NAL unit of H.264 or HEVC and parses it
+* @param        [in] codec  CODEC_H264 or CODEC_HEVC
+* @param        [in] data   ES data
+* @param        [in] size   Size of ES data
+* @param        [out] props Stream properties
+* @return       STATUS_OK if SPS is parsed, STATUS_AGAIN - otherwise
+********************************************************************************
+*/
+static STATUS parse_nal_sps(STREAM_CODEC codec, const uint8_t* data,
+    size_t size, struct es_props& props)
+{
+    uint8_t rbsp[NAL_MAX_SIZE];
+    size_t header = (CODEC_HEVC == codec) ? 2 : 1;
+
+    for (size_t i = 0; i + 3 + header < size; ++i)
+    {
+        if (0 != data[i] || 0 != data[i + 1] || 1 != data[i + 2])
+        {
+            continue;
+        }
+
+        const uint8_t* nal = &data[i + 3];
+        bool sps = (CODEC_HEVC == codec) ? (33 == ((nal[0] >> 1) & 0x3f)) :
+            (7 == (nal[0] & 0x1f));
+        if (!sps)
+        {
+            continue;
+        }
+
+        size_t rbsp_size = unescape_nal(nal + header, size - i - 3 - header,
+            rbsp);
+        STATUS result = (CODEC_HEVC == codec) ?
+            parse_hevc_sps(rbsp, rbsp_size, props) :
+            parse_h264_sps(rbsp, rbsp_size, props);
+        if (STATUS_OK == result)
+        {
+            return STATUS_OK;
+        }
+    }
+
+    return STATUS_AGAIN;
+}
+
+/**
+********************************************************************************
+* @brief        Finds MPEG-1/2 video sequence header and parses it
+* @param        [in] data   ES data
+* @param        [in] size   Size of ES data
+* @param        [out] props Stream properties
+* @return       STATUS_OK if header is parsed, STATUS_AGAIN - otherwise
+********************************************************************************
+*/
+static STATUS parse_sequence_header(const uint8_t* data, size_t size,
+    struct es_props& props)
+{
+    static const uint32_t s_rates[9][2] =
+    {
+        { 0, 0 }, { 24000, 1001 }, { 24, 1 }, { 25, 1 }, { 30000, 1001 },
+        { 30, 1 }, { 50, 1 }, { 60000, 1001 }, { 60, 1 }
+    };
+
+    for (size_t i = 0; i + 12 <= size; ++i)
+    {
+        if (0 != data[i] || 0 != data[i + 1] || 1 != data[i + 2] ||
+            0xb3 != data[i + 3])
+        {
+            continue;
+        }
+
+        const uint8_t* p = &data[i + 4];
+        int rate = p[3] & 0x0f;
+        props.width  = (p[0] << 4) | (p[1] >> 4);
+        props.height = ((p[1] & 0x0f) << 8) | p[2];
+        if (rate < 9)
+        {
+            props.frame_rate_num = s_rates[rate][0];
+            props.frame_rate_den = s_rates[rate][1];
+        }
+        props.bitrate = ((p[4] << 10) | (p[5] << 2) | (p[6] >> 6)) * 400;
+
+        return STATUS_OK;
+    }
+
+    return STATUS_AGAIN;
+}
+
+/**
+********************************************************************************
+* @brief        Finds ADTS header of AAC and parses it
+* @param        [in] data   ES data
+* @param        [in] size   Size of ES data
+* @param        [out] props Stream properties
+* @return       STATUS_OK if header is parsed, STATUS_AGAIN - otherwise
+********************************************************************************
+*/
+static STATUS parse_adts(const uint8_t* data, size_t size,
+    struct es_props& props)
+{
+    static const uint32_t s_rates[13] =
+    {
+        96000, 88200, 64000, 48000, 44100, 32000, 24000, 22050, 16000,
+        12000, 11025, 8000, 7350
+    };
+
+    for (size_t i = 0; i + 7 <= size; ++i)
+    {
+        const uint8_t* p = &data[i];
+        int rate = (p[2] >> 2) & 0x0f;
+        if (0xff != p[0] || 0xf0 != (p[1] & 0xf6) || rate >= 13)
+        {
+            continue;
+        }
+
+        props.profile     = (p[2] >> 6) + 1;
+        props.sample_rate = s_rates[rate];
+        props.channels    = ((p[2] & 0x01) << 2) | (p[3] >> 6);
+
+        return STATUS_OK;
+    }
+
+    return STATUS_AGAIN;
+}
+
+/**
+********************************************************************************
+* @brief        Finds MPEG audio frame header and parses it
+* @param        [in] data   ES data
+* @param        [in] size   Size of ES data
+* @param        [out] props Stream properties
+* @return       STATUS_OK if header is parsed, STATUS_AGAIN - otherwise
+********************************************************************************
+*/
+static STATUS parse_mpa(const uint8_t* data, size_t size,
+    struct es_props& props)
+{
+    // Bitrates (kbit/s) of MPEG-1 layers I-III and MPEG-2/2.5 layers I, II-III
+    static const uint16_t s_bitrates[5][15] =
+    {
+        { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416,
+          448 },
+        { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },
+        { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 },
+        { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },
+        { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 }
+    };
+    static const uint32_t s_rates[3] = { 44100, 48000, 32000 };
+
+    for (size_t i = 0; i + 4 <= size; ++i)
+    {
+        const uint8_t* p = &data[i];
+        int version = (p[1] >> 3) & 0x03;   // 3 - MPEG-1, 2 - MPEG-2, 0 - 2.5
+        int layer = 4 - ((p[1] >> 1) & 0x03);
+        int bitrate = p[2] >> 4;
+        int rate = (p[2] >> 2) & 0x03;
+        if (0xff != p[0] || 0xe0 != (p[1] & 0xe0) || 1 == version ||
+            4 == layer || 15 == bitrate || 3 == rate)
+        {
+            continue;
+        }
+
+        int table = (3 == version) ? layer - 1 : (1 == layer) ? 3 : 4;
+        props.profile     = layer;
+        props.sample_rate = s_rates[rate] >> ((3 == version) ? 0 :
+            (2 == version) ? 1 : 2);
+        props.channels    = (3 == (p[3] >> 6)) ? 1 : 2;
+        props.bitrate     = s_bitrates[table][bitrate] * 1000;
+
+        return STATUS_OK;
+    }
+
+    return STATUS_AGAIN;
+}
+
+/**
+********************************************************************************
+* @brief        Finds AC-3 or E-AC-3 sync frame and parses its header
+* @param        [in] data   ES data
+* @param        [in] size   Size of ES data
+* @param        [out] props Stream properties
+* @return       STATUS_OK if header is parsed, STATUS_AGAIN - otherwise
+********************************************************************************
+*/
+static STATUS parse_ac3(const uint8_t* data, size_t size,
+    struct es_props& props)
+{
+    static const uint16_t s_bitrates[19] =
+    {
+        32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384,
+        448, 512, 576, 640
+    };
+    static const uint32_t s_rates[3] = { 48000, 44100, 32000 };
+    static const uint8_t s_channels[8] = { 2, 1, 2, 3, 3, 4, 4, 5 };
+    static const int s_blocks[4] = { 1, 2, 3, 6 };
+
+    for (size_t i = 0; i + 8 <= size; ++i)
+    {
+        const uint8_t* p = &data[i];
+        int bsid = p[5] >> 3;
+        if (0x0b != p[0] || 0x77 != p[1] || bsid > 16)
+        {
+            continue;
+        }
+
+        if (bsid <= 10)
+        {
+            // AC-3: fscod, frmsizecod, bsid, bsmod, acmod and mix levels
+            int fscod = p[4] >> 6;
+            int frmsizecod = p[4] & 0x3f;
+            if (3 == fscod || frmsizecod >= 38)
+            {
+                continue;
+            }
+
+            BitReader br(&p[6], 2);
+            int acmod = br.bits(3);
+            br.skip(((acmod & 1) && 1 != acmod) ? 2 : 0);
+            br.skip((acmod & 4) ? 2 : 0);
+            br.skip((2 == acmod) ? 2 : 0);
+
+            props.sample_rate = s_rates[fscod];
+            props.bitrate     = s_bitrates[frmsizecod >> 1] * 1000;
+            props.channels    = s_channels[acmod] + br.bits(1);
+        }
+        else
+        {
+            // E-AC-3: strmtyp, substreamid, frmsiz, fscod, numblkscod
+            BitReader br(&p[2], 4);
+            br.skip(5);
+            uint32_t frame = (br.bits(11) + 1) * 2;
+            int fscod = br.bits(2);
+            int blocks = 6;
+            uint32_t rate = 0;
+            if (3 == fscod)
+            {
+                int fscod2 = br.bits(2);
+                rate = (3 == fscod2) ? 0 : s_rates[fscod2] / 2;
+            }
+            else
+            {
+                blocks = s_blocks[br.bits(2)];
+                rate = s_rates[fscod];
+            }
+
+            if (0 == rate)
+            {
+                continue;
+            }
+
+            int acmod = br.bits(3);
+            props.sample_rate = rate;
+            props.bitrate     = (uint32_t)((uint64_t)frame * 8 * rate /
+                (blocks * 256));
+            props.channels    = s_channels[acmod] + br.bits(1);
+        }
+
+        return STATUS_OK;
+    }
+
+    return STATUS_AGAIN;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS parse_es_props(STREAM_CODEC codec, const uint8_t* data, size_t size,
+    struct es_props& props)
+{
+    STATUS result = STATUS_FAIL;
+
+    memset(&props, 0, sizeof(props));
+
+    switch (codec)
+    {
+        case CODEC_H264:
+        case CODEC_HEVC:
+            result = parse_nal_sps(codec, data, size, props);
+            break;
+
+        case CODEC_MPEG1V:
+        case CODEC_MPEG2V:
+            result = parse_sequence_header(data, size, props);
+            break;
+
+        case CODEC_AAC:
+            result = parse_adts(data, size, props);
+            break;
+
+        case CODEC_MPA:
+            result = parse_mpa(data, size, props);
+            break;
+
+        case CODEC_AC3:
+        case CODEC_EAC3:
+            result = parse_ac3(data, size, props);
+            break;
+
+        default:
+            break;
+    }
+
+    return result;
+}
@@ -0,0 +1,55 @@
+/**
+********************************************************************************
+* @file         es_headers.h
+* @brief        Parsers of elementary stream headers (sequence parameter
+*               sets, sequence header, audio frame headers)
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _ES_HEADERS_H_
+#define _ES_HEADERS_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ts_processor.h"
+
+/**
+********************************************************************************
+* @struct       es_props
+* @brief        Properties of elementary stream taken from its headers.
+*               Fields which are unknown for the codec are 0
+********************************************************************************
+*/
+struct es_props
+{
+    uint16_t    width;              ///< Picture width (cropped)
+    uint16_t    height;             ///< Picture height (cropped)
+    uint32_t    frame_rate_num;     ///< Frame rate numerator
+    uint32_t    frame_rate_den;     ///< Frame rate denominator
+    int         profile;            ///< Profile (AAC object type, MPA layer)
+    int         level;              ///< Level (level_idc)
+    uint32_t    sample_rate;        ///< Audio sample rate (Hz)
+    uint8_t     channels;           ///< Audio channels (including LFE)
+    uint32_t    bitrate;            ///< Nominal bitrate (bit/s)
+};
+
+/**
+********************************************************************************
+* @brief        Searches ES data for the first header describing the stream:
+*               SPS of H.264 and HEVC, sequence header of MPEG-1/2 video,
+*               ADTS header of AAC, MPEG audio, AC-3 and E-AC-3 frame header
+* @param        [in] codec  Codec of the stream
+* @param        [in] data   ES data (PES payload)
+* @param        [in] size   Size of ES data
+* @param        [out] props Properties of the stream
+* @return       STATUS_OK if header is found, STATUS_AGAIN if data has no
+*               header yet, STATUS_FAIL if codec isn't supported
+********************************************************************************
+*/
+STATUS parse_es_props(STREAM_CODEC codec, const uint8_t* data, size_t size,
+    struct es_props& props);
+
+#endif  /* !_ES_HEADERS_H_ */
@@ -0,0 +1,341 @@
+/**
+********************************************************************************
+* @file         es_writer.cpp
+* @brief        Elementary stream output file class implementation
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "es_writer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+ESWriter::ESWriter(const char* const filename)
+    : m_filename(filename)
+    , m_fd(-1)
+    , m_buffer(NULL)
+    , m_buffer_size(0)
+    , m_written(0)
+    , m_synced(0)
+    , m_preallocated(false)
+    , m_resume(false)
+    , m_resume_index(0)
+    , m_pts_index(NULL)
+{
+
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+ESWriter::~ESWriter()
+{
+    close();
+
+    free(m_buffer);
+    m_buffer = NULL;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS ESWriter::init()
+{
+    STATUS result = STATUS_FAIL;
+
+    do
+    {
+        m_fd = open(m_filename.c_str(), O_WRONLY | O_CREAT |
+            (m_resume ? 0 : O_TRUNC), 0644);
+        if (-1 == m_fd)
+        {
+            fprintf(stderr, "Can't open/create stream file (%s). Error: %s\n",
+                m_filename.c_str(), strerror(errno));
+            break;
+        }
+
+        // Data written after checkpoint is dropped
+        struct stat st;
+        if (m_resume && (0 != fstat(m_fd, &st) ||
+            (uint64_t)st.st_size < m_written ||
+            0 != ftruncate(m_fd, m_written) ||
+            (off_t)m_written != lseek(m_fd, m_written, SEEK_SET)))
+        {
+            fprintf(stderr, "Can't continue stream file (%s) from %llu "
+                "bytes\n", m_filename.c_str(), (unsigned long long)m_written);
+            break;
+        }
+
+        void* buffer = NULL;
+        if (0 != posix_memalign(&buffer, 4096, ES_WRITE_BUFFER))
+        {
+            fprintf(stderr, "Can't allocate buffer for %s\n",
+                m_filename.c_str());
+            break;
+        }
+        m_buffer = static_cast<uint8_t*>(buffer);
+
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void ESWriter::resume_at(uint64_t size, uint64_t index_size)
+{
+    m_resume       = true;
+    m_resume_index = index_size;
+    m_written      = size;
+    m_synced       = size;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS ESWriter::checkpoint(uint64_t& size, uint64_t& index_size)
+{
+    STATUS result = STATUS_FAIL;
+
+    do
+    {
+        if (STATUS_OK != flush() || 0 != fdatasync(m_fd))
+        {
+            fprintf(stderr, "Can't sync (%s) file. Error: %s\n",
+                m_filename.c_str(), strerror(errno));
+            break;
+        }
+
+        index_size = 0;
+        if (NULL != m_pts_index)
+        {
+            long position = ftell(m_pts_index);
+            if (0 != fflush(m_pts_index) || position < 0 ||
+                0 != fdatasync(fileno(m_pts_index)))
+            {
+                fprintf(stderr, "Can't sync PTS index of (%s) file. "
+                    "Error: %s\n", m_filename.c_str(), strerror(errno));
+                break;
+            }
+            index_size = position;
+        }
+
+        size = m_written;
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void ESWriter::preallocate(uint64_t size)
+{
+    if (-1 != m_fd && 0 != size &&
+        0 == fallocate(m_fd, FALLOC_FL_KEEP_SIZE, 0, size))
+    {
+        m_preallocated = true;
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS ESWriter::write(const uint8_t* data, size_t size)
+{
+    STATUS result = STATUS_OK;
+
+    while (0 != size && STATUS_OK == result)
+    {
+        size_t take = ES_WRITE_BUFFER - m_buffer_size;
+        if (take > size)
+        {
+            take = size;
+        }
+
+        memcpy(&m_buffer[m_buffer_size], data, take);
+        m_buffer_size += take;
+        data += take;
+        size -= take;
+
+        if (ES_WRITE_BUFFER == m_buffer_size)
+        {
+            result = flush();
+        }
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS ESWriter::enable_pts_index()
+{
+    STATUS result = STATUS_OK;
+
+    if (NULL == m_pts_index)
+    {
+        std::string name = m_filename + ".pts";
+        bool resume = m_resume && 0 != m_resume_index;
+
+        // Index of continued file is truncated to the checkpoint
+        m_pts_index = (resume && 0 != truncate(name.c_str(),
+            m_resume_index)) ? NULL : fopen(name.c_str(), resume ? "a" : "w");
+        if (NULL == m_pts_index)
+        {
+            fprintf(stderr, "Can't open PTS index (%s). Error: %s\n",
+                name.c_str(), strerror(errno));
+            result = STATUS_FAIL;
+        }
+        else if (!resume)
+        {
+            fprintf(m_pts_index, "# pts offset\n");
+        }
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void ESWriter::mark_unit(uint64_t pts)
+{
+    if (NULL != m_pts_index)
+    {
+        fprintf(m_pts_index, "%llu %llu\n", (unsigned long long)pts,
+            (unsigned long long)(m_written + m_buffer_size));
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS ESWriter::flush()
+{
+    STATUS result = STATUS_OK;
+    const uint8_t* data = m_buffer;
+
+    while (0 != m_buffer_size)
+    {
+        ssize_t r = ::write(m_fd, data, m_buffer_size);
+        if (r < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
+            fprintf(stderr, "Can't write to (%s) file (%lu) bytes! Error: %s\n",
+                m_filename.c_str(), m_buffer_size, strerror(errno));
+            result = STATUS_FAIL;
+            break;
+        }
+
+        data          += r;
+        m_buffer_size -= r;
+        m_written     += r;
+    }
+
+    m_buffer_size = 0;
+
+    if (m_written - m_synced >= ES_WRITE_BEHIND)
+    {
+        /**
+        ************************************************************************
+        * @note     New window is submitted for writeback asynchronously, the
+        *           previous one is waited for. Amount of dirty pages stays
+        *           within two windows and the device is kept busy, instead of
+        *           one huge flush when the file is closed. Errors are ignored
+        *           since it is only a hint for the kernel
+        ************************************************************************
+        */
+        uint64_t window = m_written - m_synced;
+        sync_file_range(m_fd, m_synced, window, SYNC_FILE_RANGE_WRITE);
+        if (m_synced >= ES_WRITE_BEHIND)
+        {
+            sync_file_range(m_fd, m_synced - ES_WRITE_BEHIND, ES_WRITE_BEHIND,
+                SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE |
+                SYNC_FILE_RANGE_WAIT_AFTER);
+        }
+        m_synced = m_written;
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS ESWriter::close()
+{
+    STATUS result = STATUS_OK;
+
+    if (-1 != m_fd)
+    {
+        result = flush();
+
+        // Release reserved space which wasn't used
+        if (m_preallocated && 0 != ftruncate(m_fd, m_written))
+        {
+            fprintf(stderr, "Can't truncate (%s) file. Error: %s\n",
+                m_filename.c_str(), strerror(errno));
+            result = STATUS_FAIL;
+        }
+
+        if (0 != ::close(m_fd))
+        {
+            result = STATUS_FAIL;
+        }
+        m_fd = -1;
+    }
+
+    if (NULL != m_pts_index)
+    {
+        if (0 != fclose(m_pts_index))
+        {
+            result = STATUS_FAIL;
+        }
+        m_pts_index = NULL;
+    }
+
+    return result;
+}
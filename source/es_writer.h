@@ -0,0 +1,181 @@
+/**
+********************************************************************************
+* @file         es_writer.h
+* @brief        Elementary stream output file class declaration
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _ES_WRITER_H_
+#define _ES_WRITER_H_
+
+#include <string>
+#include <stdint.h>
+
+#include "ts_processor.h"
+
+/**
+********************************************************************************
+* @def          ES_WRITE_BUFFER
+* @brief        Size of single write to output file. All writes except the
+*               last one are of this size, so they are aligned in the file
+********************************************************************************
+*/
+#define ES_WRITE_BUFFER     (1024 * 1024)
+
+/**
+********************************************************************************
+* @def          ES_WRITE_BEHIND
+* @brief        Amount of data after which dirty pages are submitted for
+*               writeback, so they don't pile up until the file is closed
+********************************************************************************
+*/
+#define ES_WRITE_BEHIND     (8 * 1024 * 1024)
+
+/**
+********************************************************************************
+* @class        ESWriter
+* @brief        Output file of elementary stream. Data is collected into large
+*               aligned writes, file space can be preallocated in advance to
+*               avoid fragmentation, written data is flushed progressively
+*               with sync_file_range()
+********************************************************************************
+*/
+class ESWriter
+{
+public:
+    /**
+    ****************************************************************************
+    * @brief    The only allowed constructor for this class
+    * @param    [in] filename    Output file name
+    ****************************************************************************
+    */
+    explicit ESWriter(const char* const filename);
+
+    ~ESWriter();
+
+    /**
+    ****************************************************************************
+    * @brief    Opens/creates output file and allocates buffer
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS init(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Makes init() continue existing file of checkpoint instead of
+    *           creating it: file and its PTS index are truncated to the sizes
+    *           of the checkpoint. Must be called before init()
+    * @param    [in] size       Size of the file at the checkpoint
+    * @param    [in] index_size Size of PTS index at the checkpoint
+    * @return   void
+    ****************************************************************************
+    */
+    void resume_at(uint64_t size, uint64_t index_size);
+
+    /**
+    ****************************************************************************
+    * @brief    Writes buffered data and PTS index and waits until they reach
+    *           the disk, so the file is consistent with checkpoint
+    * @param    [out] size          Size of the file
+    * @param    [out] index_size    Size of PTS index (0 if disabled)
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS checkpoint(uint64_t& size, uint64_t& index_size);
+
+    /**
+    ****************************************************************************
+    * @brief    Reserves file space for expected size of the stream. Size of
+    *           the file isn't changed, unused space is released on close()
+    * @param    [in] size   Expected size of the stream in bytes
+    * @note     Failure is not critical (e.g. file system doesn't support
+    *           fallocate), file just grows on writes
+    * @return   void
+    ****************************************************************************
+    */
+    void preallocate(uint64_t size);
+
+    /**
+    ****************************************************************************
+    * @brief    Appends data to the output file
+    * @param    [in] data   Data to write
+    * @param    [in] size   Size of data in bytes
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS write(const uint8_t* data, size_t size);
+
+    /**
+    ****************************************************************************
+    * @brief    Creates PTS index next to output file (file name with .pts
+    *           suffix). Each line of the index is PTS of access unit and its
+    *           offset in output file. Used for streams which are useless
+    *           without timing (subtitles, teletext)
+    * @return   STATUS_OK on success (or if index already exists),
+    *           STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS enable_pts_index(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Records start of new unit at current end of output. Does
+    *           nothing if PTS index isn't enabled
+    * @param    [in] pts    PTS of the unit (90 kHz)
+    * @return   void
+    ****************************************************************************
+    */
+    void mark_unit(uint64_t pts);
+
+    /**
+    ****************************************************************************
+    * @brief    Writes buffered data, releases unused preallocated space and
+    *           closes the file
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS close(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Returns output file name
+    * @return   Output file name
+    ****************************************************************************
+    */
+    const char* filename(void) const { return m_filename.c_str(); }
+
+private:
+    /**
+    ****************************************************************************
+    * @brief    Writes buffered data to the file and starts writeback of dirty
+    *           pages each ES_WRITE_BEHIND bytes
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS flush(void);
+
+private:    // Blocked implementations
+    ESWriter();
+    ESWriter(const ESWriter& r);
+    ESWriter& operator= (const ESWriter&);
+
+private:
+    std::string     m_filename;     ///< Output file name
+    int             m_fd;           ///< Output file descriptor
+
+    uint8_t*        m_buffer;       ///< Data collected for next write
+    size_t          m_buffer_size;  ///< Bytes stored in m_buffer
+
+    uint64_t        m_written;      ///< Bytes written to the file
+    uint64_t        m_synced;       ///< Bytes submitted for writeback
+    bool            m_preallocated; ///< File space was reserved
+    bool            m_resume;       ///< Existing file is continued
+    uint64_t        m_resume_index; ///< Size of PTS index to continue
+
+    FILE*           m_pts_index;    ///< PTS index of units, NULL if disabled
+};
+
+#endif  /* !_ES_WRITER_H_ */
@@ -0,0 +1,463 @@
+/**
+********************************************************************************
+* @file         live_server.cpp
+* @brief        Multi-stream live demultiplexing server class implementation
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "live_server.h"
+#include "affinity.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+volatile int LiveServer::s_stop = 0;
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+LiveServer::LiveServer(unsigned threads)
+{
+    if (0 == threads)
+    {
+        threads = 1;
+    }
+
+    for (unsigned i = 0; i < threads; ++i)
+    {
+        worker* w = new worker;
+        w->server   = this;
+        w->epoll_fd = -1;
+        w->status   = STATUS_OK;
+        w->cpu      = -1;
+        w->node     = NUMA_NODE_ANY;
+        m_workers.push_back(w);
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+LiveServer::~LiveServer()
+{
+    for (size_t i = 0; i < m_channels.size(); ++i)
+    {
+        channel* ch = m_channels[i];
+        if (-1 != ch->fd)
+        {
+            close(ch->fd);
+        }
+        delete ch->proc;
+        numa_free(ch->buffer, LIVE_BUFFER_SIZE);
+        delete ch;
+    }
+
+    for (size_t i = 0; i < m_workers.size(); ++i)
+    {
+        if (-1 != m_workers[i]->epoll_fd)
+        {
+            close(m_workers[i]->epoll_fd);
+        }
+        delete m_workers[i];
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void LiveServer::set_affinity(const std::vector<int>& cpus, int node)
+{
+    for (size_t i = 0; i < m_workers.size() && !cpus.empty(); ++i)
+    {
+        worker* w = m_workers[i];
+        w->cpu  = cpus[i % cpus.size()];
+        w->node = (NUMA_NODE_ANY != node) ? node : cpu_numa_node(w->cpu);
+    }
+
+    if (cpus.empty())
+    {
+        for (size_t i = 0; i < m_workers.size(); ++i)
+        {
+            m_workers[i]->node = node;
+        }
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS LiveServer::add_channel(const char* const source,
+    const char* const video, const char* const audio)
+{
+    STATUS result = STATUS_FAIL;
+
+    channel* ch = new channel;
+    ch->source   = source;
+    ch->fd       = -1;
+    ch->datagram = false;
+    ch->proc     = new TSProcessor("", video, audio);
+    ch->proc->enable_lazy();    // Only PIDs with files are demultiplexed
+    ch->buffer   = NULL;
+    ch->bytes    = 0;
+    ch->status   = STATUS_OK;
+    m_channels.push_back(ch);
+
+    /**
+    ****************************************************************************
+    * @note     Channels are distributed between event loops round-robin
+    ****************************************************************************
+    */
+    worker* w = m_workers[(m_channels.size() - 1) % m_workers.size()];
+
+    do
+    {
+        ch->buffer = static_cast<uint8_t*>(numa_alloc(LIVE_BUFFER_SIZE,
+            w->node));
+        if (NULL == ch->buffer)
+        {
+            fprintf(stderr, "Can't allocate buffer for %s\n", source);
+            break;
+        }
+
+        result = ch->proc->init();
+        if (STATUS_OK != result)
+        {
+            break;
+        }
+
+        result = open_source(*ch);
+        if (STATUS_OK != result)
+        {
+            break;
+        }
+
+        w->channels.push_back(ch);
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS LiveServer::open_source(channel& ch)
+{
+    STATUS result = STATUS_FAIL;
+
+    do
+    {
+        if (0 != ch.source.compare(0, 6, "udp://"))
+        {
+            ch.fd = open(ch.source.c_str(), O_RDONLY | O_NONBLOCK);
+            if (-1 == ch.fd)
+            {
+                fprintf(stderr, "Can't open input (%s). Error: %s\n",
+                    ch.source.c_str(), strerror(errno));
+                break;
+            }
+
+            result = STATUS_OK;
+            break;
+        }
+
+        std::string host = ch.source.substr(6);
+        size_t colon = host.rfind(':');
+        if (std::string::npos == colon)
+        {
+            fprintf(stderr, "Port is missing in %s\n", ch.source.c_str());
+            break;
+        }
+        std::string port = host.substr(colon + 1);
+        host.erase(colon);
+
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family   = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+        hints.ai_flags    = AI_PASSIVE;
+
+        struct addrinfo* ai = NULL;
+        int r = getaddrinfo(host.empty() ? NULL : host.c_str(), port.c_str(),
+            &hints, &ai);
+        if (0 != r)
+        {
+            fprintf(stderr, "Can't resolve %s. Error: %s\n", ch.source.c_str(),
+                gai_strerror(r));
+            break;
+        }
+
+        struct sockaddr_in addr;
+        memcpy(&addr, ai->ai_addr, sizeof(addr));
+        freeaddrinfo(ai);
+
+        ch.datagram = true;
+        ch.fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+        if (-1 == ch.fd)
+        {
+            fprintf(stderr, "Can't create socket for %s. Error: %s\n",
+                ch.source.c_str(), strerror(errno));
+            break;
+        }
+
+        int on = 1;
+        setsockopt(ch.fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+        /**
+        ************************************************************************
+        * @note     Large receive buffer survives scheduling delays of the
+        *           event loop. Failure is not critical
+        ************************************************************************
+        */
+        int rcvbuf = 4 * 1024 * 1024;
+        setsockopt(ch.fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+        if (0 != bind(ch.fd, (struct sockaddr*)&addr, sizeof(addr)))
+        {
+            fprintf(stderr, "Can't bind to %s. Error: %s\n", ch.source.c_str(),
+                strerror(errno));
+            break;
+        }
+
+        if (IN_MULTICAST(ntohl(addr.sin_addr.s_addr)))
+        {
+            struct ip_mreq mreq;
+            mreq.imr_multiaddr = addr.sin_addr;
+            mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+            if (0 != setsockopt(ch.fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq,
+                sizeof(mreq)))
+            {
+                fprintf(stderr, "Can't join multicast group %s. Error: %s\n",
+                    ch.source.c_str(), strerror(errno));
+                break;
+            }
+        }
+
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS LiveServer::read_channel(channel& ch)
+{
+    STATUS result = STATUS_OK;
+    size_t size = 0;
+
+    /**
+    ****************************************************************************
+    * @note     Everything available is collected into the buffer first, so
+    *           the demultiplexer runs once per readiness event rather than
+    *           once per datagram. Buffer is limited, so busy channels can't
+    *           starve other channels of the same event loop
+    ****************************************************************************
+    */
+    while (LIVE_BUFFER_SIZE - size >= LIVE_MAX_DATAGRAM)
+    {
+        ssize_t r = read(ch.fd, &ch.buffer[size], (ch.datagram) ?
+            LIVE_MAX_DATAGRAM : LIVE_BUFFER_SIZE - size);
+        if (r > 0)
+        {
+            size += r;
+            continue;
+        }
+
+        if (0 == r && !ch.datagram)
+        {
+            result = STATUS_AGAIN;
+        }
+        else if (-1 == r && EINTR == errno)
+        {
+            continue;
+        }
+        else if (-1 == r && EAGAIN != errno && EWOULDBLOCK != errno)
+        {
+            fprintf(stderr, "Can't read from %s. Error: %s\n",
+                ch.source.c_str(), strerror(errno));
+            result = STATUS_FAIL;
+        }
+        break;
+    }
+
+    if (0 != size)
+    {
+        ch.bytes += size;
+        if (STATUS_OK != ch.proc->process(ch.buffer, size))
+        {
+            fprintf(stderr, "Can't demultiplex %s\n", ch.source.c_str());
+            result = STATUS_FAIL;
+        }
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void* LiveServer::worker_loop(void* arg)
+{
+    worker* w = static_cast<worker*>(arg);
+    size_t active = w->channels.size();
+
+    while (0 != active && !s_stop)
+    {
+        struct epoll_event events[64];
+        int n = epoll_wait(w->epoll_fd, events, 64, LIVE_POLL_TIMEOUT);
+        if (-1 == n)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+            fprintf(stderr, "epoll_wait failed. Error: %s\n", strerror(errno));
+            w->status = STATUS_FAIL;
+            break;
+        }
+
+        for (int i = 0; i < n; ++i)
+        {
+            channel* ch = static_cast<channel*>(events[i].data.ptr);
+            STATUS r = read_channel(*ch);
+            if (STATUS_OK == r)
+            {
+                continue;
+            }
+
+            /**
+            ********************************************************************
+            * @note     Input is closed or broken. Channel leaves the event
+            *           loop, the rest of channels continue
+            ********************************************************************
+            */
+            ch->status = (STATUS_AGAIN == r) ? ch->proc->finish() : r;
+            epoll_ctl(w->epoll_fd, EPOLL_CTL_DEL, ch->fd, NULL);
+            close(ch->fd);
+            ch->fd = -1;
+            active -= 1;
+        }
+    }
+
+    return NULL;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS LiveServer::run()
+{
+    STATUS result = STATUS_OK;
+    size_t started = 0;
+
+    for (; started < m_workers.size(); ++started)
+    {
+        worker* w = m_workers[started];
+        w->epoll_fd = epoll_create1(0);
+        if (-1 == w->epoll_fd)
+        {
+            fprintf(stderr, "Can't create epoll. Error: %s\n", strerror(errno));
+            result = STATUS_FAIL;
+            break;
+        }
+
+        for (size_t i = 0; i < w->channels.size(); ++i)
+        {
+            struct epoll_event ev;
+            ev.events   = EPOLLIN;
+            ev.data.ptr = w->channels[i];
+            if (0 != epoll_ctl(w->epoll_fd, EPOLL_CTL_ADD,
+                w->channels[i]->fd, &ev))
+            {
+                fprintf(stderr, "Can't watch %s. Error: %s\n",
+                    w->channels[i]->source.c_str(), strerror(errno));
+                result = STATUS_FAIL;
+            }
+        }
+
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        if (-1 != w->cpu && STATUS_OK != set_thread_cpu(&attr, w->cpu))
+        {
+            result = STATUS_FAIL;
+        }
+
+        if (STATUS_OK != result ||
+            0 != pthread_create(&w->thread, &attr, worker_loop, w))
+        {
+            fprintf(stderr, "Can't start event loop thread\n");
+            pthread_attr_destroy(&attr);
+            result = STATUS_FAIL;
+            break;
+        }
+        pthread_attr_destroy(&attr);
+    }
+
+    if (STATUS_OK != result)
+    {
+        stop();
+    }
+
+    for (size_t i = 0; i < started; ++i)
+    {
+        pthread_join(m_workers[i]->thread, NULL);
+        if (STATUS_OK != m_workers[i]->status)
+        {
+            result = STATUS_FAIL;
+        }
+    }
+
+    for (size_t i = 0; i < m_channels.size(); ++i)
+    {
+        channel* ch = m_channels[i];
+        fprintf(stdout, "Channel %s: %llu bytes, result: %s\n",
+            ch->source.c_str(), (unsigned long long)ch->bytes,
+            (STATUS_OK == ch->status) ? "success" : "fail");
+        if (STATUS_OK != ch->status)
+        {
+            result = STATUS_FAIL;
+        }
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void LiveServer::stop()
+{
+    s_stop = 1;
+}
@@ -0,0 +1,189 @@
+/**
+********************************************************************************
+* @file         live_server.h
+* @brief        Multi-stream live demultiplexing server class declaration
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _LIVE_SERVER_H_
+#define _LIVE_SERVER_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "ts_processor.h"
+
+/**
+********************************************************************************
+* @def          LIVE_MAX_DATAGRAM
+* @brief        Maximum size of UDP datagram which is expected on input
+********************************************************************************
+*/
+#define LIVE_MAX_DATAGRAM   65536
+
+/**
+********************************************************************************
+* @def          LIVE_BUFFER_SIZE
+* @brief        Size of per-channel buffer (bytes read per readiness event)
+********************************************************************************
+*/
+#define LIVE_BUFFER_SIZE    (LIVE_MAX_DATAGRAM + \
+                            TS_READ_PACKETS * TS_PACKET_SIZE)
+
+/**
+********************************************************************************
+* @def          LIVE_POLL_TIMEOUT
+* @brief        Event loop wake up period (ms) to check for stop request
+********************************************************************************
+*/
+#define LIVE_POLL_TIMEOUT   500
+
+/**
+********************************************************************************
+* @class        LiveServer
+* @brief        Demultiplexes many live inputs (UDP sockets, FIFOs) on a small
+*               fixed set of event loop threads. Channels are distributed
+*               between threads, every thread waits for readiness of its
+*               channels with epoll and feeds available data into the
+*               TSProcessor of the channel
+********************************************************************************
+*/
+class LiveServer
+{
+public:
+    /**
+    ****************************************************************************
+    * @brief    The only allowed constructor for this class
+    * @param    [in] threads    Number of event loop threads
+    ****************************************************************************
+    */
+    explicit LiveServer(unsigned threads);
+
+    ~LiveServer();
+
+    /**
+    ****************************************************************************
+    * @brief    Pins event loop threads to CPUs and places buffers of their
+    *           channels on NUMA node of the CPU. Must be called before
+    *           add_channel()
+    * @param    [in] cpus   CPUs to use, thread N is pinned to CPU N % size
+    * @param    [in] node   NUMA node for all buffers or NUMA_NODE_ANY to use
+    *                       node of the CPU
+    * @return   void
+    ****************************************************************************
+    */
+    void set_affinity(const std::vector<int>& cpus, int node);
+
+    /**
+    ****************************************************************************
+    * @brief    Adds live channel to the server
+    * @param    [in] source Input of the channel: udp://<address>:<port>
+    *                       (multicast group is joined automatically) or path
+    *                       to FIFO
+    * @param    [in] video  Video elementary stream file name
+    * @param    [in] audio  Audio elementary stream file name
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS add_channel(const char* const source, const char* const video,
+        const char* const audio);
+
+    /**
+    ****************************************************************************
+    * @brief    Runs event loops until all inputs are closed or stop() is
+    *           called
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS run(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Requests event loops to finish. Safe to call from signal
+    *           handler
+    * @return   void
+    ****************************************************************************
+    */
+    static void stop(void);
+
+private:
+    /**
+    ****************************************************************************
+    * @struct   channel
+    * @brief    Single live input with its own demultiplexer
+    ****************************************************************************
+    */
+    struct channel
+    {
+        std::string     source;     ///< Input description
+        int             fd;         ///< Input file descriptor
+        bool            datagram;   ///< Input is UDP socket
+        TSProcessor*    proc;       ///< Demultiplexer of the channel
+        uint8_t*        buffer;     ///< Read buffer
+        uint64_t        bytes;      ///< Number of bytes received
+        STATUS          status;     ///< Result of the channel processing
+    };
+
+    /**
+    ****************************************************************************
+    * @struct   worker
+    * @brief    Event loop thread and channels it serves
+    ****************************************************************************
+    */
+    struct worker
+    {
+        LiveServer*             server;     ///< Owner of the worker
+        pthread_t               thread;     ///< Event loop thread
+        int                     epoll_fd;   ///< Readiness notifications
+        std::vector<channel*>   channels;   ///< Channels of the worker
+        STATUS                  status;     ///< Result of the event loop
+        int                     cpu;        ///< CPU of the thread or -1
+        int                     node;       ///< NUMA node for channel buffers
+    };
+
+    /**
+    ****************************************************************************
+    * @brief    Opens input of the channel in non-blocking mode
+    * @param    [in,out] ch Channel to open
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    static STATUS open_source(channel& ch);
+
+    /**
+    ****************************************************************************
+    * @brief    Reads everything available on the channel input and feeds it
+    *           to the demultiplexer
+    * @param    [in,out] ch Channel to read
+    * @return   STATUS_OK if input is still open, STATUS_AGAIN if input is
+    *           closed, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    static STATUS read_channel(channel& ch);
+
+    /**
+    ****************************************************************************
+    * @brief    Event loop of single worker thread
+    * @param    [in] arg    Pointer to worker structure
+    * @return   NULL
+    ****************************************************************************
+    */
+    static void* worker_loop(void* arg);
+
+private:    // Blocked implementations
+    LiveServer();
+    LiveServer(const LiveServer& r);
+    LiveServer& operator= (const LiveServer&);
+
+private:
+    std::vector<worker*>    m_workers;  ///< Event loop threads
+    std::vector<channel*>   m_channels; ///< All channels of the server
+
+    static volatile int     s_stop;     ///< Stop request flag
+};
+
+#endif  /* !_LIVE_SERVER_H_ */
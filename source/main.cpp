@@ -13,8 +13,22 @@
 #include <limits.h>
 #include <memory.h>
 #include <argp.h>
+#include <signal.h>
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
 
 #include "ts_processor.h"
+#include "live_server.h"
+#include "affinity.h"
+#include "stream_select.h"
+#include "ts_probe.h"
+#include "ts_duration.h"
+#include "ts_catalog.h"
+#include "ts_checkpoint.h"
+#include "ts_merge.h"
+#include "pcap_input.h"
 
 /**
 ********************************************************************************
@@ -28,8 +42,46 @@ struct CmdParams
     char v_file[PATH_MAX];  ///< Output Video file
     char a_file[PATH_MAX];  ///< Output Audio file
 
+    std::vector<std::string> live;  ///< Live channels <input>,<video>,<audio>
+    unsigned threads;               ///< Number of live event loop threads
+
+    std::vector<int> cpus;          ///< CPUs to pin processing threads to
+    int numa_node;                  ///< NUMA node for buffers
+
+    std::string ts_output;          ///< Output of unmodified TS packets
+    std::string udp_output;         ///< Paced UDP output of the same packets
+
+    std::vector<select_rule> select; ///< ES selection rules
+    std::string cues;               ///< Output SCTE-35 cue list
+    std::string si;                 ///< Output DVB SI log
+    bool analyze;                   ///< Run TR 101 290 checks
+    uint64_t probe;                 ///< Probe byte limit, 0 - no probe
+    size_t duration;                ///< Duration window, 0 - no estimation
+    std::string catalog;            ///< Keyframe catalog of inputs
+    std::string lookup;             ///< Catalog lookup <file>@<seconds>
+    std::vector<std::string> inputs; ///< All positional arguments
+    std::string checkpoint;         ///< Checkpoint of file demux
+    uint64_t checkpoint_interval;   ///< Input bytes between checkpoints
+    bool resume;                    ///< Continue job of the checkpoint
+    std::string merge;              ///< Backup input merged with the input
+    std::string backup;             ///< Backup input switched to on errors
+    bool pcap;                      ///< Input is pcap/pcapng capture
+    pcap_filter pcap_dest;          ///< Datagrams taken from capture
+    bool playlist;                  ///< Input is list of segment files
+
     CmdParams()
+        : threads(1)
+        , numa_node(NUMA_NODE_ANY)
+        , analyze(false)
+        , probe(0)
+        , duration(0)
+        , checkpoint_interval(CHECKPOINT_INTERVAL)
+        , resume(false)
+        , pcap(false)
+        , playlist(false)
     {
+        pcap_dest.address = 0;
+        pcap_dest.port    = 0;
         memset(i_file, 0, PATH_MAX * sizeof(char));
         memset(v_file, 0, PATH_MAX * sizeof(char));
         memset(a_file, 0, PATH_MAX * sizeof(char));
@@ -43,7 +95,20 @@ const char* argp_program_version = VERSION; ///< ARGP version place holder
 * @brief        Mandatory application arguments
 ********************************************************************************
 */
-static char s_args_str[] = "<input_ts> <output_video> <output_audio>";
+static char s_args_str[] = "<input_ts> <output_video> <output_audio>\n"
+                           "-s RULE [-s RULE...] <input_ts>\n"
+                           "-a <input_ts>\n"
+                           "-p <input_ts>\n"
+                           "-d <input_ts>\n"
+                           "-x CATALOG [-t NUM] <input_ts>...\n"
+                           "-x CATALOG -L <input_ts>@<seconds>\n"
+                           "-m <backup_ts> <input_ts> <output_video> "
+                           "<output_audio>\n"
+                           "-b <backup_ts> -o <output_ts> <input_ts>\n"
+                           "-u udp://ADDR:PORT <input_ts>\n"
+                           "-P DEST <input_pcap> <output_video> "
+                           "<output_audio>\n"
+                           "-M <input_m3u8> <output_video> <output_audio>";
 
 /**
 ********************************************************************************
@@ -52,7 +117,13 @@ static char s_args_str[] = "<input_ts> <output_video> <output_audio>";
 */
 static char s_info_str[] = "Primitive MPEG-TS demuxer\v"
                         "In order to run tool execute:\n\t"
-                        "ts-proc in.ts video.file audio.file";
+                        "ts-proc in.ts video.file audio.file\n"
+                        "In order to select streams by rules execute:\n\t"
+                        "ts-proc -s \"audio:lang=eng,codec=aac -> "
+                        "out_%pid%.aac\" in.ts\n"
+                        "In order to demux live inputs execute:\n\t"
+                        "ts-proc -t 2 -l udp://239.0.0.1:1234,v1.264,a1.aac "
+                        "-l /tmp/fifo,v2.264,a2.aac";
 
 /**
 ********************************************************************************
@@ -68,6 +139,59 @@ const char* argp_program_bug_address = "Maksym Koshel (maks.koshel@gmail.com)";
 */
 static struct argp_option s_cmd_options[] =
 {
+    { "live", 'l', "IN,VIDEO,AUDIO", 0, "Demux live input (udp://addr:port "
+        "or FIFO) into video and audio files. May be repeated", 0 },
+    { "threads", 't', "NUM", 0, "Number of event loop threads serving live "
+        "inputs (default: 1)", 0 },
+    { "cpus", 'c', "LIST", 0, "Pin processing to CPUs (e.g. 0-3,8). Live event "
+        "loop thread N is pinned to N-th CPU of the list", 0 },
+    { "numa-node", 'n', "NODE", 0, "Allocate buffers on NUMA node (default: "
+        "node of the pinned CPU)", 0 },
+    { "ts-output", 'o', "FILE", 0, "Write unmodified TS packets of PAT, PMT, "
+        "video and audio PIDs to FILE", 0 },
+    { "udp-output", 'u', "URL", 0, "Send the same packets as -o to "
+        "udp://ADDR:PORT in real time, paced by PCR", 0 },
+    { "select", 's', "RULE", 0, "Write streams matched by RULE "
+        "(KIND[:lang=L,codec=C,pid=P,type=T] -> FILE) to FILE. KIND is video, "
+        "audio, subtitle, teletext, data or any. FILE may contain %pid%, "
+        "%lang%, %codec% and %kind%. May be repeated", 0 },
+    { "subtitles", 'S', "PREFIX", 0, "Write DVB subtitle and teletext "
+        "streams to PREFIX_<pid>_<lang>.dvbsub/.ttx with PTS index "
+        "(.pts) next to each", 0 },
+    { "cues", 'C', "FILE", 0, "Write SCTE-35 splice commands with their "
+        "PTS and time from the start of the stream to FILE", 0 },
+    { "si", 'i', "FILE", 0, "Write DVB SI tables (SDT, EIT present/following, "
+        "NIT, TDT/TOT) to FILE, each table version once", 0 },
+    { "analyze", 'a', 0, 0, "Run TR 101 290 priority 1 and 2 checks and "
+        "print error counters. Packets with wrong sync byte are skipped", 0 },
+    { "probe", 'p', "MB", OPTION_ARG_OPTIONAL, "Read only the head of the "
+        "input (at most MB megabytes, default: 32) until PSI, SDT and the "
+        "first headers of video and audio are found, print them as JSON", 0 },
+    { "duration", 'd', "MB", OPTION_ARG_OPTIONAL, "Estimate duration and "
+        "bitrate by PCRs (or PTSs) of the first and the last MB megabytes "
+        "of the input (default: 1)", 0 },
+    { "catalog", 'x', "FILE", 0, "Build keyframe index of all inputs on "
+        "-t threads into single catalog FILE", 0 },
+    { "lookup", 'L', "INPUT@SEC", 0, "Find keyframe at or before SEC seconds "
+        "from the start of INPUT in catalog given by -x", 0 },
+    { "checkpoint", 'k', "FILE", 0, "Save input position and output sizes "
+        "of file demux to FILE periodically, FILE is removed on success", 0 },
+    { "checkpoint-interval", 'K', "MB", 0, "Input megabytes between "
+        "checkpoints (default: 1024)", 0 },
+    { "resume", 'r', 0, 0, "Continue interrupted demux from the checkpoint "
+        "given by -k, outputs are truncated to checkpointed sizes", 0 },
+    { "merge", 'm', "BACKUP", 0, "Merge redundant BACKUP copy of the input "
+        "into the same video and audio files, PES present in both inputs "
+        "are written once", 0 },
+    { "backup", 'b', "BACKUP", 0, "Read the input together with its "
+        "redundant BACKUP copy aligned by PCR, segments of the input with "
+        "CC errors or gaps are taken from BACKUP", 0 },
+    { "pcap", 'P', "DEST", 0, "Input is pcap/pcapng capture, TS packets are "
+        "taken from UDP (RTP) datagrams sent to DEST (ADDR:PORT, ADDR, :PORT "
+        "or any)", 0 },
+    { "playlist", 'M', 0, 0, "Input is m3u8 playlist (or list of TS files, "
+        "one per line), its segments are demultiplexed as one stream. "
+        "AES-128 segments with local keys are decrypted", 0 },
     { 0, 0, 0, 0, 0, 0 }
 };
 
@@ -89,9 +213,281 @@ static error_t cmd_parse_handler(int key, char* const arg,
 
     switch(key)
     {
+        case 'l':
+        {
+            cmd->live.push_back(arg);
+            break;
+        }
+
+        case 't':
+        {
+            cmd->threads = strtoul(arg, NULL, 10);
+            if (0 == cmd->threads)
+            {
+                argp_error(state, "Wrong number of threads: %s", arg);
+            }
+            break;
+        }
+
+        case 'c':
+        {
+            if (STATUS_OK != parse_cpu_list(arg, cmd->cpus))
+            {
+                argp_error(state, "Wrong list of CPUs: %s", arg);
+            }
+            break;
+        }
+
+        case 'n':
+        {
+            char* end = NULL;
+            cmd->numa_node = strtol(arg, &end, 10);
+            if (end == arg || '\0' != *end || cmd->numa_node < 0)
+            {
+                argp_error(state, "Wrong NUMA node: %s", arg);
+            }
+            break;
+        }
+
+        case 'o':
+        {
+            cmd->ts_output = arg;
+            break;
+        }
+
+        case 'u':
+        {
+            cmd->udp_output = arg;
+            break;
+        }
+
+        case 's':
+        {
+            select_rule rule;
+            if (STATUS_OK != parse_select_rule(arg, rule))
+            {
+                argp_error(state, "Wrong selection rule: %s", arg);
+            }
+            cmd->select.push_back(rule);
+            break;
+        }
+
+        case 'S':
+        {
+            // Shortcut for two selection rules
+            const char* rules[] = { "subtitle -> %s_%%pid%%_%%lang%%.dvbsub",
+                "teletext -> %s_%%pid%%_%%lang%%.ttx" };
+            for (size_t i = 0; i < sizeof(rules) / sizeof(rules[0]); ++i)
+            {
+                char text[PATH_MAX + 64];
+                snprintf(text, sizeof(text), rules[i], arg);
+                select_rule rule;
+                if (STATUS_OK != parse_select_rule(text, rule))
+                {
+                    argp_error(state, "Wrong subtitles prefix: %s", arg);
+                }
+                cmd->select.push_back(rule);
+            }
+            break;
+        }
+
+        case 'C':
+        {
+            cmd->cues = arg;
+            break;
+        }
+
+        case 'i':
+        {
+            cmd->si = arg;
+            break;
+        }
+
+        case 'a':
+        {
+            cmd->analyze = true;
+            break;
+        }
+
+        case 'p':
+        {
+            cmd->probe = PROBE_DEFAULT_LIMIT;
+            if (NULL != arg)
+            {
+                char* end = NULL;
+                cmd->probe = strtoull(arg, &end, 10) * 1024 * 1024;
+                if (end == arg || '\0' != *end || 0 == cmd->probe)
+                {
+                    argp_error(state, "Wrong probe limit: %s", arg);
+                }
+            }
+            break;
+        }
+
+        case 'd':
+        {
+            cmd->duration = DURATION_WINDOW;
+            if (NULL != arg)
+            {
+                char* end = NULL;
+                cmd->duration = strtoul(arg, &end, 10) * 1024 * 1024;
+                if (end == arg || '\0' != *end || 0 == cmd->duration)
+                {
+                    argp_error(state, "Wrong duration window: %s", arg);
+                }
+            }
+            break;
+        }
+
+        case 'x':
+        {
+            cmd->catalog = arg;
+            break;
+        }
+
+        case 'L':
+        {
+            cmd->lookup = arg;
+            break;
+        }
+
+        case 'k':
+        {
+            cmd->checkpoint = arg;
+            break;
+        }
+
+        case 'K':
+        {
+            char* end = NULL;
+            cmd->checkpoint_interval = strtoull(arg, &end, 10) * 1024 * 1024;
+            if (end == arg || '\0' != *end || 0 == cmd->checkpoint_interval)
+            {
+                argp_error(state, "Wrong checkpoint interval: %s", arg);
+            }
+            break;
+        }
+
+        case 'r':
+        {
+            cmd->resume = true;
+            break;
+        }
+
+        case 'm':
+        {
+            cmd->merge = arg;
+            break;
+        }
+
+        case 'b':
+        {
+            cmd->backup = arg;
+            break;
+        }
+
+        case 'P':
+        {
+            if (STATUS_OK != parse_pcap_filter(arg, cmd->pcap_dest))
+            {
+                argp_error(state, "Wrong capture destination: %s", arg);
+            }
+            cmd->pcap = true;
+            break;
+        }
+
+        case 'M':
+        {
+            cmd->playlist = true;
+            break;
+        }
+
         case ARGP_KEY_END:
         {
-            if (c < 3)
+            if (cmd->resume && cmd->checkpoint.empty())
+            {
+                argp_error(state, "Resume requires checkpoint (-k)");
+            }
+
+            // Only ES outputs are continued, other outputs keep own state
+            if (!cmd->checkpoint.empty() && (!cmd->live.empty() ||
+                !cmd->ts_output.empty() || !cmd->udp_output.empty() ||
+                !cmd->cues.empty() || !cmd->si.empty() || cmd->analyze ||
+                0 != cmd->probe || 0 != cmd->duration ||
+                !cmd->catalog.empty()))
+            {
+                argp_error(state, "Checkpoint is supported only by demux of "
+                    "file into ES outputs");
+            }
+
+            if (!cmd->merge.empty() && (!cmd->live.empty() ||
+                !cmd->select.empty() || !cmd->ts_output.empty() ||
+                !cmd->udp_output.empty() || !cmd->cues.empty() ||
+                !cmd->si.empty() || cmd->analyze || 0 != cmd->probe ||
+                0 != cmd->duration || !cmd->catalog.empty() ||
+                !cmd->checkpoint.empty()))
+            {
+                argp_error(state, "Merge supports only video and audio "
+                    "outputs");
+            }
+
+            if (!cmd->backup.empty() && (!cmd->live.empty() ||
+                0 != cmd->probe || 0 != cmd->duration ||
+                !cmd->catalog.empty() || !cmd->checkpoint.empty() ||
+                !cmd->merge.empty()))
+            {
+                argp_error(state, "Backup is supported only by demux of "
+                    "file");
+            }
+
+            if (cmd->pcap && (!cmd->live.empty() || 0 != cmd->probe ||
+                0 != cmd->duration || !cmd->catalog.empty() ||
+                !cmd->checkpoint.empty() || !cmd->merge.empty() ||
+                !cmd->backup.empty()))
+            {
+                argp_error(state, "Capture is supported only by demux of "
+                    "file");
+            }
+
+            if (cmd->playlist && (!cmd->live.empty() || 0 != cmd->probe ||
+                0 != cmd->duration || !cmd->catalog.empty() ||
+                !cmd->checkpoint.empty() || !cmd->merge.empty() ||
+                !cmd->backup.empty() || cmd->pcap))
+            {
+                argp_error(state, "Playlist is supported only by demux of "
+                    "file");
+            }
+
+            if (!cmd->udp_output.empty() && (!cmd->live.empty() ||
+                0 != cmd->probe || 0 != cmd->duration ||
+                !cmd->catalog.empty()))
+            {
+                argp_error(state, "UDP output is supported only by demux of "
+                    "file");
+            }
+
+            // Catalog is built of any number of inputs or only looked up
+            if (!cmd->catalog.empty())
+            {
+                if (cmd->inputs.empty() == cmd->lookup.empty())
+                {
+                    argp_usage(state);
+                }
+                break;
+            }
+
+            if (!cmd->lookup.empty())
+            {
+                argp_error(state, "Lookup requires catalog (-x)");
+            }
+
+            // Output files are optional if streams are selected by rules,
+            // the stream is only analyzed, probed, measured, cleaned or played
+            if (c < 3 && (0 != c || cmd->live.empty()) &&
+                (1 != c || (cmd->select.empty() && !cmd->analyze &&
+                0 == cmd->probe && 0 == cmd->duration &&
+                cmd->udp_output.empty() &&
+                (cmd->backup.empty() || cmd->ts_output.empty()))))
             {
                 argp_usage(state); ///< @note This function calls exit inside
             }
@@ -99,6 +495,11 @@ static error_t cmd_parse_handler(int key, char* const arg,
         }
 
         default:
+            if (0 == key)
+            {
+                cmd->inputs.push_back(arg);
+            }
+
             if (0 == key && c == 0)
             {
                 strncpy(cmd->i_file, arg, PATH_MAX - 1);
@@ -140,6 +541,132 @@ static struct argp argp_controls =
     .argp_domain    = NULL
 };
 
+/**
+********************************************************************************
+* @brief        Stops live processing on SIGINT/SIGTERM
+* @param        [in] sig    Signal number
+* @return       void
+********************************************************************************
+*/
+static void stop_handler(int sig)
+{
+    (void)sig;
+    LiveServer::stop();
+}
+
+/**
+********************************************************************************
+* @brief        Runs live demultiplexing of all channels given in command line
+* @param        [in] cmd    Command line arguments
+* @return       STATUS_OK on success, STATUS_FAIL - otherwise
+********************************************************************************
+*/
+static STATUS run_live(const CmdParams& cmd)
+{
+    STATUS result = STATUS_OK;
+    LiveServer server(cmd.threads);
+    server.set_affinity(cmd.cpus, cmd.numa_node);
+
+    for (size_t i = 0; i < cmd.live.size() && STATUS_OK == result; ++i)
+    {
+        std::string spec = cmd.live[i];
+        size_t a = spec.find(',');
+        size_t b = (std::string::npos == a) ? a : spec.find(',', a + 1);
+        if (std::string::npos == b)
+        {
+            fprintf(stderr, "Wrong live channel (%s). Expected: "
+                "<input>,<video>,<audio>\n", spec.c_str());
+            result = STATUS_FAIL;
+            break;
+        }
+
+        result = server.add_channel(spec.substr(0, a).c_str(),
+            spec.substr(a + 1, b - a - 1).c_str(), spec.substr(b + 1).c_str());
+    }
+
+    if (STATUS_OK == result)
+    {
+        signal(SIGINT, stop_handler);
+        signal(SIGTERM, stop_handler);
+        result = server.run();
+    }
+
+    return result;
+}
+
+/**
+********************************************************************************
+* @brief        Builds keyframe catalog of all inputs given in command line
+* @param        [in] cmd    Command line arguments
+* @return       STATUS_OK on success, STATUS_FAIL - otherwise
+********************************************************************************
+*/
+static STATUS build_catalog(const CmdParams& cmd)
+{
+    CatalogBuilder builder(cmd.catalog.c_str(), cmd.threads);
+    for (size_t i = 0; i < cmd.inputs.size(); ++i)
+    {
+        builder.add_file(cmd.inputs[i].c_str());
+    }
+
+    return builder.run();
+}
+
+/**
+********************************************************************************
+* @brief        Finds keyframe of the input in the catalog
+* @param        [in] cmd    Command line arguments
+* @return       STATUS_OK if keyframe is found, STATUS_FAIL - otherwise
+********************************************************************************
+*/
+static STATUS lookup_catalog(const CmdParams& cmd)
+{
+    STATUS result = STATUS_FAIL;
+    TSCatalog catalog;
+
+    do
+    {
+        size_t at = cmd.lookup.rfind('@');
+        char* end = NULL;
+        double seconds = (std::string::npos == at) ? -1 :
+            strtod(cmd.lookup.c_str() + at + 1, &end);
+        if (seconds < 0 || '\0' != *end)
+        {
+            fprintf(stderr, "Wrong lookup (%s). Expected: <input>@<seconds>\n",
+                cmd.lookup.c_str());
+            break;
+        }
+
+        if (STATUS_OK != catalog.open(cmd.catalog.c_str()))
+        {
+            break;
+        }
+
+        std::string name = cmd.lookup.substr(0, at);
+        int n = catalog.find_file(name.c_str());
+        if (n < 0 || 0 == catalog.file(n).index_count)
+        {
+            fprintf(stderr, "%s isn't indexed in %s\n", name.c_str(),
+                cmd.catalog.c_str());
+            break;
+        }
+
+        // Time is counted from the first keyframe
+        uint64_t start = catalog.keyframes(n)[0].pts;
+        const struct catalog_keyframe* key = catalog.find_keyframe(n,
+            start + (uint64_t)(seconds * 90000));
+        fprintf(stdout, "Keyframe of %s at %.3f s:\n"
+            "\tPTS:    %llu (%.3f s)\n"
+            "\tOffset: %llu\n", name.c_str(), seconds,
+            (unsigned long long)key->pts, (key->pts - start) / 90000.0,
+            (unsigned long long)key->offset);
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
 int main(int argc, char* argv[])
 {
     CmdParams cmd;
@@ -155,7 +682,125 @@ int main(int argc, char* argv[])
             break;
         }
 
+        if (!cmd.live.empty())
+        {
+            result = run_live(cmd);
+            break;
+        }
+
+        if (0 != cmd.probe)
+        {
+            TSProbe probe(cmd.i_file, cmd.probe);
+            result = probe.run();
+            if (STATUS_OK == result)
+            {
+                probe.print_json(stdout);
+            }
+            break;
+        }
+
+        if (!cmd.catalog.empty())
+        {
+            result = cmd.lookup.empty() ? build_catalog(cmd) :
+                lookup_catalog(cmd);
+            break;
+        }
+
+        if (0 != cmd.duration)
+        {
+            struct ts_duration duration;
+            result = estimate_duration(cmd.i_file, cmd.duration, duration);
+            if (STATUS_OK == result)
+            {
+                fprintf(stdout, "Duration estimated:\n"
+                    "\tDuration: %.3f s (%s of PID %u)\n"
+                    "\tBitrate:  %llu bit/s\n",
+                    duration.duration, duration.by_pcr ? "PCR" : "PTS",
+                    duration.pid, (unsigned long long)duration.bitrate);
+            }
+            break;
+        }
+
+        if (!cmd.merge.empty())
+        {
+            TSMerger merger(cmd.i_file, cmd.merge.c_str(), cmd.v_file,
+                cmd.a_file);
+            result = merger.init();
+            if (STATUS_OK == result)
+            {
+                result = merger.run();
+            }
+            break;
+        }
+
         TSProcessor proc(cmd.i_file, cmd.v_file, cmd.a_file);
+        if (!cmd.cpus.empty())
+        {
+            result = pin_current_thread(cmd.cpus);
+            if (STATUS_OK != result)
+            {
+                break;
+            }
+        }
+
+        proc.set_numa_node((NUMA_NODE_ANY != cmd.numa_node || cmd.cpus.empty())
+            ? cmd.numa_node : cpu_numa_node(cmd.cpus[0]));
+        if (!cmd.ts_output.empty())
+        {
+            proc.set_ts_output(cmd.ts_output.c_str());
+        }
+
+        if (!cmd.udp_output.empty())
+        {
+            proc.set_udp_output(cmd.udp_output.c_str());
+        }
+
+        if (!cmd.cues.empty())
+        {
+            proc.set_cue_output(cmd.cues.c_str());
+        }
+
+        if (!cmd.si.empty())
+        {
+            proc.set_si_output(cmd.si.c_str());
+        }
+
+        if (cmd.analyze)
+        {
+            proc.enable_analysis();
+        }
+
+        for (size_t i = 0; i < cmd.select.size(); ++i)
+        {
+            proc.add_select(cmd.select[i]);
+        }
+
+        if (!cmd.checkpoint.empty())
+        {
+            proc.set_checkpoint(cmd.checkpoint.c_str(),
+                cmd.checkpoint_interval);
+        }
+
+        if (cmd.resume)
+        {
+            proc.enable_resume();
+        }
+
+        if (!cmd.backup.empty())
+        {
+            proc.set_backup(cmd.backup.c_str());
+        }
+
+        if (cmd.pcap)
+        {
+            proc.set_pcap(cmd.pcap_dest);
+        }
+
+        if (cmd.playlist)
+        {
+            proc.set_playlist();
+        }
+
         result = proc.init();
         if (STATUS_OK != result)
         {
@@ -170,8 +815,13 @@ int main(int argc, char* argv[])
 
     } while(0);
     
-    fprintf(stdout, "Processing of MPEG-TS file (%s) done with result: %s\n",
-        argv[1], (STATUS_OK == result) ? "success" : "fail");
+    // Probe prints JSON only to stdout
+    fprintf((0 != cmd.probe) ? stderr : stdout,
+        "Processing of MPEG-TS %s (%s) done with result: %s\n",
+        (!cmd.live.empty()) ? "live inputs" : (!cmd.catalog.empty()) ?
+        "catalog" : "file", (!cmd.live.empty()) ? "" :
+        (!cmd.catalog.empty()) ? cmd.catalog.c_str() : cmd.i_file,
+        (STATUS_OK == result) ? "success" : "fail");
 
     return result;
 }
\ No newline at end of file
@@ -0,0 +1,642 @@
+/**
+********************************************************************************
+* @file         pcap_input.cpp
+* @brief        MPEG-TS input from pcap/pcapng captures of UDP (RTP) streams
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "pcap_input.h"
+#include "ts_cursor.h"
+
+#include <arpa/inet.h>
+#include <byteswap.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+********************************************************************************
+* @brief        Magic numbers of capture formats (as read in host order)
+********************************************************************************
+*/
+#define PCAP_MAGIC_USEC     0xa1b2c3d4
+#define PCAP_MAGIC_NSEC     0xa1b23c4d
+#define PCAPNG_SHB          0x0a0d0d0a
+#define PCAPNG_BYTE_ORDER   0x1a2b3c4d
+
+/**
+********************************************************************************
+* @brief        Sizes of capture headers
+********************************************************************************
+*/
+#define PCAP_FILE_HEADER    24
+#define PCAP_RECORD_HEADER  16
+#define PCAPNG_BLOCK_MIN    12
+
+/**
+********************************************************************************
+* @brief        pcapng block types
+********************************************************************************
+*/
+#define PCAPNG_IDB          0x00000001
+#define PCAPNG_SPB          0x00000003
+#define PCAPNG_EPB          0x00000006
+
+/**
+********************************************************************************
+* @brief        Link types of captured frames
+********************************************************************************
+*/
+#define LINKTYPE_NULL       0       ///< BSD loopback, family in host order
+#define LINKTYPE_ETHERNET   1
+#define LINKTYPE_RAW        101     ///< IPv4 or IPv6 without link header
+#define LINKTYPE_LOOP       108     ///< OpenBSD loopback, family in BE
+#define LINKTYPE_LINUX_SLL  113     ///< Linux cooked capture
+#define LINKTYPE_IPV4       228
+#define LINKTYPE_LINUX_SLL2 276     ///< Linux cooked capture v2
+
+/**
+********************************************************************************
+* @brief        Network header fields (offset from header start)
+********************************************************************************
+*/
+typedef bit_field<12, 0, 16> eth_type;
+typedef bit_field<0, 0, 16>  vlan_inner_type;
+typedef bit_field<14, 0, 16> sll_protocol;
+typedef bit_field<0, 0, 16>  sll2_protocol;
+typedef bit_field<0, 0, 4>   ip_version;
+typedef bit_field<0, 4, 4>   ip_ihl;
+typedef bit_field<2, 0, 16>  ip_total_length;
+typedef bit_field<6, 2, 1>   ip_more_fragments;
+typedef bit_field<6, 3, 13>  ip_fragment_offset;
+typedef bit_field<9, 0, 8>   ip_protocol;
+typedef bit_field<16, 0, 32> ip_destination;
+typedef bit_field<2, 0, 16>  udp_destination;
+typedef bit_field<4, 0, 16>  udp_length;
+typedef bit_field<0, 0, 2>   rtp_version;
+typedef bit_field<0, 2, 1>   rtp_padding;
+typedef bit_field<0, 3, 1>   rtp_extension;
+typedef bit_field<0, 4, 4>   rtp_csrc_count;
+
+/**
+********************************************************************************
+* @brief        Finds IPv4 header behind link header of the frame
+* @param        [in] cur        Cursor at the beginning of the frame
+* @param        [in] linktype   Link type of the frame
+* @return       true if the frame carries IPv4, cursor is moved to IP header
+********************************************************************************
+*/
+static bool skip_link_header(TSCursor& cur, uint32_t linktype)
+{
+    bool result = false;
+
+    switch (linktype)
+    {
+        case LINKTYPE_ETHERNET:
+        {
+            if (!cur.require(14))
+            {
+                break;
+            }
+
+            // 802.1Q and 802.1ad tags may be stacked
+            uint32_t type = cur.get<eth_type>();
+            cur.skip(12);
+            while ((0x8100 == type || 0x88a8 == type) && cur.require(6))
+            {
+                cur.skip(4);
+                type = cur.get<vlan_inner_type>();
+            }
+
+            result = (0x0800 == type && cur.require(2));
+            if (result)
+            {
+                cur.skip(2);
+            }
+            break;
+        }
+
+        case LINKTYPE_LINUX_SLL:
+        {
+            result = cur.require(16) && 0x0800 == cur.get<sll_protocol>();
+            if (result)
+            {
+                cur.skip(16);
+            }
+            break;
+        }
+
+        case LINKTYPE_LINUX_SLL2:
+        {
+            result = cur.require(20) && 0x0800 == cur.get<sll2_protocol>();
+            if (result)
+            {
+                cur.skip(20);
+            }
+            break;
+        }
+
+        case LINKTYPE_NULL:
+        case LINKTYPE_LOOP:
+        {
+            // Byte order of the family is unknown, AF_INET is 2 everywhere
+            uint32_t family = cur.require(4) ?
+                cur.get<bit_field<0, 0, 32> >() : 0;
+            result = (0x00000002 == family || 0x02000000 == family);
+            if (result)
+            {
+                cur.skip(4);
+            }
+            break;
+        }
+
+        case LINKTYPE_RAW:
+        case LINKTYPE_IPV4:
+        {
+            result = true;
+            break;
+        }
+
+        default:
+            break;
+    }
+
+    return result && cur.require(1) && 4 == cur.get<ip_version>();
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS parse_pcap_filter(const char* text, struct pcap_filter& filter)
+{
+    STATUS result = STATUS_FAIL;
+
+    do
+    {
+        filter.address = 0;
+        filter.port    = 0;
+
+        std::string s(text);
+        if ("any" == s)
+        {
+            result = STATUS_OK;
+            break;
+        }
+
+        size_t colon = s.rfind(':');
+        std::string address = s.substr(0, colon);
+        if (!address.empty())
+        {
+            struct in_addr addr;
+            if (1 != inet_pton(AF_INET, address.c_str(), &addr))
+            {
+                break;
+            }
+            filter.address = ntohl(addr.s_addr);
+        }
+
+        if (std::string::npos != colon)
+        {
+            char* end = NULL;
+            unsigned long port = strtoul(s.c_str() + colon + 1, &end, 10);
+            if (0 == port || 0xffff < port || '\0' != *end)
+            {
+                break;
+            }
+            filter.port = port;
+        }
+
+        result = (0 != filter.address || 0 != filter.port) ? STATUS_OK :
+            STATUS_FAIL;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+PcapInput::PcapInput(int fd, const char* const filename,
+    const struct pcap_filter& filter)
+    : m_fd(fd)
+    , m_filename(filename)
+    , m_filter(filter)
+    , m_data(NULL)
+    , m_size(0)
+    , m_pos(0)
+    , m_ng(false)
+    , m_swap(false)
+    , m_linktype(0)
+    , m_frames(0)
+    , m_datagrams(0)
+    , m_rtp(0)
+    , m_skipped(0)
+{
+
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+PcapInput::~PcapInput()
+{
+    // Capture file belongs to the caller
+    if (NULL != m_data)
+    {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+        m_data = NULL;
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS PcapInput::init()
+{
+    STATUS result = STATUS_FAIL;
+
+    do
+    {
+        struct stat st;
+        if (0 != fstat(m_fd, &st))
+        {
+            fprintf(stderr, "Can't stat capture file (%s). Error: %s\n",
+                m_filename.c_str(), strerror(errno));
+            break;
+        }
+
+        m_size = st.st_size;
+        if (m_size < PCAPNG_BLOCK_MIN)
+        {
+            fprintf(stderr, "Wrong capture file (%s)\n", m_filename.c_str());
+            break;
+        }
+
+        void* data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+        if (MAP_FAILED == data)
+        {
+            fprintf(stderr, "Can't map capture file (%s). Error: %s\n",
+                m_filename.c_str(), strerror(errno));
+            break;
+        }
+        m_data = static_cast<const uint8_t*>(data);
+
+        // Capture is read once from start to end
+        madvise(data, m_size, MADV_SEQUENTIAL);
+
+        /**
+        ************************************************************************
+        * @note     pcapng starts with section header block, its byte order is
+        *           taken with the block. pcap starts with magic number written
+        *           in byte order of the capturing host
+        ************************************************************************
+        */
+        uint32_t magic = 0;
+        memcpy(&magic, m_data, sizeof(magic));
+        if (PCAPNG_SHB == magic)
+        {
+            m_ng = true;
+            result = STATUS_OK;
+            break;
+        }
+
+        m_swap = (bswap_32(PCAP_MAGIC_USEC) == magic ||
+            bswap_32(PCAP_MAGIC_NSEC) == magic);
+        if (m_size < PCAP_FILE_HEADER || (!m_swap &&
+            PCAP_MAGIC_USEC != magic && PCAP_MAGIC_NSEC != magic))
+        {
+            fprintf(stderr, "%s isn't pcap or pcapng capture\n",
+                m_filename.c_str());
+            break;
+        }
+
+        // Upper bits of link type field carry FCS length
+        m_linktype = load32(&m_data[20]) & 0xffff;
+        m_pos = PCAP_FILE_HEADER;
+        result = STATUS_OK;
+
+    } while(0);
+
+    if (STATUS_OK == result)
+    {
+        struct in_addr addr;
+        addr.s_addr = htonl(m_filter.address);
+        fprintf(stdout, "PcapInput initialized:\n"
+                        "\tCapture: %s (%s)\n"
+                        "\tDestination: %s:%u\n",
+                        m_filename.c_str(), m_ng ? "pcapng" : "pcap",
+                        (0 == m_filter.address) ? "any" :
+                        inet_ntoa(addr),
+                        m_filter.port);
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS PcapInput::next(const uint8_t*& data, size_t& size)
+{
+    STATUS result = STATUS_OK;
+    size = 0;
+
+    while (STATUS_OK == result && 0 == size)
+    {
+        const uint8_t* frame = NULL;
+        size_t frame_size = 0;
+        uint32_t linktype = 0;
+
+        result = next_frame(frame, frame_size, linktype);
+        if (STATUS_OK == result && !strip(frame, frame_size, linktype, data,
+            size))
+        {
+            size = 0;
+        }
+    }
+
+    // The end of capture is the end of input
+    return (STATUS_AGAIN == result) ? STATUS_OK : result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void PcapInput::report(FILE* out) const
+{
+    fprintf(out, "Capture finished:\n"
+                 "\tFrames: %llu\n"
+                 "\tDatagrams: %llu (RTP: %llu)\n"
+                 "\tSkipped: %llu\n",
+                 (unsigned long long)m_frames,
+                 (unsigned long long)m_datagrams,
+                 (unsigned long long)m_rtp,
+                 (unsigned long long)m_skipped);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS PcapInput::next_frame(const uint8_t*& frame, size_t& size,
+    uint32_t& linktype)
+{
+    STATUS result = STATUS_AGAIN;
+
+    if (m_ng)
+    {
+        result = next_block(frame, size, linktype);
+    }
+    else if (m_size - m_pos >= PCAP_RECORD_HEADER)
+    {
+        size = load32(&m_data[m_pos + 8]);
+        if (size <= m_size - m_pos - PCAP_RECORD_HEADER)
+        {
+            frame    = &m_data[m_pos + PCAP_RECORD_HEADER];
+            linktype = m_linktype;
+            m_pos   += PCAP_RECORD_HEADER + size;
+            result   = STATUS_OK;
+        }
+    }
+
+    /**
+    ****************************************************************************
+    * @note     Capture which was interrupted ends with partial record, the
+    *           packets before it are still good
+    ****************************************************************************
+    */
+    if (STATUS_AGAIN == result && m_pos != m_size)
+    {
+        fprintf(stderr, "Last record of %s is truncated\n",
+            m_filename.c_str());
+        m_pos = m_size;
+    }
+
+    m_frames += (STATUS_OK == result) ? 1 : 0;
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS PcapInput::next_block(const uint8_t*& frame, size_t& size,
+    uint32_t& linktype)
+{
+    STATUS result = STATUS_AGAIN;
+
+    while (STATUS_AGAIN == result && m_size - m_pos >= PCAPNG_BLOCK_MIN)
+    {
+        const uint8_t* block = &m_data[m_pos];
+        uint32_t type = 0;
+        memcpy(&type, block, sizeof(type));
+
+        // Section header defines byte order of all blocks of the section
+        if (PCAPNG_SHB == type)
+        {
+            uint32_t magic = 0;
+            memcpy(&magic, &block[8], sizeof(magic));
+            if (PCAPNG_BYTE_ORDER != magic &&
+                bswap_32(PCAPNG_BYTE_ORDER) != magic)
+            {
+                fprintf(stderr, "Wrong section header in %s\n",
+                    m_filename.c_str());
+                result = STATUS_FAIL;
+                break;
+            }
+
+            m_swap = (PCAPNG_BYTE_ORDER != magic);
+            m_interfaces.clear();
+        }
+        else
+        {
+            type = load32(block);
+        }
+
+        uint32_t length = load32(&block[4]);
+        if (length < PCAPNG_BLOCK_MIN || 0 != length % 4)
+        {
+            fprintf(stderr, "Wrong block length in %s\n", m_filename.c_str());
+            result = STATUS_FAIL;
+            break;
+        }
+
+        if (length > m_size - m_pos)
+        {
+            break;
+        }
+        m_pos += length;
+
+        // Body of the block without type, length and trailing length
+        const uint8_t* body = &block[8];
+        size_t body_size = length - PCAPNG_BLOCK_MIN;
+
+        if (PCAPNG_IDB == type && body_size >= 8)
+        {
+            m_interfaces.push_back(load16(body));
+        }
+        else if (PCAPNG_EPB == type && body_size >= 20)
+        {
+            uint32_t interface = load32(body);
+            size = load32(&body[12]);
+            if (interface < m_interfaces.size() && size <= body_size - 20)
+            {
+                frame    = &body[20];
+                linktype = m_interfaces[interface];
+                result   = STATUS_OK;
+            }
+        }
+        else if (PCAPNG_SPB == type && body_size >= 4 && !m_interfaces.empty())
+        {
+            // Captured length is known only from block length
+            size = load32(body);
+            size = (size < body_size - 4) ? size : body_size - 4;
+            frame    = &body[4];
+            linktype = m_interfaces[0];
+            result   = STATUS_OK;
+        }
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+bool PcapInput::strip(const uint8_t* frame, size_t size, uint32_t linktype,
+    const uint8_t*& data, size_t& data_size)
+{
+    bool result = false;
+    TSCursor cur(frame, size);
+
+    do
+    {
+        if (!skip_link_header(cur, linktype) || !cur.require(20))
+        {
+            break;
+        }
+
+        size_t ihl   = cur.get<ip_ihl>() * 4;
+        size_t total = cur.get<ip_total_length>();
+        if (17 != cur.get<ip_protocol>() || (0 != m_filter.address &&
+            m_filter.address != cur.get<ip_destination>()))
+        {
+            break;
+        }
+
+        /**
+        ************************************************************************
+        * @note     Datagram of the stream is skipped if it can't be taken
+        *           whole. Ethernet padding after IP datagram is ignored
+        ************************************************************************
+        */
+        m_skipped += 1;
+        if (cur.get<ip_more_fragments>() ||
+            0 != cur.get<ip_fragment_offset>() || ihl < 20 ||
+            total < ihl + 8 || !cur.require(ihl + 8))
+        {
+            break;
+        }
+
+        cur.skip(ihl);
+        if (0 != m_filter.port && m_filter.port != cur.get<udp_destination>())
+        {
+            m_skipped -= 1;
+            break;
+        }
+
+        size_t length = cur.get<udp_length>();
+        if (length < 8 || ihl + length > total || !cur.require(length))
+        {
+            break;
+        }
+        cur.skip(8);
+        length -= 8;
+
+        // TS packets are sent either as is or behind RTP header
+        bool rtp = 12 <= length && TS_SYNC_BYTE != *cur.ptr() &&
+            2 == cur.get<rtp_version>();
+        if (rtp)
+        {
+            const uint8_t* p = cur.ptr();
+            size_t header  = 12 + 4 * cur.get<rtp_csrc_count>();
+            size_t padding = cur.get<rtp_padding>() ? p[length - 1] : 0;
+            if (cur.get<rtp_extension>())
+            {
+                if (header + 4 > length)
+                {
+                    break;
+                }
+                header += 4 + 4 * be_bytes<2>::load(&p[header + 2]);
+            }
+
+            if (header + padding > length)
+            {
+                break;
+            }
+            cur.skip(header);
+            length -= header + padding;
+        }
+
+        if (0 == length || 0 != length % TS_PACKET_SIZE ||
+            TS_SYNC_BYTE != *cur.ptr())
+        {
+            break;
+        }
+
+        data      = cur.ptr();
+        data_size = length;
+        m_skipped   -= 1;
+        m_datagrams += 1;
+        m_rtp       += rtp ? 1 : 0;
+        result = true;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+uint16_t PcapInput::load16(const uint8_t* p) const
+{
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return m_swap ? bswap_16(v) : v;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+uint32_t PcapInput::load32(const uint8_t* p) const
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return m_swap ? bswap_32(v) : v;
+}
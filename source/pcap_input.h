@@ -0,0 +1,171 @@
+/**
+********************************************************************************
+* @file         pcap_input.h
+* @brief        MPEG-TS input from pcap/pcapng captures of UDP (RTP) streams
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _PCAP_INPUT_H_
+#define _PCAP_INPUT_H_
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "ts_processor.h"
+
+/**
+********************************************************************************
+* @brief        Compiles filter of captured datagrams from text: "any",
+*               "ADDR:PORT", "ADDR" or ":PORT" (IPv4 destination)
+* @param        [in] text   Filter text
+* @param        [out] filter    Compiled filter
+* @return       STATUS_OK on success, STATUS_FAIL if filter is malformed
+********************************************************************************
+*/
+STATUS parse_pcap_filter(const char* text, struct pcap_filter& filter);
+
+/**
+********************************************************************************
+* @class        PcapInput
+* @brief        Reads UDP datagrams of one stream from memory mapped capture
+*               (pcap with microsecond or nanosecond timestamps of any byte
+*               order, pcapng with any number of sections and interfaces).
+*               Ethernet (with VLAN tags), Linux cooked, raw IP and loopback
+*               frames of IPv4 UDP datagrams are accepted, RTP header is
+*               stripped. Payload is returned in place, without copy
+* @note         Fragmented IP datagrams and datagrams truncated by capture
+*               snap length are skipped, so the stream has a CC error there
+********************************************************************************
+*/
+class PcapInput
+{
+public:
+    /**
+    ****************************************************************************
+    * @brief    The only allowed constructor for this class
+    * @param    [in] fd         Opened capture file (isn't closed)
+    * @param    [in] filename   Capture file name
+    * @param    [in] filter     Destination of datagrams
+    ****************************************************************************
+    */
+    PcapInput(int fd, const char* const filename,
+        const struct pcap_filter& filter);
+
+    ~PcapInput();
+
+    /**
+    ****************************************************************************
+    * @brief    Maps capture and checks its file header
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS init(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Finds the next datagram of the stream
+    * @param    [out] data  TS packets of the datagram (inside of the capture
+    *                       mapping, valid until the object is destroyed)
+    * @param    [out] size  Size of TS packets, 0 at the end of capture
+    * @return   STATUS_OK on success, STATUS_FAIL if capture is broken
+    ****************************************************************************
+    */
+    STATUS next(const uint8_t*& data, size_t& size);
+
+    /**
+    ****************************************************************************
+    * @brief    Prints statistics of capture reading
+    * @param    [in] out    Output stream
+    * @return   void
+    ****************************************************************************
+    */
+    void report(FILE* out) const;
+
+private:
+    /**
+    ****************************************************************************
+    * @brief    Takes the next captured frame
+    * @param    [out] frame     Captured bytes of the frame
+    * @param    [out] size      Number of captured bytes
+    * @param    [out] linktype  Link type of the frame
+    * @return   STATUS_OK on frame, STATUS_AGAIN at the end of capture,
+    *           STATUS_FAIL if capture is broken
+    ****************************************************************************
+    */
+    STATUS next_frame(const uint8_t*& frame, size_t& size, uint32_t& linktype);
+
+    /**
+    ****************************************************************************
+    * @brief    Takes the next frame of pcapng capture. Section header and
+    *           interface description blocks are consumed on the way
+    * @param    [out] frame     Captured bytes of the frame
+    * @param    [out] size      Number of captured bytes
+    * @param    [out] linktype  Link type of the frame
+    * @return   STATUS_OK on frame, STATUS_AGAIN at the end of capture,
+    *           STATUS_FAIL if capture is broken
+    ****************************************************************************
+    */
+    STATUS next_block(const uint8_t*& frame, size_t& size, uint32_t& linktype);
+
+    /**
+    ****************************************************************************
+    * @brief    Strips link, IP, UDP and RTP headers of the frame
+    * @param    [in] frame      Captured frame
+    * @param    [in] size       Size of the frame
+    * @param    [in] linktype   Link type of the frame
+    * @param    [out] data      TS packets of the datagram
+    * @param    [out] data_size Size of TS packets
+    * @return   true if the frame is datagram of the stream
+    ****************************************************************************
+    */
+    bool strip(const uint8_t* frame, size_t size, uint32_t linktype,
+        const uint8_t*& data, size_t& data_size);
+
+    /**
+    ****************************************************************************
+    * @brief    Reads 16-bit field in byte order of the capture
+    * @param    [in] p  Field
+    * @return   Field value
+    ****************************************************************************
+    */
+    uint16_t load16(const uint8_t* p) const;
+
+    /**
+    ****************************************************************************
+    * @brief    Reads 32-bit field in byte order of the capture
+    * @param    [in] p  Field
+    * @return   Field value
+    ****************************************************************************
+    */
+    uint32_t load32(const uint8_t* p) const;
+
+private:    // Blocked implementations
+    PcapInput();
+    PcapInput(const PcapInput& r);
+    PcapInput& operator= (const PcapInput&);
+
+private:
+    int             m_fd;               ///< Capture file
+    std::string     m_filename;         ///< Capture file name
+    struct pcap_filter m_filter;        ///< Destination of datagrams
+
+    const uint8_t*  m_data;             ///< Mapping of the capture
+    size_t          m_size;             ///< Size of the capture
+    size_t          m_pos;              ///< Position of the next record
+
+    bool            m_ng;               ///< Capture is pcapng
+    bool            m_swap;             ///< Byte order differs from host
+    uint32_t        m_linktype;         ///< Link type of pcap capture
+    std::vector<uint32_t> m_interfaces; ///< Link types of pcapng section
+
+    uint64_t        m_frames;           ///< Captured frames
+    uint64_t        m_datagrams;        ///< Datagrams of the stream
+    uint64_t        m_rtp;              ///< Datagrams with RTP header
+    uint64_t        m_skipped;          ///< Truncated, fragmented, not TS
+};
+
+#endif  /* !_PCAP_INPUT_H_ */
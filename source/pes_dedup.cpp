@@ -0,0 +1,516 @@
+/**
+********************************************************************************
+* @file         pes_dedup.cpp
+* @brief        Deduplication of PES units of redundant inputs
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "pes_dedup.h"
+
+#include <string.h>
+
+/**
+********************************************************************************
+* @brief        Primes of XXH64
+********************************************************************************
+*/
+static const uint64_t s_prime1 = 0x9e3779b185ebca87ull;
+static const uint64_t s_prime2 = 0xc2b2ae3d27d4eb4full;
+static const uint64_t s_prime3 = 0x165667b19e3779f9ull;
+static const uint64_t s_prime4 = 0x85ebca77c2b2ae63ull;
+static const uint64_t s_prime5 = 0x27d4eb2f165667c5ull;
+
+/**
+********************************************************************************
+* @brief        Rotates 64-bit value left
+* @param        [in] value  Value
+* @param        [in] bits   Number of bits (1..63)
+* @return       Rotated value
+********************************************************************************
+*/
+static inline uint64_t rotl64(uint64_t value, unsigned bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+/**
+********************************************************************************
+* @brief        Reads 64-bit word of host byte order from unaligned address
+* @param        [in] data   Address
+* @return       Word
+********************************************************************************
+*/
+static inline uint64_t read64(const uint8_t* data)
+{
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+/**
+********************************************************************************
+* @brief        Reads 32-bit word of host byte order from unaligned address
+* @param        [in] data   Address
+* @return       Word
+********************************************************************************
+*/
+static inline uint32_t read32(const uint8_t* data)
+{
+    uint32_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+/**
+********************************************************************************
+* @brief        Mixes 64-bit word into lane of XXH64
+* @param        [in] acc    Lane
+* @param        [in] input  Word
+* @return       New value of the lane
+********************************************************************************
+*/
+static inline uint64_t hash_round(uint64_t acc, uint64_t input)
+{
+    acc += input * s_prime2;
+    return rotl64(acc, 31) * s_prime1;
+}
+
+/**
+********************************************************************************
+* @brief        Merges lane of XXH64 into the hash
+* @param        [in] acc    Hash
+* @param        [in] lane   Lane
+* @return       New value of the hash
+********************************************************************************
+*/
+static inline uint64_t hash_merge(uint64_t acc, uint64_t lane)
+{
+    acc ^= hash_round(0, lane);
+    return acc * s_prime1 + s_prime4;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+uint64_t pes_hash(const uint8_t* data, size_t size, uint64_t seed)
+{
+    const uint8_t* end = data + size;
+    uint64_t h = 0;
+
+    if (size >= 32)
+    {
+        // Lanes don't depend on each other, so rounds are pipelined
+        uint64_t v1 = seed + s_prime1 + s_prime2;
+        uint64_t v2 = seed + s_prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - s_prime1;
+
+        for (; data + 32 <= end; data += 32)
+        {
+            v1 = hash_round(v1, read64(data));
+            v2 = hash_round(v2, read64(data + 8));
+            v3 = hash_round(v3, read64(data + 16));
+            v4 = hash_round(v4, read64(data + 24));
+        }
+
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = hash_merge(h, v1);
+        h = hash_merge(h, v2);
+        h = hash_merge(h, v3);
+        h = hash_merge(h, v4);
+    }
+    else
+    {
+        h = seed + s_prime5;
+    }
+
+    h += size;
+
+    for (; data + 8 <= end; data += 8)
+    {
+        h ^= hash_round(0, read64(data));
+        h = rotl64(h, 27) * s_prime1 + s_prime4;
+    }
+
+    if (data + 4 <= end)
+    {
+        h ^= (uint64_t)read32(data) * s_prime1;
+        h = rotl64(h, 23) * s_prime2 + s_prime3;
+        data += 4;
+    }
+
+    for (; data < end; ++data)
+    {
+        h ^= *data * s_prime5;
+        h = rotl64(h, 11) * s_prime1;
+    }
+
+    h ^= h >> 33;
+    h *= s_prime2;
+    h ^= h >> 29;
+    h *= s_prime3;
+    h ^= h >> 32;
+
+    return h;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+PESDedup::PESDedup()
+    : m_streams(TS_PID_COUNT, static_cast<struct dedup_stream*>(NULL))
+    , m_units(0)
+    , m_duplicates(0)
+{
+    for (unsigned i = 0; i < DEDUP_SOURCES; ++i)
+    {
+        m_closed[i] = false;
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+PESDedup::~PESDedup()
+{
+    for (size_t i = 0; i < m_streams.size(); ++i)
+    {
+        delete m_streams[i];
+        m_streams[i] = NULL;
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void PESDedup::push(unsigned source, uint16_t stream,
+    const struct ts_event& event)
+{
+    if (source < DEDUP_SOURCES && stream < TS_PID_COUNT && !m_closed[source])
+    {
+        if (NULL == m_streams[stream])
+        {
+            struct dedup_stream* n = new dedup_stream();
+            n->history_size = 0;
+            n->history_next = 0;
+            for (unsigned i = 0; i < DEDUP_SOURCES; ++i)
+            {
+                n->started[i] = false;
+            }
+            m_streams[stream] = n;
+        }
+
+        struct dedup_stream& s = *m_streams[stream];
+        struct dedup_unit& unit = s.pending[source];
+        if (event.unit_start)
+        {
+            if (s.started[source])
+            {
+                complete(s, source);
+                merge(s);
+            }
+
+            s.started[source] = true;
+            unit.stream  = stream;
+            unit.has_pts = event.has_pts;
+            unit.pts     = event.pts;
+            unit.data.assign(event.data, event.data + event.size);
+        }
+        else if (s.started[source])
+        {
+            unit.data.insert(unit.data.end(), event.data,
+                event.data + event.size);
+        }
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void PESDedup::close(unsigned source, bool complete_units)
+{
+    if (source < DEDUP_SOURCES && !m_closed[source])
+    {
+        m_closed[source] = true;
+        for (size_t i = 0; i < m_streams.size(); ++i)
+        {
+            struct dedup_stream* s = m_streams[i];
+            if (NULL != s && s->started[source] && complete_units)
+            {
+                complete(*s, source);
+            }
+
+            if (NULL != s)
+            {
+                s->started[source] = false;
+                s->pending[source].data.clear();
+                merge(*s);
+            }
+        }
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS PESDedup::next_unit(struct dedup_unit& unit)
+{
+    STATUS result = STATUS_AGAIN;
+
+    if (!m_ready.empty())
+    {
+        unit.stream  = m_ready.front().stream;
+        unit.has_pts = m_ready.front().has_pts;
+        unit.pts     = m_ready.front().pts;
+        unit.data.swap(m_ready.front().data);
+        m_ready.pop_front();
+        result = STATUS_OK;
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void PESDedup::complete(struct dedup_stream& s, unsigned source)
+{
+    struct dedup_unit& unit = s.pending[source];
+    s.started[source] = false;
+
+    struct unit_key key;
+    key.has_pts = unit.has_pts;
+    key.pts     = unit.has_pts ? unit.pts : 0;
+    key.size    = unit.data.size();
+    key.hash    = pes_hash(unit.data.empty() ? NULL : &unit.data[0],
+        unit.data.size(), key.pts);
+
+    // Copy (or damaged version) of the unit which was passed long ago
+    if (emitted(s, key))
+    {
+        m_duplicates += 1;
+        unit.data.clear();
+    }
+    else
+    {
+        s.queue[source].push_back(dedup_entry());
+        struct dedup_entry& e = s.queue[source].back();
+        e.key          = key;
+        e.unit.stream  = unit.stream;
+        e.unit.has_pts = unit.has_pts;
+        e.unit.pts     = unit.pts;
+        e.unit.data.swap(unit.data);
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void PESDedup::merge(struct dedup_stream& s)
+{
+    std::deque<struct dedup_entry>& a = s.queue[0];
+    std::deque<struct dedup_entry>& b = s.queue[1];
+    bool progress = true;
+
+    /**
+    ****************************************************************************
+    * @note     Head of one queue found further in the other one means that
+    *           units before it are missing in the first input, they are
+    *           passed first. Without a match the order isn't known until the
+    *           other input delivers more units, closes or the window is full
+    ****************************************************************************
+    */
+    while (progress && (!a.empty() || !b.empty()))
+    {
+        size_t in_b = a.empty() ? b.size() : find(b, a.front().key);
+        size_t in_a = b.empty() ? a.size() : find(a, b.front().key);
+        bool last = m_closed[0] || m_closed[1] ||
+            a.size() + b.size() > DEDUP_WINDOW;
+        int damaged = (0 == in_b) ? -1 : damaged_head(s, last);
+
+        if (!a.empty() && !b.empty() && 0 == in_b)
+        {
+            emit(s, 0);
+            b.pop_front();
+            m_duplicates += 1;
+        }
+        else if (0 <= damaged)
+        {
+            s.queue[damaged].pop_front();
+            m_duplicates += 1;
+        }
+        else if (in_b < b.size())
+        {
+            emit(s, 1);
+        }
+        else if (in_a < a.size())
+        {
+            emit(s, 0);
+        }
+        else if ((b.empty() && m_closed[1]) || (!a.empty() && !b.empty() &&
+            m_closed[1] && m_closed[0]))
+        {
+            emit(s, 0);
+        }
+        else if (a.empty() && m_closed[0])
+        {
+            emit(s, 1);
+        }
+        else if (a.size() + b.size() > DEDUP_WINDOW)
+        {
+            // Longer queue holds the gap of the other input
+            emit(s, (a.size() >= b.size()) ? 0 : 1);
+        }
+        else
+        {
+            progress = false;
+        }
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+int PESDedup::damaged_head(const struct dedup_stream& s, bool last)
+{
+    const std::deque<struct dedup_entry>& a = s.queue[0];
+    const std::deque<struct dedup_entry>& b = s.queue[1];
+    int result = -1;
+
+    do
+    {
+        if (a.empty() || b.empty() || !a.front().key.has_pts ||
+            !b.front().key.has_pts || a.front().key.pts != b.front().key.pts)
+        {
+            break;
+        }
+
+        /**
+        ************************************************************************
+        * @note     Unit which spans a gap keeps PTS of its start, but its
+        *           data is spliced with data after the gap. Its input lost
+        *           the units which follow it, so the next unit of the input
+        *           is found further in the other queue. Unit which lost
+        *           packets inside is shorter than its copy
+        ************************************************************************
+        */
+        size_t a_next = (1 < a.size()) ? find(b, a[1].key) : b.size();
+        size_t b_next = (1 < b.size()) ? find(a, b[1].key) : a.size();
+        if (1 < a_next && a_next < b.size())
+        {
+            result = 0;
+        }
+        else if (1 < b_next && b_next < a.size())
+        {
+            result = 1;
+        }
+        else if ((1 == a_next && a_next < b.size()) ||
+            (1 == b_next && b_next < a.size()) || last)
+        {
+            result = (a.front().key.size < b.front().key.size) ? 0 : 1;
+        }
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void PESDedup::emit(struct dedup_stream& s, unsigned source)
+{
+    struct dedup_entry& e = s.queue[source].front();
+
+    s.history[s.history_next] = e.key;
+    s.history_next = (s.history_next + 1) % DEDUP_HISTORY;
+    if (s.history_size < DEDUP_HISTORY)
+    {
+        s.history_size += 1;
+    }
+
+    m_units += 1;
+    m_ready.push_back(dedup_unit());
+    m_ready.back().stream  = e.unit.stream;
+    m_ready.back().has_pts = e.unit.has_pts;
+    m_ready.back().pts     = e.unit.pts;
+    m_ready.back().data.swap(e.unit.data);
+
+    s.queue[source].pop_front();
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+bool PESDedup::emitted(const struct dedup_stream& s,
+    const struct unit_key& key)
+{
+    bool found = false;
+
+    for (size_t i = 0; !found && i < s.history_size; ++i)
+    {
+        found = same(s.history[i], key) || (key.has_pts &&
+            s.history[i].has_pts && key.pts == s.history[i].pts);
+    }
+
+    return found;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+size_t PESDedup::find(const std::deque<struct dedup_entry>& queue,
+    const struct unit_key& key)
+{
+    size_t i = 0;
+
+    while (i < queue.size() && !same(queue[i].key, key))
+    {
+        ++i;
+    }
+
+    return i;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+bool PESDedup::same(const struct unit_key& a, const struct unit_key& b)
+{
+    /**
+    ****************************************************************************
+    * @note     Copy has the same PTS, size and hash. Unit with the same PTS
+    *           but other content (damaged in one of the inputs) isn't a copy
+    ****************************************************************************
+    */
+    return a.hash == b.hash && a.pts == b.pts && a.size == b.size &&
+        a.has_pts == b.has_pts;
+}
@@ -0,0 +1,276 @@
+/**
+********************************************************************************
+* @file         pes_dedup.h
+* @brief        Deduplication of PES units of redundant inputs
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _PES_DEDUP_H_
+#define _PES_DEDUP_H_
+
+#include <deque>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ts_processor.h"
+
+/**
+********************************************************************************
+* @def          DEDUP_SOURCES
+* @brief        Number of inputs merged by PESDedup
+********************************************************************************
+*/
+#define DEDUP_SOURCES       2
+
+/**
+********************************************************************************
+* @def          DEDUP_HISTORY
+* @brief        Number of the last emitted units of a stream remembered for
+*               comparison
+********************************************************************************
+*/
+#define DEDUP_HISTORY       256
+
+/**
+********************************************************************************
+* @def          DEDUP_WINDOW
+* @brief        Maximal number of units of a stream waiting for their copies
+*               in other input. Limits the gap which is filled in order
+********************************************************************************
+*/
+#define DEDUP_WINDOW        256
+
+/**
+********************************************************************************
+* @brief        Computes 64-bit non-cryptographic hash of data (XXH64). Data
+*               is consumed in 32-byte stripes by four independent lanes
+* @param        [in] data   Data
+* @param        [in] size   Size of data
+* @param        [in] seed   Seed
+* @return       Hash value
+********************************************************************************
+*/
+uint64_t pes_hash(const uint8_t* data, size_t size, uint64_t seed);
+
+/**
+********************************************************************************
+* @struct       dedup_unit
+* @brief        Complete PES unit (ES data without PES header)
+********************************************************************************
+*/
+struct dedup_unit
+{
+    uint16_t                stream;     ///< Stream of the unit
+    bool                    has_pts;    ///< PES header has PTS
+    uint64_t                pts;        ///< PTS (90 kHz, if has_pts)
+    std::vector<uint8_t>    data;       ///< ES data
+};
+
+/**
+********************************************************************************
+* @class        PESDedup
+* @brief        Collects PES units of the same streams coming from two inputs
+*               and passes each unit only once. Complete unit is hashed and
+*               identified by its PTS, size and hash. Units of both inputs
+*               are queued and merged like two versions of one sequence:
+*               equal heads are passed once, units which are missing in one
+*               input are taken from the other in their place. Units with
+*               the same PTS but other content are versions of one unit
+*               damaged in one input, only the intact one is passed
+* @note         Unit is complete when the next unit of the same input starts
+*               (or on close()), so output lags behind input. Queue which
+*               can't be matched within DEDUP_WINDOW units is passed as is
+********************************************************************************
+*/
+class PESDedup
+{
+public:
+    PESDedup();
+
+    ~PESDedup();
+
+    /**
+    ****************************************************************************
+    * @brief    Takes PES event of the input
+    * @param    [in] source Number of the input (less than DEDUP_SOURCES)
+    * @param    [in] stream Stream of the event (less than TS_PID_COUNT). The
+    *                       same stream of all inputs has the same number
+    * @param    [in] event  TS_EVENT_PES event
+    * @return   void
+    ****************************************************************************
+    */
+    void push(unsigned source, uint16_t stream, const struct ts_event& event);
+
+    /**
+    ****************************************************************************
+    * @brief    Stops waiting for the input (end of the input or its failure)
+    * @param    [in] source         Number of the input
+    * @param    [in] complete_units Units being collected are complete,
+    *                               otherwise they are dropped
+    * @return   void
+    ****************************************************************************
+    */
+    void close(unsigned source, bool complete_units);
+
+    /**
+    ****************************************************************************
+    * @brief    Takes the next unit which passed deduplication
+    * @param    [out] unit  Unit
+    * @return   STATUS_OK if unit is taken, STATUS_AGAIN if there is none
+    ****************************************************************************
+    */
+    STATUS next_unit(struct dedup_unit& unit);
+
+    /**
+    ****************************************************************************
+    * @brief    Returns number of units passed
+    * @return   Number of units
+    ****************************************************************************
+    */
+    uint64_t units(void) const { return m_units; }
+
+    /**
+    ****************************************************************************
+    * @brief    Returns number of dropped copies
+    * @return   Number of units
+    ****************************************************************************
+    */
+    uint64_t duplicates(void) const { return m_duplicates; }
+
+private:
+    /**
+    ****************************************************************************
+    * @struct   unit_key
+    * @brief    Identity of emitted unit
+    ****************************************************************************
+    */
+    struct unit_key
+    {
+        bool        has_pts;    ///< Unit has PTS
+        uint64_t    pts;        ///< PTS of the unit
+        uint64_t    size;       ///< Size of ES data
+        uint64_t    hash;       ///< Hash of ES data
+    };
+
+    /**
+    ****************************************************************************
+    * @struct   dedup_entry
+    * @brief    Complete unit waiting for merge
+    ****************************************************************************
+    */
+    struct dedup_entry
+    {
+        struct unit_key         key;        ///< Identity of the unit
+        struct dedup_unit       unit;       ///< The unit
+    };
+
+    /**
+    ****************************************************************************
+    * @struct   dedup_stream
+    * @brief    Units of the stream being collected and waiting for merge in
+    *           each input and history of the stream
+    ****************************************************************************
+    */
+    struct dedup_stream
+    {
+        bool                    started[DEDUP_SOURCES]; ///< Unit is collected
+        struct dedup_unit       pending[DEDUP_SOURCES]; ///< Collected units
+        std::deque<struct dedup_entry> queue[DEDUP_SOURCES]; ///< Complete
+        struct unit_key         history[DEDUP_HISTORY]; ///< Emitted units
+        size_t                  history_size;   ///< Valid entries
+        size_t                  history_next;   ///< Entry to overwrite
+    };
+
+    /**
+    ****************************************************************************
+    * @brief    Queues complete unit unless its copy was emitted already
+    * @param    [in] s      Stream
+    * @param    [in] source Input of the unit
+    * @return   void
+    ****************************************************************************
+    */
+    void complete(struct dedup_stream& s, unsigned source);
+
+    /**
+    ****************************************************************************
+    * @brief    Emits queued units of the stream as far as their order is
+    *           known
+    * @param    [in] s  Stream
+    * @return   void
+    ****************************************************************************
+    */
+    void merge(struct dedup_stream& s);
+
+    /**
+    ****************************************************************************
+    * @brief    Checks whether heads of both queues are versions of one unit
+    *           (the same PTS, other content) and finds the damaged one
+    * @param    [in] s      Stream
+    * @param    [in] last   No more units are waited for, the shorter head
+    *                       is damaged unless the order tells otherwise
+    * @return   Input of the damaged head, -1 if heads aren't versions of
+    *           one unit or it isn't known yet
+    ****************************************************************************
+    */
+    static int damaged_head(const struct dedup_stream& s, bool last);
+
+    /**
+    ****************************************************************************
+    * @brief    Moves the first unit of the queue to output
+    * @param    [in] s      Stream
+    * @param    [in] source Input of the queue
+    * @return   void
+    ****************************************************************************
+    */
+    void emit(struct dedup_stream& s, unsigned source);
+
+    /**
+    ****************************************************************************
+    * @brief    Searches for the unit in the history of the stream
+    * @param    [in] s      Stream
+    * @param    [in] key    Identity of the unit
+    * @return   true if the unit or other version of it (the same PTS) was
+    *           emitted
+    ****************************************************************************
+    */
+    static bool emitted(const struct dedup_stream& s,
+        const struct unit_key& key);
+
+    /**
+    ****************************************************************************
+    * @brief    Searches for the unit in the queue
+    * @param    [in] queue  Queue
+    * @param    [in] key    Identity of the unit
+    * @return   Position of the unit, size of the queue if there is none
+    ****************************************************************************
+    */
+    static size_t find(const std::deque<struct dedup_entry>& queue,
+        const struct unit_key& key);
+
+    /**
+    ****************************************************************************
+    * @brief    Compares identities of units
+    * @param    [in] a  Identity of the first unit
+    * @param    [in] b  Identity of the second unit
+    * @return   true if units are copies
+    ****************************************************************************
+    */
+    static bool same(const struct unit_key& a, const struct unit_key& b);
+
+private:    // Blocked implementations
+    PESDedup(const PESDedup& r);
+    PESDedup& operator= (const PESDedup&);
+
+private:
+    std::vector<struct dedup_stream*>   m_streams;  ///< Streams by number
+    std::deque<struct dedup_unit>       m_ready;    ///< Units to emit
+    bool            m_closed[DEDUP_SOURCES]; ///< Input isn't waited for
+
+    uint64_t        m_units;            ///< Units passed
+    uint64_t        m_duplicates;       ///< Copies dropped
+};
+
+#endif  /* !_PES_DEDUP_H_ */
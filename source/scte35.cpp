@@ -0,0 +1,664 @@
+/**
+********************************************************************************
+* @file         scte35.cpp
+* @brief        SCTE-35 splice information parser and cue list output
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "scte35.h"
+#include "ts_cursor.h"
+#include "ts_parse.h"
+
+#include <errno.h>
+#include <string.h>
+
+/**
+********************************************************************************
+* @brief        splice_info_section header fields (offset from table_id)
+********************************************************************************
+*/
+typedef bit_field<4, 0, 1>  sis_encrypted_packet;
+typedef bit_field<4, 7, 1>  sis_pts_adjustment_hi;
+typedef bit_field<5, 0, 32> sis_pts_adjustment_lo;
+typedef bit_field<11, 4, 12> sis_splice_command_length;
+typedef bit_field<13, 0, 8> sis_splice_command_type;
+
+/**
+********************************************************************************
+* @brief        33-bit time field (splice_time, break_duration) whose most
+*               significant bit is the last bit of the first byte
+********************************************************************************
+*/
+typedef bit_field<0, 7, 1>  time33_hi;
+typedef bit_field<1, 0, 32> time33_lo;
+
+/**
+********************************************************************************
+* @def          SIS_HEADER_SIZE
+* @brief        Size of splice_info_section up to splice_command_type
+********************************************************************************
+*/
+#define SIS_HEADER_SIZE     14
+
+/**
+********************************************************************************
+* @def          SIS_CRC_SIZE
+* @brief        Size of CRC32 at the end of section
+********************************************************************************
+*/
+#define SIS_CRC_SIZE        4
+
+/**
+********************************************************************************
+* @brief        Reads 33-bit time field at cursor position
+* @param        [in] cur    Cursor, 5 bytes must be covered by require()
+* @return       Time value
+********************************************************************************
+*/
+static inline uint64_t read_time33(const TSCursor& cur)
+{
+    return ((uint64_t)cur.get<time33_hi>() << 32) | cur.get<time33_lo>();
+}
+
+/**
+********************************************************************************
+* @brief        Parses splice_time() structure
+* @param        [in,out] cur    Cursor at splice_time()
+* @param        [out] info      has_time and pts are set
+* @return       STATUS_OK on success, STATUS_FAIL if structure is truncated
+********************************************************************************
+*/
+static STATUS parse_splice_time(TSCursor& cur, struct splice_info& info)
+{
+    STATUS result = STATUS_FAIL;
+
+    do
+    {
+        if (!cur.require(1))
+        {
+            break;
+        }
+
+        if (!cur.get<bit_field<0, 0, 1> >())
+        {
+            cur.skip(1);
+            result = STATUS_OK;
+            break;
+        }
+
+        if (!cur.require(5))
+        {
+            break;
+        }
+
+        info.has_time = true;
+        info.pts = (read_time33(cur) + info.pts_adjustment) & PTS_MASK;
+        cur.skip(5);
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/**
+********************************************************************************
+* @brief        Parses splice_insert() command
+* @param        [in,out] cur    Cursor at the command
+* @param        [out] info      Decoded command
+* @return       STATUS_OK on success, STATUS_FAIL if command is truncated
+********************************************************************************
+*/
+static STATUS parse_splice_insert(TSCursor& cur, struct splice_info& info)
+{
+    STATUS result = STATUS_FAIL;
+
+    do
+    {
+        if (!cur.require(5))
+        {
+            break;
+        }
+
+        info.has_event = true;
+        info.event_id  = cur.get<bit_field<0, 0, 32> >();
+        info.cancel    = cur.get<bit_field<4, 0, 1> >();
+        cur.skip(5);
+
+        if (info.cancel)
+        {
+            result = STATUS_OK;
+            break;
+        }
+
+        if (!cur.require(1))
+        {
+            break;
+        }
+
+        info.out_of_network = cur.get<bit_field<0, 0, 1> >();
+        bool program        = cur.get<bit_field<0, 1, 1> >();
+        info.has_duration   = cur.get<bit_field<0, 2, 1> >();
+        info.immediate      = cur.get<bit_field<0, 3, 1> >();
+        cur.skip(1);
+
+        if (program && !info.immediate &&
+            STATUS_OK != parse_splice_time(cur, info))
+        {
+            break;
+        }
+
+        // Component splice: time of the first component is taken
+        if (!program)
+        {
+            if (!cur.require(1))
+            {
+                break;
+            }
+            int count = cur.get<bit_field<0, 0, 8> >();
+            cur.skip(1);
+
+            // Times of the following components are parsed only to skip
+            struct splice_info rest = info;
+            bool broken = false;
+            for (int i = 0; i < count && !broken; ++i)
+            {
+                broken = !cur.require(1);
+                if (!broken)
+                {
+                    cur.skip(1);
+                    broken = !info.immediate && STATUS_OK !=
+                        parse_splice_time(cur, info.has_time ? rest : info);
+                }
+            }
+
+            if (broken)
+            {
+                break;
+            }
+        }
+
+        if (info.has_duration)
+        {
+            if (!cur.require(5))
+            {
+                break;
+            }
+            info.duration = read_time33(cur);
+            cur.skip(5);
+        }
+
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/**
+********************************************************************************
+* @brief        Parses segmentation_descriptor() body (after tag and length)
+* @param        [in,out] cur    Cursor over descriptor body
+* @param        [out] info      Segmentation event, type and duration
+* @return       void
+********************************************************************************
+*/
+static void parse_segmentation(TSCursor& cur, struct splice_info& info)
+{
+    do
+    {
+        // identifier ("CUEI"), segmentation_event_id, cancel indicator
+        if (!cur.require(9) ||
+            0x43554549 != cur.get<bit_field<0, 0, 32> >())
+        {
+            break;
+        }
+
+        info.has_event = true;
+        info.event_id  = cur.get<bit_field<4, 0, 32> >();
+        info.cancel    = cur.get<bit_field<8, 0, 1> >();
+        cur.skip(9);
+
+        if (info.cancel || !cur.require(1))
+        {
+            break;
+        }
+
+        bool program  = cur.get<bit_field<0, 0, 1> >();
+        bool duration = cur.get<bit_field<0, 1, 1> >();
+        cur.skip(1);
+
+        if (!program)
+        {
+            if (!cur.require(1))
+            {
+                break;
+            }
+            size_t components = cur.get<bit_field<0, 0, 8> >();
+            cur.skip(1);
+            if (!cur.require(components * 6))
+            {
+                break;
+            }
+            cur.skip(components * 6);
+        }
+
+        if (duration)
+        {
+            if (!cur.require(5))
+            {
+                break;
+            }
+            info.has_duration = true;
+            info.duration = ((uint64_t)cur.get<bit_field<0, 0, 8> >() << 32) |
+                cur.get<bit_field<1, 0, 32> >();
+            cur.skip(5);
+        }
+
+        // segmentation_upid_type, segmentation_upid_length and upid
+        if (!cur.require(2))
+        {
+            break;
+        }
+        size_t upid = cur.get<bit_field<1, 0, 8> >();
+        cur.skip(2);
+        if (!cur.require(upid + 1))
+        {
+            break;
+        }
+        cur.skip(upid);
+
+        info.segmentation_type = cur.get<bit_field<0, 0, 8> >();
+
+    } while(0);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS parse_splice_info(const uint8_t* section, size_t size,
+    struct splice_info& info)
+{
+    STATUS result = STATUS_FAIL;
+    TSCursor cur(section, size);
+
+    memset(&info, 0, sizeof(info));
+    info.segmentation_type = -1;
+
+    do
+    {
+        // Whole section is the window of header reads below
+        if (size < SIS_HEADER_SIZE + SIS_CRC_SIZE || !cur.require(size) ||
+            0xfc != cur.get<psi_table_id>())
+        {
+            break;
+        }
+
+        if (cur.get<sis_encrypted_packet>())
+        {
+            result = STATUS_AGAIN;
+            break;
+        }
+
+        info.command        = cur.get<sis_splice_command_type>();
+        info.pts_adjustment = ((uint64_t)cur.get<sis_pts_adjustment_hi>() <<
+            32) | cur.get<sis_pts_adjustment_lo>();
+        size_t cmd_size     = cur.get<sis_splice_command_length>();
+        cur.skip(SIS_HEADER_SIZE);
+
+        /**
+        ************************************************************************
+        * @note     Command is parsed by its own cursor. Length 0xfff is used
+        *           by legacy encoders when length is unknown, in this case
+        *           descriptor loop can't be located
+        ************************************************************************
+        */
+        bool legacy = (0xfff == cmd_size);
+        if (legacy)
+        {
+            cmd_size = cur.left() - SIS_CRC_SIZE;
+        }
+        else if (cur.left() < cmd_size + SIS_CRC_SIZE)
+        {
+            break;
+        }
+
+        TSCursor cmd(cur.ptr(), cmd_size);
+        cur.skip(cmd_size);
+
+        if ((SPLICE_INSERT == info.command &&
+            STATUS_OK != parse_splice_insert(cmd, info)) ||
+            (SPLICE_TIME_SIGNAL == info.command &&
+            STATUS_OK != parse_splice_time(cmd, info)))
+        {
+            break;
+        }
+
+        result = STATUS_OK;
+
+        if (legacy || !cur.require(2 + SIS_CRC_SIZE))
+        {
+            break;
+        }
+
+        size_t loop = cur.get<bit_field<0, 0, 16> >();
+        cur.skip(2);
+        if (cur.left() < loop + SIS_CRC_SIZE)
+        {
+            break;
+        }
+
+        // Segmentation descriptors describe time_signal cues
+        TSCursor desc(cur.ptr(), loop);
+        while (desc.require(2))
+        {
+            int tag = desc.get<bit_field<0, 0, 8> >();
+            size_t len = desc.get<bit_field<1, 0, 8> >();
+            desc.skip(2);
+            if (!desc.require(len))
+            {
+                break;
+            }
+
+            if (0x02 == tag && SPLICE_TIME_SIGNAL == info.command)
+            {
+                TSCursor body(desc.ptr(), len);
+                parse_segmentation(body, info);
+            }
+            desc.skip(len);
+        }
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+const char* splice_command_name(int command)
+{
+    const char* name = "reserved";
+
+    switch (command)
+    {
+        case SPLICE_NULL:           name = "splice_null";           break;
+        case SPLICE_SCHEDULE:       name = "splice_schedule";       break;
+        case SPLICE_INSERT:         name = "splice_insert";         break;
+        case SPLICE_TIME_SIGNAL:    name = "time_signal";           break;
+        case SPLICE_BANDWIDTH:      name = "bandwidth_reservation"; break;
+        case SPLICE_PRIVATE:        name = "private_command";       break;
+    }
+
+    return name;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+CueWriter::CueWriter(const char* const filename)
+    : m_filename(filename)
+    , m_file(NULL)
+    , m_has_clock(false)
+    , m_clock(0)
+    , m_first_pts(0)
+    , m_cues(0)
+    , m_crc_errors(0)
+    , m_skipped(0)
+{
+
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+CueWriter::~CueWriter()
+{
+    close();
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS CueWriter::init()
+{
+    STATUS result = STATUS_FAIL;
+
+    do
+    {
+        m_file = fopen(m_filename.c_str(), "w");
+        if (NULL == m_file)
+        {
+            fprintf(stderr, "Can't open cue list (%s). Error: %s\n",
+                m_filename.c_str(), strerror(errno));
+            break;
+        }
+
+        fprintf(m_file, "# pid pts time command [event] [cancel|out|in] "
+            "[duration] [segmentation_type]\n");
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void CueWriter::add_pid(uint16_t pid)
+{
+    if (!accepts(pid))
+    {
+        m_pids.push_back(pid);
+        m_assemblers.push_back(SectionAssembler());
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+bool CueWriter::accepts(uint16_t pid) const
+{
+    bool result = false;
+
+    for (size_t i = 0; i < m_pids.size() && !result; ++i)
+    {
+        result = (pid == m_pids[i]);
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void CueWriter::set_clock(uint64_t pts)
+{
+    if (!m_has_clock)
+    {
+        m_first_pts = pts;
+        m_has_clock = true;
+    }
+    m_clock = pts;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS CueWriter::push(const uint8_t* packet)
+{
+    STATUS result = STATUS_OK;
+    uint16_t pid = ts_pid::get(packet);
+
+    for (size_t i = 0; i < m_pids.size(); ++i)
+    {
+        if (pid != m_pids[i])
+        {
+            continue;
+        }
+
+        m_assemblers[i].push(packet);
+
+        const uint8_t* section = NULL;
+        size_t size = 0;
+        while (STATUS_OK == result &&
+            STATUS_OK == m_assemblers[i].next_section(section, size))
+        {
+            // Heartbeat repeated byte for byte needs neither CRC nor parsing
+            if (m_heartbeats.find(pid, section, size))
+            {
+                continue;
+            }
+
+            if (0 != psi_crc32(section, size))
+            {
+                m_crc_errors += 1;
+                continue;
+            }
+
+            struct splice_info info;
+            if (STATUS_OK != parse_splice_info(section, size, info))
+            {
+                m_skipped += 1;
+                continue;
+            }
+
+            // splice_null is a heartbeat, not a cue
+            if (SPLICE_NULL != info.command)
+            {
+                result = write_cue(pid, info);
+            }
+            else
+            {
+                m_heartbeats.insert(pid, section, size);
+            }
+        }
+        break;
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS CueWriter::write_cue(uint16_t pid, const struct splice_info& info)
+{
+    STATUS result = STATUS_OK;
+
+    /**
+    ****************************************************************************
+    * @note     Immediate splice (or command without time) happens at the
+    *           current position of the stream. Time is counted from the first
+    *           unit modulo 33 bits, so PTS wrap around is handled
+    ****************************************************************************
+    */
+    bool known = info.has_time || m_has_clock;
+    uint64_t pts = info.has_time ? info.pts : m_clock;
+
+    fprintf(m_file, "%d ", pid);
+    if (known)
+    {
+        fprintf(m_file, "%llu ", (unsigned long long)pts);
+    }
+    else
+    {
+        fprintf(m_file, "- ");
+    }
+
+    if (known && m_has_clock)
+    {
+        fprintf(m_file, "%.3f ", ((pts - m_first_pts) & PTS_MASK) / 90000.0);
+    }
+    else
+    {
+        fprintf(m_file, "- ");
+    }
+
+    fprintf(m_file, "%s", splice_command_name(info.command));
+
+    if (info.has_event)
+    {
+        fprintf(m_file, " event=%u", info.event_id);
+    }
+
+    if (info.cancel)
+    {
+        fprintf(m_file, " cancel");
+    }
+    else if (SPLICE_INSERT == info.command)
+    {
+        fprintf(m_file, " %s", info.out_of_network ? "out" : "in");
+    }
+
+    if (info.has_duration)
+    {
+        fprintf(m_file, " duration=%.3f", info.duration / 90000.0);
+    }
+
+    if (-1 != info.segmentation_type)
+    {
+        fprintf(m_file, " segmentation_type=0x%02x", info.segmentation_type);
+    }
+
+    if (0 > fprintf(m_file, "\n"))
+    {
+        fprintf(stderr, "Can't write to cue list (%s). Error: %s\n",
+            m_filename.c_str(), strerror(errno));
+        result = STATUS_FAIL;
+    }
+
+    m_cues += 1;
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS CueWriter::close()
+{
+    STATUS result = STATUS_OK;
+
+    if (NULL != m_file)
+    {
+        if (0 != fclose(m_file))
+        {
+            result = STATUS_FAIL;
+        }
+        m_file = NULL;
+
+        fprintf(stdout, "SCTE-35 cues: %llu written to %s (CRC errors: %llu, "
+            "skipped: %llu, repeated heartbeats: %llu)\n",
+            (unsigned long long)m_cues, m_filename.c_str(),
+            (unsigned long long)m_crc_errors, (unsigned long long)m_skipped,
+            (unsigned long long)m_heartbeats.hits());
+    }
+
+    return result;
+}
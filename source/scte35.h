@@ -0,0 +1,190 @@
+/**
+********************************************************************************
+* @file         scte35.h
+* @brief        SCTE-35 splice information parser and cue list output
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _SCTE35_H_
+#define _SCTE35_H_
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "ts_processor.h"
+#include "ts_section.h"
+
+/**
+********************************************************************************
+* @enum         SPLICE_COMMAND
+* @brief        Types of splice commands
+********************************************************************************
+*/
+typedef enum
+{
+    SPLICE_NULL             = 0x00,
+    SPLICE_SCHEDULE         = 0x04,
+    SPLICE_INSERT           = 0x05,
+    SPLICE_TIME_SIGNAL      = 0x06,
+    SPLICE_BANDWIDTH        = 0x07, ///< Bandwidth reservation
+    SPLICE_PRIVATE          = 0xff
+} SPLICE_COMMAND;
+
+/**
+********************************************************************************
+* @struct       splice_info
+* @brief        Decoded splice_info_section (splice_insert and time_signal
+*               commands, segmentation descriptor)
+********************************************************************************
+*/
+struct splice_info
+{
+    uint8_t     command;            ///< SPLICE_COMMAND
+    uint64_t    pts_adjustment;     ///< Offset added to all splice times
+    bool        has_time;           ///< Splice time is specified
+    uint64_t    pts;                ///< Splice time with adjustment applied
+    bool        immediate;          ///< Splice at the nearest opportunity
+    bool        has_event;          ///< event_id is present
+    uint32_t    event_id;           ///< Splice or segmentation event ID
+    bool        cancel;             ///< Event is cancelled
+    bool        out_of_network;     ///< Start of break (splice_insert)
+    bool        has_duration;       ///< Break or segment duration present
+    uint64_t    duration;           ///< Duration (90 kHz)
+    int         segmentation_type;  ///< segmentation_type_id, -1 if absent
+};
+
+/**
+********************************************************************************
+* @brief        Parses splice_info_section. CRC must be checked by caller
+* @param        [in] section    Section (starting with table_id 0xfc)
+* @param        [in] size       Size of the whole section including CRC
+* @param        [out] info      Decoded splice information
+* @return       STATUS_OK on success, STATUS_AGAIN if section is encrypted,
+*               STATUS_FAIL if section is broken
+********************************************************************************
+*/
+STATUS parse_splice_info(const uint8_t* section, size_t size,
+    struct splice_info& info);
+
+/**
+********************************************************************************
+* @brief        Returns name of splice command
+* @param        [in] command    Splice command type
+* @return       Name of the command
+********************************************************************************
+*/
+const char* splice_command_name(int command);
+
+/**
+********************************************************************************
+* @class        CueWriter
+* @brief        Collects splice_info_sections of SCTE-35 PIDs and writes cue
+*               list: one line per splice command with its time resolved to
+*               PTS of the stream and to seconds from the stream start
+********************************************************************************
+*/
+class CueWriter
+{
+public:
+    /**
+    ****************************************************************************
+    * @brief    The only allowed constructor for this class
+    * @param    [in] filename   Output cue list file name
+    ****************************************************************************
+    */
+    explicit CueWriter(const char* const filename);
+
+    ~CueWriter();
+
+    /**
+    ****************************************************************************
+    * @brief    Opens output file
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS init(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Adds SCTE-35 PID to watch. PIDs already added are kept
+    * @param    [in] pid    PID of SCTE-35 stream
+    * @return   void
+    ****************************************************************************
+    */
+    void add_pid(uint16_t pid);
+
+    /**
+    ****************************************************************************
+    * @brief    Checks whether packet belongs to SCTE-35 PID
+    * @param    [in] pid    PID of the packet
+    * @return   true if PID was added, false - otherwise
+    ****************************************************************************
+    */
+    bool accepts(uint16_t pid) const;
+
+    /**
+    ****************************************************************************
+    * @brief    Updates stream clock used to resolve immediate splices and
+    *           times relative to the start of the stream
+    * @param    [in] pts    PTS of the latest video (or audio) unit
+    * @return   void
+    ****************************************************************************
+    */
+    void set_clock(uint64_t pts);
+
+    /**
+    ****************************************************************************
+    * @brief    Processes packet of SCTE-35 PID and writes cues of complete
+    *           sections
+    * @param    [in] packet TS packet
+    * @return   STATUS_OK on success, STATUS_FAIL on write error
+    ****************************************************************************
+    */
+    STATUS push(const uint8_t* packet);
+
+    /**
+    ****************************************************************************
+    * @brief    Closes output file and prints statistics
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS close(void);
+
+private:
+    /**
+    ****************************************************************************
+    * @brief    Writes single cue line
+    * @param    [in] pid    PID of SCTE-35 stream
+    * @param    [in] info   Decoded splice information
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS write_cue(uint16_t pid, const struct splice_info& info);
+
+private:    // Blocked implementations
+    CueWriter();
+    CueWriter(const CueWriter& r);
+    CueWriter& operator= (const CueWriter&);
+
+private:
+    std::string     m_filename;     ///< Output cue list file name
+    FILE*           m_file;         ///< Output cue list
+
+    std::vector<uint16_t>           m_pids;         ///< SCTE-35 PIDs
+    std::vector<SectionAssembler>   m_assemblers;   ///< Assembler per PID
+    SectionCache                    m_heartbeats;   ///< splice_null sections
+
+    bool            m_has_clock;    ///< Stream clock is known
+    uint64_t        m_clock;        ///< PTS of the latest unit
+    uint64_t        m_first_pts;    ///< PTS of the first unit
+
+    uint64_t        m_cues;         ///< Cues written
+    uint64_t        m_crc_errors;   ///< Sections dropped due to CRC
+    uint64_t        m_skipped;      ///< Encrypted or broken sections
+};
+
+#endif  /* !_SCTE35_H_ */
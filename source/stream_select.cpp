@@ -0,0 +1,258 @@
+/**
+********************************************************************************
+* @file         stream_select.cpp
+* @brief        Rules of elementary stream selection by kind, language, codec
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "stream_select.h"
+#include "ts_descriptors.h"
+
+#include <string.h>
+#include <strings.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <ctype.h>
+
+/**
+********************************************************************************
+* @brief        Removes leading and trailing spaces
+* @param        [in] s  String to trim
+* @return       Trimmed string
+********************************************************************************
+*/
+static std::string trim(const std::string& s)
+{
+    size_t begin = s.find_first_not_of(" \t");
+    size_t end = s.find_last_not_of(" \t");
+
+    return (std::string::npos == begin) ? std::string() :
+        s.substr(begin, end - begin + 1);
+}
+
+/**
+********************************************************************************
+* @brief        Parses non-negative number (decimal or hex with 0x prefix)
+* @param        [in] s      Text of the number
+* @param        [in] max    Maximum allowed value
+* @param        [out] value Parsed value
+* @return       STATUS_OK on success, STATUS_FAIL - otherwise
+********************************************************************************
+*/
+static STATUS parse_number(const std::string& s, long max, int& value)
+{
+    STATUS result = STATUS_FAIL;
+    char* end = NULL;
+    long v = strtol(s.c_str(), &end, 0);
+
+    if (!s.empty() && '\0' == *end && v >= 0 && v <= max)
+    {
+        value = v;
+        result = STATUS_OK;
+    }
+
+    return result;
+}
+
+/**
+********************************************************************************
+* @brief        Applies single KEY=VALUE condition to the rule
+* @param        [in] cond   Condition text
+* @param        [in,out] rule   Rule being compiled
+* @return       STATUS_OK on success, STATUS_FAIL - otherwise
+********************************************************************************
+*/
+static STATUS parse_condition(const std::string& cond,
+    struct select_rule& rule)
+{
+    STATUS result = STATUS_FAIL;
+
+    do
+    {
+        size_t eq = cond.find('=');
+        if (std::string::npos == eq)
+        {
+            break;
+        }
+
+        std::string key = trim(cond.substr(0, eq));
+        std::string value = trim(cond.substr(eq + 1));
+
+        if ("lang" == key)
+        {
+            if (3 != value.size())
+            {
+                break;
+            }
+            memcpy(rule.language, value.c_str(), 4);
+            result = STATUS_OK;
+        }
+        else if ("codec" == key)
+        {
+            for (int c = 0; c < CODEC_COUNT; ++c)
+            {
+                if (0 == strcasecmp(value.c_str(),
+                    codec_name(static_cast<STREAM_CODEC>(c))))
+                {
+                    rule.codec = c;
+                    result = STATUS_OK;
+                    break;
+                }
+            }
+        }
+        else if ("pid" == key)
+        {
+            result = parse_number(value, 0x1ffe, rule.pid);
+        }
+        else if ("type" == key)
+        {
+            result = parse_number(value, 0xff, rule.type);
+        }
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS parse_select_rule(const char* text, struct select_rule& rule)
+{
+    STATUS result = STATUS_FAIL;
+
+    rule.text     = text;
+    rule.any_kind = false;
+    rule.kind     = STREAM_UNKNOWN;
+    rule.codec    = -1;
+    rule.pid      = -1;
+    rule.type     = -1;
+    memset(rule.language, 0, sizeof(rule.language));
+
+    do
+    {
+        size_t arrow = rule.text.find("->");
+        if (std::string::npos == arrow)
+        {
+            break;
+        }
+
+        rule.output = trim(rule.text.substr(arrow + 2));
+        std::string match = trim(rule.text.substr(0, arrow));
+        if (rule.output.empty() || match.empty())
+        {
+            break;
+        }
+
+        size_t colon = match.find(':');
+        std::string kind = trim(match.substr(0, colon));
+        if ("any" == kind)
+        {
+            rule.any_kind = true;
+        }
+        else
+        {
+            for (int k = STREAM_VIDEO; k <= STREAM_DATA; ++k)
+            {
+                if (kind == kind_name(static_cast<STREAM_KIND>(k)))
+                {
+                    rule.kind = static_cast<STREAM_KIND>(k);
+                    break;
+                }
+            }
+
+            if (STREAM_UNKNOWN == rule.kind)
+            {
+                break;
+            }
+        }
+
+        result = STATUS_OK;
+
+        // Conditions are separated by commas
+        while (std::string::npos != colon && STATUS_OK == result)
+        {
+            size_t comma = match.find(',', colon + 1);
+            result = parse_condition(match.substr(colon + 1,
+                (std::string::npos == comma) ? comma : comma - colon - 1),
+                rule);
+            colon = comma;
+        }
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+bool match_select_rule(const struct select_rule& rule,
+    const struct ts_stream_info& info)
+{
+    return (rule.any_kind || rule.kind == info.kind) &&
+        ('\0' == rule.language[0] ||
+            0 == strncasecmp(rule.language, info.language, 3)) &&
+        (-1 == rule.codec || rule.codec == info.codec) &&
+        (-1 == rule.pid || rule.pid == info.pid) &&
+        (-1 == rule.type || rule.type == info.type);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+std::string select_output_name(const struct select_rule& rule,
+    const struct ts_stream_info& info)
+{
+    std::string name;
+    char pid[8];
+    snprintf(pid, sizeof(pid), "%d", info.pid);
+
+    for (size_t i = 0; i < rule.output.size(); ++i)
+    {
+        size_t end = rule.output.find('%', i + 1);
+        std::string key = ('%' != rule.output[i] ||
+            std::string::npos == end) ? "" :
+            rule.output.substr(i + 1, end - i - 1);
+
+        if ("pid" == key)
+        {
+            name += pid;
+        }
+        else if ("lang" == key)
+        {
+            // Language comes from the stream, so it must not break the path
+            bool valid = ('\0' != info.language[0]);
+            for (int k = 0; k < 3 && valid; ++k)
+            {
+                valid = (0 != isalnum((unsigned char)info.language[k]));
+            }
+            name += valid ? info.language : "und";
+        }
+        else if ("codec" == key)
+        {
+            name += codec_name(info.codec);
+        }
+        else if ("kind" == key)
+        {
+            name += kind_name(info.kind);
+        }
+        else
+        {
+            name += rule.output[i];
+            continue;
+        }
+
+        i = end;
+    }
+
+    return name;
+}
@@ -0,0 +1,49 @@
+/**
+********************************************************************************
+* @file         stream_select.h
+* @brief        Rules of elementary stream selection by kind, language, codec
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _STREAM_SELECT_H_
+#define _STREAM_SELECT_H_
+
+#include <string>
+
+#include "ts_processor.h"
+
+/**
+********************************************************************************
+* @brief        Compiles selection rule from text
+* @param        [in] text   Rule text
+* @param        [out] rule  Compiled rule
+* @return       STATUS_OK on success, STATUS_FAIL if rule is malformed
+********************************************************************************
+*/
+STATUS parse_select_rule(const char* text, struct select_rule& rule);
+
+/**
+********************************************************************************
+* @brief        Checks that stream satisfies all conditions of the rule
+* @param        [in] rule   Compiled rule
+* @param        [in] info   Stream metadata
+* @return       true if stream is selected by the rule, false - otherwise
+********************************************************************************
+*/
+bool match_select_rule(const struct select_rule& rule,
+    const struct ts_stream_info& info);
+
+/**
+********************************************************************************
+* @brief        Builds output file name of the stream selected by the rule
+* @param        [in] rule   Compiled rule
+* @param        [in] info   Stream metadata
+* @return       Output file name with all placeholders replaced
+********************************************************************************
+*/
+std::string select_output_name(const struct select_rule& rule,
+    const struct ts_stream_info& info);
+
+#endif  /* !_STREAM_SELECT_H_ */
@@ -0,0 +1,657 @@
+/**
+********************************************************************************
+* @file         ts_analyzer.cpp
+* @brief        TR 101 290 priority 1 and 2 checks of MPEG-TS stream
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "ts_analyzer.h"
+#include "ts_fields.h"
+#include "ts_parse.h"
+#include "ts_descriptors.h"
+#include "dvb_si.h"
+
+#include <string.h>
+
+/**
+********************************************************************************
+* @brief        Limits of TR 101 290 checks (27 MHz)
+********************************************************************************
+*/
+#define TR_PAT_INTERVAL     (27000000ull / 2)       ///< PAT and PMT: 0.5 s
+#define TR_PID_INTERVAL     (27000000ull * 5)       ///< Referred PIDs: 5 s
+#define TR_PCR_INTERVAL     (27000000ull / 10)      ///< PCR: 100 ms
+#define TR_PTS_INTERVAL     (27000000ull * 7 / 10)  ///< PTS: 700 ms
+#define TR_PCR_JITTER       13.5                    ///< PCR: 500 ns
+
+/**
+********************************************************************************
+* @def          SYNC_ACQUIRE
+* @brief        Correct sync bytes in a row after which sync is acquired
+********************************************************************************
+*/
+#define SYNC_ACQUIRE        5
+
+/**
+********************************************************************************
+* @def          SYNC_LOSS
+* @brief        Corrupted sync bytes in a row after which sync is lost
+********************************************************************************
+*/
+#define SYNC_LOSS           2
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+const char* tr_check_name(int check)
+{
+    static const char* const s_names[TR_CHECK_COUNT] =
+    {
+        "1.1 TS_sync_loss",
+        "1.2 Sync_byte_error",
+        "1.3 PAT_error_2",
+        "1.4 Continuity_count_error",
+        "1.5 PMT_error_2",
+        "1.6 PID_error",
+        "2.1 Transport_error",
+        "2.2 CRC_error",
+        "2.3a PCR_repetition_error",
+        "2.3b PCR_discontinuity_indicator_error",
+        "2.4 PCR_accuracy_error",
+        "2.5 PTS_error"
+    };
+
+    return (0 <= check && check < TR_CHECK_COUNT) ? s_names[check] : "unknown";
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+TSAnalyzer::TSAnalyzer()
+    : m_packets(0)
+    , m_position(0)
+    , m_synced(false)
+    , m_good(0)
+    , m_bad(0)
+    , m_pat_version(-1)
+    , m_pat_seen(0)
+    , m_clock_pid(-1)
+    , m_clock_pcr(0)
+    , m_clock_pos(0)
+    , m_clock_time(0)
+    , m_ticks_per_byte(0)
+    , m_average_pcr(0)
+    , m_average_pos(0)
+    , m_average_rate(0)
+{
+    struct pid_state st;
+    memset(&st, 0, sizeof(st));
+    st.cc      = -1;
+    st.version = -1;
+    st.owner   = 0x1fff;
+    m_pids.assign(TS_PID_COUNT, st);
+
+    memset(m_errors, 0, sizeof(m_errors));
+    memset(m_first, 0, sizeof(m_first));
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSAnalyzer::push(const uint8_t* packet)
+{
+    do
+    {
+        // 1.1 and 1.2: packets are expected at fixed positions
+        if (TS_SYNC_BYTE != ts_sync_byte::get(packet))
+        {
+            error(TR_SYNC_BYTE, 1);
+            m_good = 0;
+            m_bad += 1;
+            if (m_synced && SYNC_LOSS == m_bad)
+            {
+                error(TR_SYNC_LOSS, 1);
+                m_synced = false;
+            }
+            break;
+        }
+
+        m_bad = 0;
+        if (!m_synced && ++m_good >= SYNC_ACQUIRE)
+        {
+            m_synced = true;
+        }
+
+        uint16_t pid = ts_pid::get(packet);
+        pid_state& st = m_pids[pid];
+
+        if (ts_tei::get(packet))
+        {
+            error(TR_TRANSPORT, 1);
+        }
+
+        bool discontinuity = false;
+        bool has_pcr = false;
+        uint64_t pcr = 0;
+        const uint8_t* af = &packet[TS_PACKET_HEADER];
+        size_t af_size = af_length::get(af);
+        if ((ts_afc::get(packet) & 0x02) && 0 != af_size &&
+            af_size < TS_PACKET_PAYLOAD)
+        {
+            discontinuity = af_discontinuity::get(af);
+            has_pcr = (STATUS_OK == parse_pcr(packet, pcr));
+        }
+
+        if (0x1fff != pid)
+        {
+            check_cc(packet, discontinuity);
+        }
+
+        bool scrambled = (0 != ts_scrambling::get(packet));
+        if (scrambled && 0 == pid)
+        {
+            error(TR_PAT, 1);
+        }
+
+        if (scrambled && (st.role & ROLE_PMT))
+        {
+            error(TR_PMT, 1);
+        }
+
+        if (st.role & ROLE_ES)
+        {
+            check_interval(st.seen, TR_PID_INTERVAL, TR_PID);
+        }
+        st.seen = now();
+
+        if (has_pcr)
+        {
+            check_pcr(pid, pcr, discontinuity);
+        }
+
+        if (!scrambled && (0 == pid || 1 == pid || (st.role & ROLE_PMT) ||
+            (SI_PID_NIT <= pid && pid <= SI_PID_TDT)))
+        {
+            check_sections(packet);
+        }
+
+        if (!scrambled && (st.role & ROLE_PTS) && ts_pusi::get(packet))
+        {
+            const uint8_t* data = NULL;
+            size_t size = 0;
+            struct pes_header pes;
+            if (STATUS_OK == parse_payload(packet, data, size) &&
+                STATUS_OK == parse_pes_header(data, size, pes) && pes.has_pts)
+            {
+                check_interval(st.pts_seen, TR_PTS_INTERVAL, TR_PTS);
+                st.pts_seen = now();
+            }
+        }
+
+    } while(0);
+
+    m_packets += 1;
+    m_position += TS_PACKET_SIZE;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSAnalyzer::finish()
+{
+    sweep();
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+uint64_t TSAnalyzer::errors(int check) const
+{
+    return (0 <= check && check < TR_CHECK_COUNT) ? m_errors[check] : 0;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSAnalyzer::report(FILE* out) const
+{
+    fprintf(out, "TR 101 290 analysis (%llu packets):\n",
+        (unsigned long long)m_packets);
+
+    for (int i = 0; i < TR_CHECK_COUNT; ++i)
+    {
+        fprintf(out, "\t%-40s%llu", tr_check_name(i),
+            (unsigned long long)m_errors[i]);
+        if (0 != m_errors[i])
+        {
+            fprintf(out, " (first at byte %llu)",
+                (unsigned long long)m_first[i]);
+        }
+        fprintf(out, "\n");
+    }
+
+    fprintf(out, "\t%-40s%llu\n", "Repeated sections (CRC skipped)",
+        (unsigned long long)m_checked.hits());
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSAnalyzer::error(int check, uint64_t count)
+{
+    if (0 == m_errors[check])
+    {
+        m_first[check] = m_position;
+    }
+    m_errors[check] += count;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSAnalyzer::check_interval(uint64_t& last, uint64_t limit, int check)
+{
+    uint64_t time = now();
+
+    // Stream time is unknown until the clock PID has PCR
+    if (-1 != m_clock_pid && time > last && time - last > limit)
+    {
+        uint64_t count = (time - last) / limit;
+        error(check, count);
+        last += count * limit;
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+uint64_t TSAnalyzer::now() const
+{
+    // Rate of variable bitrate stream changes, so time isn't extrapolated
+    // further than PCR may be absent
+    double ahead = (double)(m_position - m_clock_pos) * m_ticks_per_byte;
+
+    return m_clock_time + ((ahead < TR_PCR_INTERVAL) ?
+        (uint64_t)ahead : TR_PCR_INTERVAL);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSAnalyzer::check_cc(const uint8_t* packet, bool discontinuity)
+{
+    pid_state& st = m_pids[ts_pid::get(packet)];
+    int cc = ts_cc::get(packet);
+
+    do
+    {
+        if (-1 == st.cc || discontinuity)
+        {
+            st.dups = 0;
+            break;
+        }
+
+        // Counter isn't incremented by packets without payload
+        if (0 == (ts_afc::get(packet) & 0x01))
+        {
+            if (cc != st.cc)
+            {
+                error(TR_CC, 1);
+            }
+            break;
+        }
+
+        // Packet may be sent twice, but not more
+        if (cc == st.cc)
+        {
+            st.dups += 1;
+            if (1 < st.dups)
+            {
+                error(TR_CC, 1);
+            }
+            break;
+        }
+
+        if (((st.cc + 1) & 0x0f) != cc)
+        {
+            error(TR_CC, 1);
+        }
+        st.dups = 0;
+
+    } while(0);
+
+    st.cc = cc;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSAnalyzer::check_pcr(uint16_t pid, uint64_t pcr, bool discontinuity)
+{
+    pid_state& st = m_pids[pid];
+    bool repeated = st.has_pcr;
+    bool restart = discontinuity || !st.has_pcr;
+
+    if (-1 == m_clock_pid)
+    {
+        m_clock_pid = pid;
+    }
+
+    if (!restart)
+    {
+        /**
+        ************************************************************************
+        * @note     PCR going backwards wraps to large delta, so both jumps
+        *           are caught by the same limit
+        ************************************************************************
+        */
+        uint64_t delta = (pcr + PCR_WRAP - st.pcr) % PCR_WRAP;
+        if (delta > TR_PCR_INTERVAL)
+        {
+            error(TR_PCR_DISCONTINUITY, 1);
+            restart = true;
+        }
+        else if (0 != m_average_rate)
+        {
+            double expected = (double)(m_position - st.pcr_pos) *
+                m_average_rate;
+            double jitter = expected - (double)delta;
+            if (jitter > TR_PCR_JITTER || jitter < -TR_PCR_JITTER)
+            {
+                error(TR_PCR_ACCURACY, 1);
+            }
+        }
+    }
+
+    if (pid == m_clock_pid)
+    {
+        /**
+        ************************************************************************
+        * @note     Stream time follows PCR. Over discontinuity it goes on with
+        *           the last rate, average rate is measured again
+        ************************************************************************
+        */
+        uint64_t delta = (pcr + PCR_WRAP - m_clock_pcr) % PCR_WRAP;
+        if (restart)
+        {
+            m_clock_time = now();
+            m_average_pcr = pcr;
+            m_average_pos = m_position;
+        }
+        else
+        {
+            m_clock_time += delta;
+            m_ticks_per_byte = (double)delta /
+                (double)(m_position - m_clock_pos);
+
+            uint64_t span = (pcr + PCR_WRAP - m_average_pcr) % PCR_WRAP;
+            m_average_rate = (double)span /
+                (double)(m_position - m_average_pos);
+        }
+        m_clock_pcr = pcr;
+        m_clock_pos = m_position;
+    }
+
+    if (repeated)
+    {
+        check_interval(st.pcr_seen, TR_PCR_INTERVAL, TR_PCR_REPETITION);
+    }
+
+    st.has_pcr  = true;
+    st.pcr      = pcr;
+    st.pcr_pos  = m_position;
+    st.pcr_seen = now();
+
+    if (pid == m_clock_pid)
+    {
+        sweep();
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSAnalyzer::check_sections(const uint8_t* packet)
+{
+    uint16_t pid = ts_pid::get(packet);
+    pid_state& st = m_pids[pid];
+    SectionAssembler& assembler = m_sections[pid];
+
+    assembler.push(packet);
+
+    const uint8_t* section = NULL;
+    size_t size = 0;
+    while (STATUS_OK == assembler.next_section(section, size))
+    {
+        int table_id = psi_table_id::get(section);
+        bool pat = (0 == pid && 0x00 == table_id);
+        bool pmt = ((st.role & ROLE_PMT) && 0x02 == table_id);
+
+        if (0 == pid && !pat)
+        {
+            error(TR_PAT, 1);
+            continue;
+        }
+
+        if (pat)
+        {
+            check_interval(m_pat_seen, TR_PAT_INTERVAL, TR_PAT);
+            m_pat_seen = now();
+        }
+
+        if (pmt)
+        {
+            check_interval(st.pmt_seen, TR_PAT_INTERVAL, TR_PMT);
+            st.pmt_seen = now();
+        }
+
+        // Only TDT, RST and stuffing sections of SI PIDs have no CRC
+        if (!psi_syntax_indicator::get(section) && 0x73 != table_id)
+        {
+            continue;
+        }
+
+        // Repeated section is compared with its checked copy instead of CRC
+        bool cached = m_checked.find(pid, section, size);
+        if (!cached && (size < PSI_HEADER_SIZE + 4 ||
+            0 != psi_crc32(section, size)))
+        {
+            error(TR_CRC, 1);
+            continue;
+        }
+
+        if (!cached)
+        {
+            m_checked.insert(pid, section, size);
+        }
+
+        // Checked copy was applied already unless a new PAT has reset roles
+        int version = psi_version::get(section);
+        bool applied = cached && version == (pat ? m_pat_version :
+            (int)st.version);
+        if ((pat || pmt) && !applied)
+        {
+            update_roles(section, size, pid);
+        }
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSAnalyzer::update_roles(const uint8_t* section, size_t size,
+    uint16_t pid)
+{
+    int version = psi_version::get(section);
+
+    do
+    {
+        if (!psi_current_next::get(section))
+        {
+            break;
+        }
+
+        /**
+        ************************************************************************
+        * @note     New PAT resets all roles. PMTs are taken again on their
+        *           next occurrence, timeouts of their PIDs restart from there
+        ************************************************************************
+        */
+        if (0 == pid)
+        {
+            struct psi_pat pat;
+            if (version == m_pat_version ||
+                STATUS_OK != parse_pat(section, size, pat))
+            {
+                break;
+            }
+            m_pat_version = version;
+
+            for (size_t i = 0; i < m_watched.size(); ++i)
+            {
+                pid_state& st = m_pids[m_watched[i]];
+                st.role    = 0;
+                st.version = -1;
+                st.owner   = 0x1fff;
+            }
+
+            for (size_t i = 0; i < pat.programs.size(); ++i)
+            {
+                if (0 != pat.programs[i].number)
+                {
+                    pid_state& st = m_pids[pat.programs[i].pid];
+                    st.role    |= ROLE_PMT;
+                    st.pmt_seen = now();
+                }
+            }
+        }
+        else
+        {
+            pid_state& pmt_st = m_pids[pid];
+            struct psi_pmt pmt;
+            if (version == pmt_st.version ||
+                STATUS_OK != parse_pmt(section, size, pmt))
+            {
+                break;
+            }
+            pmt_st.version = version;
+
+            // Roles of the previous version are dropped, kept ones continue
+            std::map<uint16_t, uint8_t> previous;
+            for (size_t i = 0; i < m_watched.size(); ++i)
+            {
+                pid_state& st = m_pids[m_watched[i]];
+                if (pid == st.owner)
+                {
+                    previous[m_watched[i]] = st.role;
+                    st.role &= ROLE_PMT;
+                    st.owner = 0x1fff;
+                }
+            }
+
+            for (size_t i = 0; i <= pmt.streams.size(); ++i)
+            {
+                uint16_t es_pid = pmt.pcr_pid;
+                uint8_t role = ROLE_PCR;
+                if (i < pmt.streams.size())
+                {
+                    struct ts_stream_info info;
+                    parse_stream_info(pmt.streams[i], info);
+                    es_pid = info.pid;
+                    role = (STREAM_VIDEO == info.kind ||
+                        STREAM_AUDIO == info.kind) ? ROLE_ES | ROLE_PTS : 0;
+                }
+
+                if (0 == role || 0x1fff == es_pid)
+                {
+                    continue;
+                }
+
+                pid_state& st = m_pids[es_pid];
+                std::map<uint16_t, uint8_t>::iterator it =
+                    previous.find(es_pid);
+                uint8_t added = role & ~((previous.end() != it) ?
+                    it->second : st.role);
+
+                st.seen     = (added & ROLE_ES) ? now() : st.seen;
+                st.pts_seen = (added & ROLE_PTS) ? now() : st.pts_seen;
+                st.pcr_seen = (added & ROLE_PCR) ? now() : st.pcr_seen;
+                st.role    |= role;
+                st.owner    = pid;
+            }
+        }
+
+        m_watched.clear();
+        for (uint16_t i = 0; i < TS_PID_COUNT; ++i)
+        {
+            if (0 != m_pids[i].role)
+            {
+                m_watched.push_back(i);
+            }
+        }
+
+    } while(0);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSAnalyzer::sweep()
+{
+    check_interval(m_pat_seen, TR_PAT_INTERVAL, TR_PAT);
+
+    for (size_t i = 0; i < m_watched.size(); ++i)
+    {
+        pid_state& st = m_pids[m_watched[i]];
+
+        if (st.role & ROLE_PMT)
+        {
+            check_interval(st.pmt_seen, TR_PAT_INTERVAL, TR_PMT);
+        }
+
+        if (st.role & ROLE_ES)
+        {
+            check_interval(st.seen, TR_PID_INTERVAL, TR_PID);
+        }
+
+        if (st.role & ROLE_PCR)
+        {
+            check_interval(st.pcr_seen, TR_PCR_INTERVAL, TR_PCR_REPETITION);
+        }
+
+        if (st.role & ROLE_PTS)
+        {
+            check_interval(st.pts_seen, TR_PTS_INTERVAL, TR_PTS);
+        }
+    }
+}
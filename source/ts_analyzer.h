@@ -0,0 +1,257 @@
+/**
+********************************************************************************
+* @file         ts_analyzer.h
+* @brief        TR 101 290 priority 1 and 2 checks of MPEG-TS stream
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _TS_ANALYZER_H_
+#define _TS_ANALYZER_H_
+
+#include <map>
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "ts_processor.h"
+#include "ts_section.h"
+
+/**
+********************************************************************************
+* @enum         TR_CHECK
+* @brief        TR 101 290 indicators counted by TSAnalyzer
+********************************************************************************
+*/
+typedef enum
+{
+    TR_SYNC_LOSS = 0,           ///< 1.1 TS_sync_loss
+    TR_SYNC_BYTE,               ///< 1.2 Sync_byte_error
+    TR_PAT,                     ///< 1.3 PAT_error_2
+    TR_CC,                      ///< 1.4 Continuity_count_error
+    TR_PMT,                     ///< 1.5 PMT_error_2
+    TR_PID,                     ///< 1.6 PID_error
+    TR_TRANSPORT,               ///< 2.1 Transport_error
+    TR_CRC,                     ///< 2.2 CRC_error
+    TR_PCR_REPETITION,          ///< 2.3a PCR_repetition_error
+    TR_PCR_DISCONTINUITY,       ///< 2.3b PCR_discontinuity_indicator_error
+    TR_PCR_ACCURACY,            ///< 2.4 PCR_accuracy_error
+    TR_PTS,                     ///< 2.5 PTS_error
+    TR_CHECK_COUNT
+} TR_CHECK;
+
+/**
+********************************************************************************
+* @brief        Returns TR 101 290 name of the check
+* @param        [in] check  TR_CHECK value
+* @return       Name of the check
+********************************************************************************
+*/
+const char* tr_check_name(int check);
+
+/**
+********************************************************************************
+* @class        TSAnalyzer
+* @brief        Runs TR 101 290 priority 1 and 2 checks on every packet of
+*               the stream. PAT and PMTs are followed on its own, so all
+*               programs are checked, not only the demultiplexed one
+* @note         Intervals are measured in stream time: PCRs of the first PCR
+*               PID, interpolated by byte position between them. Timeouts of
+*               absent tables and PIDs are swept on each PCR of that PID and
+*               at the end of the stream. PCR accuracy is measured against
+*               the rate averaged since the last discontinuity, so it is
+*               meaningful for constant bitrate streams only
+********************************************************************************
+*/
+class TSAnalyzer
+{
+public:
+    TSAnalyzer();
+
+    /**
+    ****************************************************************************
+    * @brief    Checks next packet of the stream. Packets with wrong sync
+    *           byte must be given too, they are counted and skipped
+    * @param    [in] packet TS packet (TS_PACKET_SIZE bytes)
+    * @return   void
+    ****************************************************************************
+    */
+    void push(const uint8_t* packet);
+
+    /**
+    ****************************************************************************
+    * @brief    Checks timeouts at the end of the stream
+    * @return   void
+    ****************************************************************************
+    */
+    void finish(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Returns number of errors of the check
+    * @param    [in] check  TR_CHECK value
+    * @return   Number of errors
+    ****************************************************************************
+    */
+    uint64_t errors(int check) const;
+
+    /**
+    ****************************************************************************
+    * @brief    Prints counters of all checks
+    * @param    [in] out    Output stream
+    * @return   void
+    ****************************************************************************
+    */
+    void report(FILE* out) const;
+
+private:
+    /**
+    ****************************************************************************
+    * @struct   pid_state
+    * @brief    Per PID state of the checks
+    ****************************************************************************
+    */
+    struct pid_state
+    {
+        int8_t      cc;         ///< Last continuity counter, -1 if unknown
+        uint8_t     dups;       ///< Repetitions of the last packet
+        uint8_t     role;       ///< ROLE_* flags given by PAT and PMTs
+        int8_t      version;    ///< PMT version (PMT PID), -1 if unknown
+        uint16_t    owner;      ///< PMT PID which refers to the PID
+        uint64_t    seen;       ///< Stream time of the last packet
+        uint64_t    pmt_seen;   ///< Stream time of the last PMT section
+        uint64_t    pts_seen;   ///< Stream time of the last PTS
+        uint64_t    pcr_seen;   ///< Stream time of the last PCR
+        bool        has_pcr;    ///< PCR value is known
+        uint64_t    pcr;        ///< Last PCR value (27 MHz)
+        uint64_t    pcr_pos;    ///< Position of the last PCR value
+    };
+
+    /**
+    ****************************************************************************
+    * @brief    Roles of PIDs
+    ****************************************************************************
+    */
+    enum
+    {
+        ROLE_PMT    = 0x01,     ///< PMT PID of PAT
+        ROLE_ES     = 0x02,     ///< Video or audio PID of PMT
+        ROLE_PCR    = 0x04,     ///< PCR PID of PMT
+        ROLE_PTS    = 0x08      ///< PTS repetition is checked
+    };
+
+    /**
+    ****************************************************************************
+    * @brief    Adds errors to the counter of the check
+    * @param    [in] check  TR_CHECK value
+    * @param    [in] count  Number of errors
+    * @return   void
+    ****************************************************************************
+    */
+    void error(int check, uint64_t count);
+
+    /**
+    ****************************************************************************
+    * @brief    Counts error for each limit exceeded since last occurrence
+    *           and moves last occurrence accordingly
+    * @param    [in,out] last   Stream time of the last occurrence
+    * @param    [in] limit      Maximal interval (27 MHz)
+    * @param    [in] check      TR_CHECK value
+    * @return   void
+    ****************************************************************************
+    */
+    void check_interval(uint64_t& last, uint64_t limit, int check);
+
+    /**
+    ****************************************************************************
+    * @brief    Returns stream time of the current packet
+    * @return   Time since the first PCR of the clock PID (27 MHz)
+    ****************************************************************************
+    */
+    uint64_t now(void) const;
+
+    /**
+    ****************************************************************************
+    * @brief    Checks continuity counter of the packet
+    * @param    [in] packet         TS packet
+    * @param    [in] discontinuity  discontinuity_indicator is set
+    * @return   void
+    ****************************************************************************
+    */
+    void check_cc(const uint8_t* packet, bool discontinuity);
+
+    /**
+    ****************************************************************************
+    * @brief    Checks PCR of the packet
+    * @param    [in] pid            PID of the packet
+    * @param    [in] pcr            PCR value (27 MHz)
+    * @param    [in] discontinuity  discontinuity_indicator is set
+    * @return   void
+    ****************************************************************************
+    */
+    void check_pcr(uint16_t pid, uint64_t pcr, bool discontinuity);
+
+    /**
+    ****************************************************************************
+    * @brief    Checks sections of PSI/SI PID: table IDs, CRC and repetition
+    *           of PAT and PMT, follows PAT and PMT changes
+    * @param    [in] packet TS packet
+    * @return   void
+    ****************************************************************************
+    */
+    void check_sections(const uint8_t* packet);
+
+    /**
+    ****************************************************************************
+    * @brief    Updates roles of PIDs by new PAT or PMT version
+    * @param    [in] section    Section with correct CRC
+    * @param    [in] size       Size of the section
+    * @param    [in] pid        PID of the section
+    * @return   void
+    ****************************************************************************
+    */
+    void update_roles(const uint8_t* section, size_t size, uint16_t pid);
+
+    /**
+    ****************************************************************************
+    * @brief    Checks timeouts of PAT, PMTs, PIDs, PCRs and PTSs
+    * @return   void
+    ****************************************************************************
+    */
+    void sweep(void);
+
+private:    // Blocked implementations
+    TSAnalyzer(const TSAnalyzer& r);
+    TSAnalyzer& operator= (const TSAnalyzer&);
+
+private:
+    std::vector<pid_state>  m_pids;     ///< State of all PIDs
+    std::vector<uint16_t>   m_watched;  ///< PIDs with roles
+    std::map<uint16_t, SectionAssembler> m_sections; ///< PSI/SI assemblers
+    SectionCache    m_checked;          ///< Sections with correct CRC
+
+    uint64_t        m_packets;          ///< Packets checked
+    uint64_t        m_position;         ///< Position of the current packet
+    bool            m_synced;           ///< Sync is acquired
+    int             m_good;             ///< Consecutive correct sync bytes
+    int             m_bad;              ///< Consecutive corrupted sync bytes
+
+    int             m_pat_version;      ///< PAT version, -1 if unknown
+    uint64_t        m_pat_seen;         ///< Stream time of the last PAT
+
+    int             m_clock_pid;        ///< PCR PID of stream time, -1 if none
+    uint64_t        m_clock_pcr;        ///< Last PCR of the clock PID
+    uint64_t        m_clock_pos;        ///< Position of that PCR
+    uint64_t        m_clock_time;       ///< Stream time of that PCR
+    double          m_ticks_per_byte;   ///< Rate between its last PCRs
+
+    uint64_t        m_average_pcr;      ///< First PCR of average rate
+    uint64_t        m_average_pos;      ///< Position of that PCR
+    double          m_average_rate;     ///< Average rate, 0 if unknown
+
+    uint64_t        m_errors[TR_CHECK_COUNT];   ///< Errors of each check
+    uint64_t        m_first[TR_CHECK_COUNT];    ///< Packet of the first error
+};
+
+#endif  /* !_TS_ANALYZER_H_ */
@@ -0,0 +1,761 @@
+/**
+********************************************************************************
+* @file         ts_catalog.cpp
+* @brief        Keyframe catalog of many MPEG-TS files: parallel builder and
+*               memory mapped reader
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "ts_catalog.h"
+#include "ts_fields.h"
+#include "ts_parse.h"
+#include "ts_section.h"
+#include "ts_descriptors.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+********************************************************************************
+* @brief        Checks whether ES data of PES start has keyframe start code:
+*               SPS or IDR slice of H.264, VPS or IRAP slice of HEVC, sequence
+*               header of MPEG-1/2 video
+* @param        [in] codec  Codec of the stream
+* @param        [in] data   ES data
+* @param        [in] size   Size of ES data
+* @return       true if keyframe start code is found
+********************************************************************************
+*/
+static bool has_keyframe_code(STREAM_CODEC codec, const uint8_t* data,
+    size_t size)
+{
+    for (size_t i = 0; i + 3 < size; ++i)
+    {
+        if (0 != data[i] || 0 != data[i + 1] || 1 != data[i + 2])
+        {
+            continue;
+        }
+
+        uint8_t code = data[i + 3];
+        switch (codec)
+        {
+            case CODEC_H264:
+                if (5 == (code & 0x1f) || 7 == (code & 0x1f))
+                {
+                    return true;
+                }
+                break;
+
+            case CODEC_HEVC:
+                code = (code >> 1) & 0x3f;
+                if ((code >= 16 && code <= 21) || 32 == code)
+                {
+                    return true;
+                }
+                break;
+
+            case CODEC_MPEG1V:
+            case CODEC_MPEG2V:
+                if (0xb3 == code)
+                {
+                    return true;
+                }
+                break;
+
+            default:
+                return false;
+        }
+    }
+
+    return false;
+}
+
+/**
+********************************************************************************
+* @class        ByName
+* @brief        Orders file numbers by file names
+********************************************************************************
+*/
+class ByName
+{
+public:
+    explicit ByName(const std::vector<std::string>& names) : m_names(names) {}
+
+    bool operator() (size_t a, size_t b) const
+    {
+        return m_names[a] < m_names[b];
+    }
+
+private:
+    const std::vector<std::string>& m_names;    ///< Names of files
+};
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS build_keyframe_index(const char* filename,
+    std::vector<struct catalog_keyframe>& keyframes, uint16_t& pid,
+    uint64_t& size)
+{
+    STATUS result = STATUS_FAIL;
+    FILE* file = NULL;
+
+    keyframes.clear();
+    pid  = 0;
+    size = 0;
+
+    do
+    {
+        file = fopen(filename, "rb");
+        if (NULL == file)
+        {
+            fprintf(stderr, "Can't open input file (%s). Error: %s\n",
+                filename, strerror(errno));
+            break;
+        }
+
+        std::vector<uint8_t> buffer(TS_READ_PACKETS * TS_PACKET_SIZE);
+        SectionAssembler sections;
+        int pmt_pid = -1;
+        int es_pid = -1;
+        STREAM_CODEC codec = CODEC_UNKNOWN;
+        bool video = false;
+
+        // PTS is continued across wrap around, so keyframes stay sorted
+        uint64_t epoch = 0;
+        uint64_t last = 0;
+        bool has_last = false;
+
+        size_t read_bytes = 0;
+        while (0 != (read_bytes = fread(&buffer[0], 1, buffer.size(), file)))
+        {
+            for (size_t i = 0; i + TS_PACKET_SIZE <= read_bytes;
+                i += TS_PACKET_SIZE)
+            {
+                const uint8_t* packet = &buffer[i];
+                int packet_pid = ts_pid::get(packet);
+                if (TS_SYNC_BYTE != ts_sync_byte::get(packet) ||
+                    0 != ts_scrambling::get(packet))
+                {
+                    continue;
+                }
+
+                if ((0 == packet_pid && pmt_pid < 0) ||
+                    (packet_pid == pmt_pid && es_pid < 0))
+                {
+                    sections.push(packet);
+
+                    const uint8_t* section = NULL;
+                    size_t section_size = 0;
+                    while (STATUS_OK == sections.next_section(section,
+                        section_size))
+                    {
+                        struct psi_pat pat;
+                        struct psi_pmt pmt;
+                        if (0 != psi_crc32(section, section_size))
+                        {
+                            continue;
+                        }
+
+                        if (0 == packet_pid &&
+                            STATUS_OK == parse_pat(section, section_size, pat))
+                        {
+                            for (size_t j = 0; j < pat.programs.size() &&
+                                pmt_pid < 0; ++j)
+                            {
+                                if (0 != pat.programs[j].number)
+                                {
+                                    pmt_pid = pat.programs[j].pid;
+                                    sections = SectionAssembler();
+                                }
+                            }
+                            break;
+                        }
+
+                        if (0 == packet_pid || STATUS_OK != parse_pmt(section,
+                            section_size, pmt))
+                        {
+                            continue;
+                        }
+
+                        // The first video stream, the first audio otherwise
+                        for (size_t j = 0; j < pmt.streams.size() && !video;
+                            ++j)
+                        {
+                            struct ts_stream_info info;
+                            parse_stream_info(pmt.streams[j], info);
+                            video = (STREAM_VIDEO == info.kind);
+                            if (video || (es_pid < 0 &&
+                                STREAM_AUDIO == info.kind))
+                            {
+                                es_pid = info.pid;
+                                codec  = info.codec;
+                            }
+                        }
+                    }
+                    continue;
+                }
+
+                const uint8_t* payload = NULL;
+                size_t payload_size = 0;
+                struct pes_header pes;
+                if (packet_pid != es_pid || !ts_pusi::get(packet) ||
+                    STATUS_OK != parse_payload(packet, payload, payload_size) ||
+                    STATUS_OK != parse_pes_header(payload, payload_size, pes) ||
+                    !pes.has_pts)
+                {
+                    continue;
+                }
+
+                uint64_t pts = epoch + pes.pts;
+                if (has_last && pts + (PTS_MASK >> 1) < last)
+                {
+                    epoch += PTS_MASK + 1;
+                    pts   += PTS_MASK + 1;
+                }
+                else if (has_last && pts > last + (PTS_MASK >> 1) &&
+                    0 != epoch)
+                {
+                    pts -= PTS_MASK + 1;    // Reordered frame before wrap
+                }
+                has_last = true;
+                last = pts;
+
+                const uint8_t* af = &packet[TS_PACKET_HEADER];
+                bool random_access = (ts_afc::get(packet) & 0x02) &&
+                    0 != af_length::get(af) && af_random_access::get(af);
+
+                bool keyframe = video ? (random_access || has_keyframe_code(
+                    codec, payload + pes.header_size,
+                    payload_size - pes.header_size)) : (keyframes.empty() ||
+                    pts >= keyframes.back().pts + CATALOG_AUDIO_INTERVAL);
+                if (keyframe)
+                {
+                    struct catalog_keyframe entry;
+                    entry.pts    = pts;
+                    entry.offset = size + i;
+                    keyframes.push_back(entry);
+                }
+            }
+            size += read_bytes;
+        }
+
+        if (ferror(file))
+        {
+            fprintf(stderr, "Can't read input file (%s). Error: %s\n",
+                filename, strerror(errno));
+            break;
+        }
+
+        if (es_pid < 0)
+        {
+            fprintf(stderr, "No video or audio stream in %s!\n", filename);
+            break;
+        }
+
+        pid = es_pid;
+        result = STATUS_OK;
+
+    } while(0);
+
+    if (NULL != file)
+    {
+        fclose(file);
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+CatalogBuilder::CatalogBuilder(const char* const filename, unsigned threads)
+    : m_filename(filename)
+    , m_threads(threads)
+    , m_fd(-1)
+    , m_next(0)
+    , m_end(sizeof(struct catalog_header))
+    , m_status(STATUS_OK)
+{
+    pthread_mutex_init(&m_lock, NULL);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+CatalogBuilder::~CatalogBuilder()
+{
+    if (-1 != m_fd)
+    {
+        close(m_fd);
+    }
+
+    pthread_mutex_destroy(&m_lock);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void CatalogBuilder::add_file(const char* const filename)
+{
+    m_names.push_back(filename);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS CatalogBuilder::run()
+{
+    STATUS result = STATUS_FAIL;
+
+    do
+    {
+        m_fd = open(m_filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (-1 == m_fd)
+        {
+            fprintf(stderr, "Can't open catalog file (%s). Error: %s\n",
+                m_filename.c_str(), strerror(errno));
+            break;
+        }
+
+        struct catalog_file empty;
+        memset(&empty, 0, sizeof(empty));
+        m_files.assign(m_names.size(), empty);
+
+        size_t count = std::min<size_t>(m_threads, m_names.size());
+        std::vector<pthread_t> threads(count);
+        size_t started = 0;
+        for (; started < count; ++started)
+        {
+            if (0 != pthread_create(&threads[started], NULL, worker_loop,
+                this))
+            {
+                fprintf(stderr, "Can't start indexing thread\n");
+                break;
+            }
+        }
+
+        // Started threads index all files, even if some failed to start
+        for (size_t i = 0; i < started; ++i)
+        {
+            pthread_join(threads[i], NULL);
+        }
+
+        if ((0 == started && !m_names.empty()) || STATUS_OK != m_status)
+        {
+            break;
+        }
+
+        result = write_tables();
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void* CatalogBuilder::worker_loop(void* arg)
+{
+    CatalogBuilder* builder = static_cast<CatalogBuilder*>(arg);
+
+    while (true)
+    {
+        pthread_mutex_lock(&builder->m_lock);
+        size_t n = builder->m_next;
+        bool done = (n >= builder->m_names.size() ||
+            STATUS_OK != builder->m_status);
+        builder->m_next += done ? 0 : 1;
+        pthread_mutex_unlock(&builder->m_lock);
+
+        if (done)
+        {
+            break;
+        }
+
+        if (STATUS_OK != builder->index_file(n))
+        {
+            pthread_mutex_lock(&builder->m_lock);
+            builder->m_status = STATUS_FAIL;
+            pthread_mutex_unlock(&builder->m_lock);
+        }
+    }
+
+    return NULL;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS CatalogBuilder::index_file(size_t n)
+{
+    std::vector<struct catalog_keyframe> keyframes;
+    uint16_t pid = 0;
+    uint64_t size = 0;
+
+    // File which can't be indexed is listed without keyframes
+    STATUS indexed = build_keyframe_index(m_names[n].c_str(), keyframes, pid,
+        size);
+    size_t bytes = keyframes.size() * sizeof(struct catalog_keyframe);
+
+    pthread_mutex_lock(&m_lock);
+    uint64_t offset = m_end;
+    m_end += bytes;
+    pthread_mutex_unlock(&m_lock);
+
+    // Each thread fills its own entries of the table
+    struct catalog_file& entry = m_files[n];
+    entry.index_offset = offset;
+    entry.index_count  = keyframes.size();
+    entry.file_size    = size;
+    entry.pid          = (STATUS_OK == indexed) ? pid : 0;
+
+    fprintf(stdout, "Indexed %s: %llu keyframes of PID %u, result: %s\n",
+        m_names[n].c_str(), (unsigned long long)keyframes.size(), pid,
+        (STATUS_OK == indexed) ? "success" : "fail");
+
+    return (0 != bytes) ? write_at(&keyframes[0], bytes, offset) : STATUS_OK;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS CatalogBuilder::write_tables()
+{
+    STATUS result = STATUS_FAIL;
+
+    do
+    {
+        // Table is sorted by names for binary search
+        std::vector<size_t> order(m_names.size());
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), ByName(m_names));
+
+        std::vector<struct catalog_file> table(order.size());
+        std::string names;
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            table[i] = m_files[order[i]];
+            table[i].name_offset = names.size();
+            table[i].name_size   = m_names[order[i]].size();
+            names += m_names[order[i]];
+            names += '\0';
+        }
+
+        if (names.size() > UINT_MAX)
+        {
+            fprintf(stderr, "File names don't fit into catalog\n");
+            break;
+        }
+
+        struct catalog_header header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, CATALOG_MAGIC, sizeof(header.magic));
+        header.version      = CATALOG_VERSION;
+        header.file_count   = table.size();
+        header.files_offset = m_end;
+        header.names_offset = m_end + table.size() *
+            sizeof(struct catalog_file);
+
+        if ((!table.empty() && STATUS_OK != write_at(&table[0],
+            table.size() * sizeof(struct catalog_file), header.files_offset)) ||
+            STATUS_OK != write_at(names.data(), names.size(),
+            header.names_offset))
+        {
+            break;
+        }
+
+        // Header is the last, catalog isn't valid until it is written
+        result = write_at(&header, sizeof(header), 0);
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS CatalogBuilder::write_at(const void* data, size_t size,
+    uint64_t offset)
+{
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+
+    while (0 != size)
+    {
+        ssize_t r = pwrite(m_fd, p, size, offset);
+        if (r > 0)
+        {
+            p      += r;
+            size   -= r;
+            offset += r;
+            continue;
+        }
+
+        if (-1 == r && EINTR == errno)
+        {
+            continue;
+        }
+
+        fprintf(stderr, "Can't write catalog file (%s). Error: %s\n",
+            m_filename.c_str(), strerror(errno));
+        return STATUS_FAIL;
+    }
+
+    return STATUS_OK;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+TSCatalog::TSCatalog()
+    : m_data(NULL)
+    , m_size(0)
+    , m_header(NULL)
+    , m_files(NULL)
+    , m_names(NULL)
+{
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+TSCatalog::~TSCatalog()
+{
+    if (NULL != m_data)
+    {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSCatalog::open(const char* const filename)
+{
+    STATUS result = STATUS_FAIL;
+    int fd = -1;
+
+    do
+    {
+        fd = ::open(filename, O_RDONLY);
+        struct stat st;
+        if (-1 == fd || 0 != fstat(fd, &st))
+        {
+            fprintf(stderr, "Can't open catalog file (%s). Error: %s\n",
+                filename, strerror(errno));
+            break;
+        }
+
+        m_size = st.st_size;
+        if (m_size < sizeof(struct catalog_header))
+        {
+            fprintf(stderr, "Wrong catalog file (%s)\n", filename);
+            break;
+        }
+
+        void* data = mmap(NULL, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (MAP_FAILED == data)
+        {
+            fprintf(stderr, "Can't map catalog file (%s). Error: %s\n",
+                filename, strerror(errno));
+            break;
+        }
+        m_data = static_cast<const uint8_t*>(data);
+
+        /**
+        ************************************************************************
+        * @note     Layout is validated once, so lookups trust the offsets.
+        *           All tables must be aligned and inside of the file, names
+        *           must be zero terminated
+        ************************************************************************
+        */
+        const struct catalog_header* h =
+            reinterpret_cast<const struct catalog_header*>(m_data);
+        bool valid = (0 == memcmp(h->magic, CATALOG_MAGIC,
+            sizeof(h->magic)) && CATALOG_VERSION == h->version &&
+            0 == h->files_offset % 8 && h->files_offset <= m_size &&
+            h->file_count <= (m_size - h->files_offset) /
+            sizeof(struct catalog_file) && h->names_offset == h->files_offset +
+            h->file_count * sizeof(struct catalog_file));
+
+        const struct catalog_file* files = valid ?
+            reinterpret_cast<const struct catalog_file*>(&m_data[
+            h->files_offset]) : NULL;
+        size_t names_size = valid ? m_size - h->names_offset : 0;
+        for (size_t i = 0; valid && i < h->file_count; ++i)
+        {
+            const struct catalog_file& f = files[i];
+            valid = (0 == f.index_offset % 8 && f.index_offset <= m_size &&
+                f.index_count <= (m_size - f.index_offset) /
+                sizeof(struct catalog_keyframe) &&
+                f.name_offset < names_size &&
+                f.name_size < names_size - f.name_offset &&
+                '\0' == m_data[h->names_offset + f.name_offset + f.name_size]);
+        }
+
+        if (!valid)
+        {
+            fprintf(stderr, "Wrong catalog file (%s)\n", filename);
+            break;
+        }
+
+        m_header = h;
+        m_files  = files;
+        m_names  = reinterpret_cast<const char*>(&m_data[h->names_offset]);
+        result = STATUS_OK;
+
+    } while(0);
+
+    if (-1 != fd)
+    {
+        close(fd);
+    }
+
+    if (STATUS_OK != result && NULL != m_data)
+    {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+        m_data = NULL;
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+size_t TSCatalog::files() const
+{
+    return (NULL != m_header) ? m_header->file_count : 0;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+const struct catalog_file& TSCatalog::file(size_t n) const
+{
+    return m_files[n];
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+const char* TSCatalog::name(size_t n) const
+{
+    return &m_names[m_files[n].name_offset];
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+int TSCatalog::find_file(const char* const name) const
+{
+    size_t low = 0;
+    size_t high = files();
+
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        int cmp = strcmp(this->name(mid), name);
+        if (0 == cmp)
+        {
+            return mid;
+        }
+
+        if (cmp < 0)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return -1;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+const struct catalog_keyframe* TSCatalog::keyframes(size_t n) const
+{
+    return reinterpret_cast<const struct catalog_keyframe*>(
+        &m_data[m_files[n].index_offset]);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+const struct catalog_keyframe* TSCatalog::find_keyframe(size_t n,
+    uint64_t pts) const
+{
+    const struct catalog_keyframe* keys = keyframes(n);
+    size_t low = 0;
+    size_t high = m_files[n].index_count;
+
+    // The first keyframe after PTS
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        if (keys[mid].pts <= pts)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return (0 != low) ? &keys[low - 1] : NULL;
+}
@@ -0,0 +1,299 @@
+/**
+********************************************************************************
+* @file         ts_catalog.h
+* @brief        Keyframe catalog of many MPEG-TS files: parallel builder and
+*               memory mapped reader
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _TS_CATALOG_H_
+#define _TS_CATALOG_H_
+
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "ts_processor.h"
+
+/**
+********************************************************************************
+* @def          CATALOG_MAGIC
+* @brief        Signature at the beginning of catalog file (8 bytes)
+********************************************************************************
+*/
+#define CATALOG_MAGIC       "TSCATLG"
+
+/**
+********************************************************************************
+* @def          CATALOG_VERSION
+* @brief        Version of catalog layout
+********************************************************************************
+*/
+#define CATALOG_VERSION     1
+
+/**
+********************************************************************************
+* @def          CATALOG_AUDIO_INTERVAL
+* @brief        Minimal distance between entries of audio-only files (90 kHz)
+********************************************************************************
+*/
+#define CATALOG_AUDIO_INTERVAL  90000
+
+/**
+********************************************************************************
+* @struct       catalog_header
+* @brief        Header of catalog file. Catalog is written in host byte order
+*               and consists of the header, keyframe indexes of all files
+*               (in order of completion), file table sorted by name and file
+*               names (zero terminated)
+********************************************************************************
+*/
+struct catalog_header
+{
+    char        magic[8];       ///< CATALOG_MAGIC
+    uint32_t    version;        ///< CATALOG_VERSION
+    uint32_t    file_count;     ///< Number of entries of file table
+    uint64_t    files_offset;   ///< Offset of file table
+    uint64_t    names_offset;   ///< Offset of file names
+};
+
+/**
+********************************************************************************
+* @struct       catalog_file
+* @brief        Entry of file table
+********************************************************************************
+*/
+struct catalog_file
+{
+    uint64_t    index_offset;   ///< Offset of keyframes of the file
+    uint64_t    index_count;    ///< Number of keyframes
+    uint64_t    file_size;      ///< Size of indexed file
+    uint32_t    name_offset;    ///< Offset of the name after names_offset
+    uint32_t    name_size;      ///< Length of the name
+    uint16_t    pid;            ///< Indexed PID, 0 if file wasn't indexed
+    uint16_t    reserved[3];    ///< Zero
+};
+
+/**
+********************************************************************************
+* @struct       catalog_keyframe
+* @brief        Keyframe of the file
+********************************************************************************
+*/
+struct catalog_keyframe
+{
+    uint64_t    pts;            ///< PTS continued across wrap around (90 kHz)
+    uint64_t    offset;         ///< Position of the first packet of its PES
+};
+
+/**
+********************************************************************************
+* @brief        Builds keyframe index of MPEG-TS file: video PES which start
+*               with random access indicator or parameter set (audio PES
+*               once per CATALOG_AUDIO_INTERVAL if there is no video)
+* @param        [in] filename   MPEG-TS file name
+* @param        [out] keyframes Keyframes of the file
+* @param        [out] pid       Indexed PID
+* @param        [out] size      Size of the file
+* @return       STATUS_OK on success, STATUS_FAIL if file can't be read or
+*               has no video and audio
+********************************************************************************
+*/
+STATUS build_keyframe_index(const char* filename,
+    std::vector<struct catalog_keyframe>& keyframes, uint16_t& pid,
+    uint64_t& size);
+
+/**
+********************************************************************************
+* @class        CatalogBuilder
+* @brief        Indexes files on a pool of threads and writes all indexes into
+*               single catalog file. Each thread takes the next file of the
+*               list, indexes it and appends its keyframes at the end of the
+*               catalog reserved under lock. File table is written last, so
+*               catalog is valid only when all files are processed
+********************************************************************************
+*/
+class CatalogBuilder
+{
+public:
+    /**
+    ****************************************************************************
+    * @brief    The only allowed constructor for this class
+    * @param    [in] filename    Output catalog file name
+    * @param    [in] threads     Number of indexing threads
+    ****************************************************************************
+    */
+    CatalogBuilder(const char* const filename, unsigned threads);
+
+    ~CatalogBuilder();
+
+    /**
+    ****************************************************************************
+    * @brief    Adds MPEG-TS file to the catalog
+    * @param    [in] filename    MPEG-TS file name
+    * @return   void
+    ****************************************************************************
+    */
+    void add_file(const char* const filename);
+
+    /**
+    ****************************************************************************
+    * @brief    Indexes all files and writes the catalog
+    * @return   STATUS_OK if catalog is written (files which can't be indexed
+    *           are listed without keyframes), STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS run(void);
+
+private:
+    /**
+    ****************************************************************************
+    * @brief    Indexing thread: takes files until the list is exhausted
+    * @param    [in] arg    Pointer to the builder
+    * @return   NULL
+    ****************************************************************************
+    */
+    static void* worker_loop(void* arg);
+
+    /**
+    ****************************************************************************
+    * @brief    Indexes file and appends its keyframes to the catalog
+    * @param    [in] n  Number of the file in the list
+    * @return   STATUS_OK on success, STATUS_FAIL if catalog can't be written
+    ****************************************************************************
+    */
+    STATUS index_file(size_t n);
+
+    /**
+    ****************************************************************************
+    * @brief    Writes file table, names and header
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS write_tables(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Writes block at the offset of the catalog
+    * @param    [in] data   Block
+    * @param    [in] size   Size of the block
+    * @param    [in] offset Offset in the catalog
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS write_at(const void* data, size_t size, uint64_t offset);
+
+private:    // Blocked implementations
+    CatalogBuilder();
+    CatalogBuilder(const CatalogBuilder& r);
+    CatalogBuilder& operator= (const CatalogBuilder&);
+
+private:
+    std::string     m_filename;         ///< Catalog file name
+    unsigned        m_threads;          ///< Number of indexing threads
+    int             m_fd;               ///< Catalog file descriptor
+
+    std::vector<std::string>            m_names;    ///< Files to index
+    std::vector<struct catalog_file>    m_files;    ///< Table by file number
+
+    pthread_mutex_t m_lock;             ///< Guards fields below
+    size_t          m_next;             ///< Next file to index
+    uint64_t        m_end;              ///< End of the catalog
+    STATUS          m_status;           ///< Result of writing
+};
+
+/**
+********************************************************************************
+* @class        TSCatalog
+* @brief        Read-only view of catalog file mapped into memory. Lookups
+*               are binary searches in the mapping: by name in the file table
+*               and by PTS in keyframes of the file
+********************************************************************************
+*/
+class TSCatalog
+{
+public:
+    TSCatalog();
+
+    ~TSCatalog();
+
+    /**
+    ****************************************************************************
+    * @brief    Maps catalog file and validates its layout
+    * @param    [in] filename   Catalog file name
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS open(const char* const filename);
+
+    /**
+    ****************************************************************************
+    * @brief    Returns number of files in the catalog
+    * @return   Number of files
+    ****************************************************************************
+    */
+    size_t files(void) const;
+
+    /**
+    ****************************************************************************
+    * @brief    Returns entry of file table
+    * @param    [in] n  Number of the file (sorted by name)
+    * @return   Entry of file table
+    ****************************************************************************
+    */
+    const struct catalog_file& file(size_t n) const;
+
+    /**
+    ****************************************************************************
+    * @brief    Returns name of the file
+    * @param    [in] n  Number of the file
+    * @return   Zero terminated name
+    ****************************************************************************
+    */
+    const char* name(size_t n) const;
+
+    /**
+    ****************************************************************************
+    * @brief    Searches for file by name
+    * @param    [in] name   File name as given to the builder
+    * @return   Number of the file, -1 if there is no such file
+    ****************************************************************************
+    */
+    int find_file(const char* const name) const;
+
+    /**
+    ****************************************************************************
+    * @brief    Returns keyframes of the file
+    * @param    [in] n  Number of the file
+    * @return   Keyframes (file(n).index_count entries)
+    ****************************************************************************
+    */
+    const struct catalog_keyframe* keyframes(size_t n) const;
+
+    /**
+    ****************************************************************************
+    * @brief    Searches for the last keyframe at or before PTS
+    * @param    [in] n      Number of the file
+    * @param    [in] pts    PTS continued across wrap around (90 kHz)
+    * @return   Keyframe, NULL if file has no keyframe before PTS
+    ****************************************************************************
+    */
+    const struct catalog_keyframe* find_keyframe(size_t n, uint64_t pts) const;
+
+private:    // Blocked implementations
+    TSCatalog(const TSCatalog& r);
+    TSCatalog& operator= (const TSCatalog&);
+
+private:
+    const uint8_t*  m_data;             ///< Mapped catalog
+    size_t          m_size;             ///< Size of the mapping
+    const struct catalog_header* m_header;  ///< Header of the catalog
+    const struct catalog_file*   m_files;   ///< File table
+    const char*     m_names;            ///< File names
+};
+
+#endif  /* !_TS_CATALOG_H_ */
@@ -0,0 +1,257 @@
+/**
+********************************************************************************
+* @file         ts_checkpoint.cpp
+* @brief        Checkpoint of long demultiplexing job
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "ts_checkpoint.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+********************************************************************************
+* @brief        Syncs directory of the file, so rename of the file is durable
+* @param        [in] filename   File name
+* @return       void
+********************************************************************************
+*/
+static void sync_directory(const std::string& filename)
+{
+    size_t slash = filename.rfind('/');
+    std::string dir = (std::string::npos == slash) ? "." :
+        filename.substr(0, slash + 1);
+
+    int fd = open(dir.c_str(), O_RDONLY | O_DIRECTORY);
+    if (-1 != fd)
+    {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+/**
+********************************************************************************
+* @brief        Decodes hexadecimal string
+* @param        [in] text   Hexadecimal digits
+* @param        [out] data  Decoded bytes
+* @return       STATUS_OK on success, STATUS_FAIL if text isn't hexadecimal
+********************************************************************************
+*/
+static STATUS decode_hex(const std::string& text, std::vector<uint8_t>& data)
+{
+    static const char s_digits[] = "0123456789abcdef";
+
+    data.clear();
+    for (size_t i = 0; i + 1 < text.size(); i += 2)
+    {
+        const char* hi = strchr(s_digits, text[i]);
+        const char* lo = strchr(s_digits, text[i + 1]);
+        if (NULL == hi || NULL == lo || '\0' == *hi || '\0' == *lo)
+        {
+            return STATUS_FAIL;
+        }
+        data.push_back(((hi - s_digits) << 4) | (lo - s_digits));
+    }
+
+    return (0 == text.size() % 2) ? STATUS_OK : STATUS_FAIL;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS save_checkpoint(const char* filename, const struct ts_checkpoint& cp)
+{
+    STATUS result = STATUS_FAIL;
+    std::string temp = std::string(filename) + ".tmp";
+    FILE* file = NULL;
+
+    do
+    {
+        file = fopen(temp.c_str(), "w");
+        if (NULL == file)
+        {
+            fprintf(stderr, "Can't open checkpoint file (%s). Error: %s\n",
+                temp.c_str(), strerror(errno));
+            break;
+        }
+
+        fprintf(file, "# ts-proc checkpoint\n"
+                      "input %s\n"
+                      "offset %llu %llu\n"
+                      "state %d %u\n",
+                      cp.input.c_str(), (unsigned long long)cp.offset,
+                      (unsigned long long)cp.packets, cp.state, cp.pmt_pid);
+
+        if (!cp.pmt.empty())
+        {
+            fprintf(file, "pmt ");
+            for (size_t i = 0; i < cp.pmt.size(); ++i)
+            {
+                fprintf(file, "%02x", cp.pmt[i]);
+            }
+            fprintf(file, "\n");
+        }
+
+        for (size_t i = 0; i < cp.outputs.size(); ++i)
+        {
+            fprintf(file, "output %llu %llu %s\n",
+                (unsigned long long)cp.outputs[i].size,
+                (unsigned long long)cp.outputs[i].index_size,
+                cp.outputs[i].filename.c_str());
+        }
+        fprintf(file, "end\n");
+
+        // Previous checkpoint is replaced only by complete one
+        if (0 != fflush(file) || 0 != fsync(fileno(file)))
+        {
+            fprintf(stderr, "Can't write checkpoint file (%s). Error: %s\n",
+                temp.c_str(), strerror(errno));
+            break;
+        }
+
+        int r = fclose(file);
+        file = NULL;
+        if (0 != r || 0 != rename(temp.c_str(), filename))
+        {
+            fprintf(stderr, "Can't replace checkpoint file (%s). Error: %s\n",
+                filename, strerror(errno));
+            break;
+        }
+        sync_directory(filename);
+
+        result = STATUS_OK;
+
+    } while(0);
+
+    if (NULL != file)
+    {
+        fclose(file);
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS load_checkpoint(const char* filename, struct ts_checkpoint& cp)
+{
+    STATUS result = STATUS_FAIL;
+    FILE* file = NULL;
+    char* line = NULL;
+    size_t capacity = 0;
+
+    cp = ts_checkpoint();
+    cp.offset  = 0;
+    cp.packets = 0;
+    cp.state   = -1;
+    cp.pmt_pid = 0x1fff;
+
+    do
+    {
+        file = fopen(filename, "r");
+        if (NULL == file)
+        {
+            fprintf(stderr, "Can't open checkpoint file (%s). Error: %s\n",
+                filename, strerror(errno));
+            break;
+        }
+
+        bool valid = true;
+        bool complete = false;
+        ssize_t length = 0;
+        while (valid && !complete &&
+            -1 != (length = getline(&line, &capacity, file)))
+        {
+            std::string text(line, length);
+            if (!text.empty() && '\n' == text[text.size() - 1])
+            {
+                text.erase(text.size() - 1);
+            }
+
+            size_t space = text.find(' ');
+            std::string key = text.substr(0, space);
+            std::string value = (std::string::npos == space) ? "" :
+                text.substr(space + 1);
+
+            unsigned long long a = 0;
+            unsigned long long b = 0;
+            unsigned pid = 0;
+            int used = 0;
+
+            if (text.empty() || '#' == text[0])
+            {
+                continue;
+            }
+            else if ("input" == key)
+            {
+                cp.input = value;
+            }
+            else if ("offset" == key)
+            {
+                valid = (2 == sscanf(value.c_str(), "%llu %llu", &a, &b));
+                cp.offset  = a;
+                cp.packets = b;
+            }
+            else if ("state" == key)
+            {
+                valid = (2 == sscanf(value.c_str(), "%d %u", &cp.state,
+                    &pid) && pid < TS_PID_COUNT);
+                cp.pmt_pid = pid;
+            }
+            else if ("pmt" == key)
+            {
+                valid = (STATUS_OK == decode_hex(value, cp.pmt));
+            }
+            else if ("output" == key)
+            {
+                struct checkpoint_output out;
+                valid = (2 == sscanf(value.c_str(), "%llu %llu %n", &a, &b,
+                    &used) && 0 != used && (size_t)used < value.size());
+                out.size       = a;
+                out.index_size = b;
+                out.filename   = valid ? value.substr(used) : "";
+                cp.outputs.push_back(out);
+            }
+            else if ("end" == key)
+            {
+                complete = true;
+            }
+            else
+            {
+                valid = false;
+            }
+        }
+
+        if (!valid || !complete || cp.input.empty() || cp.state < 0 ||
+            0 != cp.offset % TS_PACKET_SIZE)
+        {
+            fprintf(stderr, "Broken checkpoint file (%s)\n", filename);
+            break;
+        }
+
+        result = STATUS_OK;
+
+    } while(0);
+
+    free(line);
+
+    if (NULL != file)
+    {
+        fclose(file);
+    }
+
+    return result;
+}
@@ -0,0 +1,82 @@
+/**
+********************************************************************************
+* @file         ts_checkpoint.h
+* @brief        Checkpoint of long demultiplexing job
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _TS_CHECKPOINT_H_
+#define _TS_CHECKPOINT_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "ts_processor.h"
+
+/**
+********************************************************************************
+* @def          CHECKPOINT_INTERVAL
+* @brief        Default amount of input between checkpoints
+********************************************************************************
+*/
+#define CHECKPOINT_INTERVAL (1024ull * 1024 * 1024)
+
+/**
+********************************************************************************
+* @struct       checkpoint_output
+* @brief        ES output file at the checkpoint
+********************************************************************************
+*/
+struct checkpoint_output
+{
+    std::string     filename;       ///< Output file name
+    uint64_t        size;           ///< Size of the file
+    uint64_t        index_size;     ///< Size of its PTS index, 0 if none
+};
+
+/**
+********************************************************************************
+* @struct       ts_checkpoint
+* @brief        State of demultiplexer between two input chunks. ES data is
+*               written packet by packet, so besides of input position only
+*               PSI state (the last PMT section) and sizes of outputs are
+*               needed to continue
+********************************************************************************
+*/
+struct ts_checkpoint
+{
+    std::string     input;          ///< Input file name
+    uint64_t        offset;         ///< Input position (packet boundary)
+    uint64_t        packets;        ///< Packets processed before offset
+    int             state;          ///< Stage of demultiplexing
+    uint16_t        pmt_pid;        ///< PMT PID (if PAT was found)
+    std::vector<uint8_t> pmt;       ///< Last PMT section, empty if none
+    std::vector<struct checkpoint_output> outputs; ///< ES outputs
+};
+
+/**
+********************************************************************************
+* @brief        Writes checkpoint atomically: to temporary file which is
+*               synced and renamed over the previous checkpoint
+* @param        [in] filename   Checkpoint file name
+* @param        [in] cp         Checkpoint
+* @return       STATUS_OK on success, STATUS_FAIL - otherwise
+********************************************************************************
+*/
+STATUS save_checkpoint(const char* filename, const struct ts_checkpoint& cp);
+
+/**
+********************************************************************************
+* @brief        Reads checkpoint
+* @param        [in] filename   Checkpoint file name
+* @param        [out] cp        Checkpoint
+* @return       STATUS_OK on success, STATUS_FAIL if file can't be read or
+*               is broken
+********************************************************************************
+*/
+STATUS load_checkpoint(const char* filename, struct ts_checkpoint& cp);
+
+#endif  /* !_TS_CHECKPOINT_H_ */
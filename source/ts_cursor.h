@@ -0,0 +1,143 @@
+/**
+********************************************************************************
+* @file         ts_cursor.h
+* @brief        Bounds-checked cursor over stream data
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _TS_CURSOR_H_
+#define _TS_CURSOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "ts_fields.h"
+
+/**
+********************************************************************************
+* @class        TSCursor
+* @brief        Read position inside a block of stream data (packet payload,
+*               PSI section, PES header). Range is checked once for the whole
+*               structure with require(), fields inside of the checked window
+*               are read without further checks
+* @note         Build with TS_CHECKED_CURSOR (fuzzing, debugging) verifies
+*               that every field read is covered by require(). In regular
+*               build these checks are compiled out
+********************************************************************************
+*/
+class TSCursor
+{
+public:
+    /**
+    ****************************************************************************
+    * @brief    Creates cursor at the beginning of the block
+    * @param    [in] data   Block of data
+    * @param    [in] size   Size of the block in bytes
+    ****************************************************************************
+    */
+    TSCursor(const uint8_t* data, size_t size)
+        : m_data(data)
+        , m_size(size)
+        , m_pos(0)
+#ifdef TS_CHECKED_CURSOR
+        , m_checked(0)
+#endif
+    {
+
+    }
+
+    /**
+    ****************************************************************************
+    * @brief    Checks that next size bytes are available. The only range
+    *           check which should be done per structure
+    * @param    [in] size   Number of bytes which will be read
+    * @return   true if bytes are available, false - otherwise
+    ****************************************************************************
+    */
+    bool require(size_t size)
+    {
+        bool result = (size <= m_size - m_pos);
+#ifdef TS_CHECKED_CURSOR
+        if (result)
+        {
+            m_checked = m_pos + size;
+        }
+#endif
+        return result;
+    }
+
+    /**
+    ****************************************************************************
+    * @brief    Reads field at current position
+    * @warning  Field must be covered by preceding require()
+    * @return   Field value
+    ****************************************************************************
+    */
+    template <class FIELD>
+    uint32_t get(void) const
+    {
+#ifdef TS_CHECKED_CURSOR
+        if (m_pos + FIELD::END > m_checked)
+        {
+            abort();
+        }
+#endif
+        return FIELD::get(&m_data[m_pos]);
+    }
+
+    /**
+    ****************************************************************************
+    * @brief    Advances current position
+    * @warning  Bytes must be covered by preceding require()
+    * @param    [in] size   Number of bytes to skip
+    * @return   void
+    ****************************************************************************
+    */
+    void skip(size_t size)
+    {
+#ifdef TS_CHECKED_CURSOR
+        if (m_pos + size > m_checked)
+        {
+            abort();
+        }
+#endif
+        m_pos += size;
+    }
+
+    /**
+    ****************************************************************************
+    * @brief    Returns pointer to current position
+    * @return   Pointer to current position
+    ****************************************************************************
+    */
+    const uint8_t* ptr(void) const { return &m_data[m_pos]; }
+
+    /**
+    ****************************************************************************
+    * @brief    Returns number of bytes left after current position
+    * @return   Number of bytes left
+    ****************************************************************************
+    */
+    size_t left(void) const { return m_size - m_pos; }
+
+    /**
+    ****************************************************************************
+    * @brief    Returns current position from the beginning of the block
+    * @return   Current position
+    ****************************************************************************
+    */
+    size_t pos(void) const { return m_pos; }
+
+private:
+    const uint8_t*  m_data;     ///< Block of data
+    size_t          m_size;     ///< Size of the block
+    size_t          m_pos;      ///< Current position
+#ifdef TS_CHECKED_CURSOR
+    size_t          m_checked;  ///< End of window checked by require()
+#endif
+};
+
+#endif  /* !_TS_CURSOR_H_ */
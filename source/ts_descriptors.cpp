@@ -0,0 +1,323 @@
+/**
+********************************************************************************
+* @file         ts_descriptors.cpp
+* @brief        Elementary stream descriptors of PMT and stream metadata
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "ts_descriptors.h"
+#include "ts_cursor.h"
+
+#include <string.h>
+
+/**
+********************************************************************************
+* @brief        Descriptor header fields (offset from descriptor_tag)
+********************************************************************************
+*/
+typedef bit_field<0, 0, 8>  desc_tag;
+typedef bit_field<1, 0, 8>  desc_length;
+
+/**
+********************************************************************************
+* @enum         DESCRIPTOR_TAG
+* @brief        Tags of descriptors which are taken into account
+********************************************************************************
+*/
+typedef enum
+{
+    DESC_REGISTRATION   = 0x05,
+    DESC_ISO_639        = 0x0a,
+    DESC_VBI_TELETEXT   = 0x46,
+    DESC_STREAM_ID      = 0x52,
+    DESC_TELETEXT       = 0x56,
+    DESC_SUBTITLING     = 0x59,
+    DESC_AC3            = 0x6a,
+    DESC_EAC3           = 0x7a,
+    DESC_DTS            = 0x7b,
+    DESC_AAC            = 0x7c
+} DESCRIPTOR_TAG;
+
+/**
+********************************************************************************
+* @brief        Names of codecs, indexed by STREAM_CODEC
+********************************************************************************
+*/
+static const char* const s_codec_names[CODEC_COUNT] =
+{
+    "unknown", "mpeg1video", "mpeg2video", "mpeg4", "h264", "hevc", "mpa",
+    "aac", "aac_latm", "ac3", "eac3", "dts", "dvbsub", "teletext", "scte35"
+};
+
+/**
+********************************************************************************
+* @brief        Resolves codec from stream type only
+* @param        [in] type   Stream type
+* @return       Codec, CODEC_UNKNOWN for private and unknown types
+********************************************************************************
+*/
+static STREAM_CODEC codec_by_type(uint8_t type)
+{
+    STREAM_CODEC codec = CODEC_UNKNOWN;
+
+    switch (type)
+    {
+        case 0x01: codec = CODEC_MPEG1V;    break;
+        case 0x02: codec = CODEC_MPEG2V;    break;
+        case 0x03:
+        case 0x04: codec = CODEC_MPA;       break;
+        case 0x0f: codec = CODEC_AAC;       break;
+        case 0x10: codec = CODEC_MPEG4V;    break;
+        case 0x11: codec = CODEC_AAC_LATM;  break;
+        case 0x1b: codec = CODEC_H264;      break;
+        case 0x24: codec = CODEC_HEVC;      break;
+        case 0x81: codec = CODEC_AC3;       break;  // ATSC A/52
+        case 0x86: codec = CODEC_SCTE35;    break;
+        case 0x87: codec = CODEC_EAC3;      break;  // ATSC A/52 Annex G
+    }
+
+    return codec;
+}
+
+/**
+********************************************************************************
+* @brief        Resolves codec from registration descriptor
+* @param        [in] registration   Format identifier
+* @return       Codec, CODEC_UNKNOWN if identifier is not known
+********************************************************************************
+*/
+static STREAM_CODEC codec_by_registration(uint32_t registration)
+{
+    STREAM_CODEC codec = CODEC_UNKNOWN;
+
+    switch (registration)
+    {
+        case REG_FOURCC('A', 'C', '-', '3'): codec = CODEC_AC3;    break;
+        case REG_FOURCC('E', 'A', 'C', '3'): codec = CODEC_EAC3;   break;
+        case REG_FOURCC('D', 'T', 'S', '1'):
+        case REG_FOURCC('D', 'T', 'S', '2'):
+        case REG_FOURCC('D', 'T', 'S', '3'): codec = CODEC_DTS;    break;
+        case REG_FOURCC('H', 'E', 'V', 'C'): codec = CODEC_HEVC;   break;
+        case REG_FOURCC('C', 'U', 'E', 'I'): codec = CODEC_SCTE35; break;
+    }
+
+    return codec;
+}
+
+/**
+********************************************************************************
+* @brief        Returns kind of stream with known codec
+* @param        [in] codec  Codec
+* @return       Kind of stream
+********************************************************************************
+*/
+static STREAM_KIND kind_by_codec(STREAM_CODEC codec)
+{
+    STREAM_KIND kind = STREAM_UNKNOWN;
+
+    switch (codec)
+    {
+        case CODEC_MPEG1V:
+        case CODEC_MPEG2V:
+        case CODEC_MPEG4V:
+        case CODEC_H264:
+        case CODEC_HEVC:
+            kind = STREAM_VIDEO;
+            break;
+
+        case CODEC_MPA:
+        case CODEC_AAC:
+        case CODEC_AAC_LATM:
+        case CODEC_AC3:
+        case CODEC_EAC3:
+        case CODEC_DTS:
+            kind = STREAM_AUDIO;
+            break;
+
+        case CODEC_DVBSUB:
+            kind = STREAM_SUBTITLE;
+            break;
+
+        case CODEC_TELETEXT:
+            kind = STREAM_TELETEXT;
+            break;
+
+        case CODEC_SCTE35:
+            kind = STREAM_DATA;
+            break;
+
+        default:
+            break;
+    }
+
+    return kind;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS parse_stream_info(const struct psi_stream& stream,
+    struct ts_stream_info& info)
+{
+    STATUS result = STATUS_OK;
+
+    memset(&info, 0, sizeof(info));
+    info.pid           = stream.pid;
+    info.type          = stream.type;
+    info.codec         = codec_by_type(stream.type);
+    info.component_tag = -1;
+
+    STREAM_CODEC by_descriptor = CODEC_UNKNOWN;
+    TSCursor cur(stream.info, stream.info_size);
+
+    while (0 != cur.left())
+    {
+        /**
+        ********************************************************************
+        * @note     One range check per descriptor: header, then the whole
+        *           body. Fields inside of the body are read unchecked
+        ********************************************************************
+        */
+        if (!cur.require(desc_length::END))
+        {
+            result = STATUS_FAIL;
+            break;
+        }
+
+        int tag = cur.get<desc_tag>();
+        size_t len = cur.get<desc_length>();
+        cur.skip(desc_length::END);
+        if (!cur.require(len))
+        {
+            result = STATUS_FAIL;
+            break;
+        }
+
+        switch (tag)
+        {
+            case DESC_REGISTRATION:
+                if (len >= 4)
+                {
+                    info.registration = cur.get<bit_field<0, 0, 32> >();
+                }
+                break;
+
+            case DESC_ISO_639:
+                if (len >= 4 && '\0' == info.language[0])
+                {
+                    memcpy(info.language, cur.ptr(), 3);
+                    info.audio_type = cur.get<bit_field<3, 0, 8> >();
+                }
+                break;
+
+            case DESC_STREAM_ID:
+                if (len >= 1)
+                {
+                    info.component_tag = cur.get<bit_field<0, 0, 8> >();
+                }
+                break;
+
+            case DESC_AC3:
+                by_descriptor = CODEC_AC3;
+                break;
+
+            case DESC_EAC3:
+                by_descriptor = CODEC_EAC3;
+                break;
+
+            case DESC_DTS:
+                by_descriptor = CODEC_DTS;
+                break;
+
+            case DESC_AAC:
+                // AAC descriptor doesn't change the transport (ADTS/LATM)
+                if (CODEC_UNKNOWN == info.codec)
+                {
+                    by_descriptor = CODEC_AAC;
+                }
+                break;
+
+            case DESC_SUBTITLING:
+                by_descriptor = CODEC_DVBSUB;
+                if (len >= 8)
+                {
+                    memcpy(info.language, cur.ptr(), 3);
+                    info.sub_type      = cur.get<bit_field<3, 0, 8> >();
+                    info.sub_page      = cur.get<bit_field<4, 0, 16> >();
+                    info.sub_ancillary = cur.get<bit_field<6, 0, 16> >();
+                }
+                break;
+
+            case DESC_TELETEXT:
+            case DESC_VBI_TELETEXT:
+                by_descriptor = CODEC_TELETEXT;
+                if (len >= 5)
+                {
+                    /**
+                    ********************************************************
+                    * @note     Teletext page is magazine (0 means 8) and
+                    *           BCD page number, e.g. 0x888 for page 888
+                    ********************************************************
+                    */
+                    int magazine = cur.get<bit_field<3, 5, 3> >();
+                    memcpy(info.language, cur.ptr(), 3);
+                    info.sub_type = cur.get<bit_field<3, 0, 5> >();
+                    info.sub_page = ((0 == magazine) ? 8 : magazine) << 8 |
+                        cur.get<bit_field<4, 0, 8> >();
+                }
+                break;
+        }
+
+        cur.skip(len);
+    }
+
+    if (CODEC_UNKNOWN == info.codec)
+    {
+        info.codec = by_descriptor;
+    }
+
+    if (CODEC_UNKNOWN == info.codec)
+    {
+        info.codec = codec_by_registration(info.registration);
+    }
+
+    info.kind = kind_by_codec(info.codec);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+const char* codec_name(STREAM_CODEC codec)
+{
+    return (codec < CODEC_COUNT) ? s_codec_names[codec] : s_codec_names[0];
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+const char* kind_name(STREAM_KIND kind)
+{
+    const char* name = "unknown";
+
+    switch (kind)
+    {
+        case STREAM_VIDEO:      name = "video";     break;
+        case STREAM_AUDIO:      name = "audio";     break;
+        case STREAM_SUBTITLE:   name = "subtitle";  break;
+        case STREAM_TELETEXT:   name = "teletext";  break;
+        case STREAM_DATA:       name = "data";      break;
+        default:                                    break;
+    }
+
+    return name;
+}
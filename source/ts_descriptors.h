@@ -0,0 +1,50 @@
+/**
+********************************************************************************
+* @file         ts_descriptors.h
+* @brief        Elementary stream descriptors of PMT and stream metadata
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _TS_DESCRIPTORS_H_
+#define _TS_DESCRIPTORS_H_
+
+#include <stdint.h>
+
+#include "ts_processor.h"
+#include "ts_parse.h"
+
+/**
+********************************************************************************
+* @brief        Collects metadata of elementary stream from PMT entry and its
+*               descriptors (ISO 639 language, registration, stream
+*               identifier, AC-3, E-AC-3, DTS, AAC, subtitling, teletext)
+* @param        [in] stream     PMT entry
+* @param        [out] info      Stream metadata
+* @return       STATUS_OK on success, STATUS_FAIL if descriptors are broken
+*               (metadata collected before the broken one is kept)
+********************************************************************************
+*/
+STATUS parse_stream_info(const struct psi_stream& stream,
+    struct ts_stream_info& info);
+
+/**
+********************************************************************************
+* @brief        Returns short name of the codec (as used in selection rules)
+* @param        [in] codec  Codec
+* @return       Name of the codec
+********************************************************************************
+*/
+const char* codec_name(STREAM_CODEC codec);
+
+/**
+********************************************************************************
+* @brief        Returns name of the stream kind (as used in selection rules)
+* @param        [in] kind   Stream kind
+* @return       Name of the stream kind
+********************************************************************************
+*/
+const char* kind_name(STREAM_KIND kind);
+
+#endif  /* !_TS_DESCRIPTORS_H_ */
@@ -0,0 +1,270 @@
+/**
+********************************************************************************
+* @file         ts_duration.cpp
+* @brief        Estimation of duration and bitrate of MPEG-TS file by time
+*               stamps at its head and tail
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "ts_duration.h"
+#include "ts_fields.h"
+#include "ts_parse.h"
+
+#include <vector>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/**
+********************************************************************************
+* @struct       stamp_window
+* @brief        Time stamps found in one window of the file
+********************************************************************************
+*/
+struct stamp_window
+{
+    int         pcr_pid;    ///< PID of PCRs, -1 if unknown
+    bool        has_pcr;    ///< PCR is found
+    uint64_t    pcr;        ///< First (head) or last (tail) PCR
+    uint64_t    pcr_pos;    ///< File position of that PCR
+    int         pts_pid;    ///< PID of PTSs, -1 if unknown
+    bool        has_pts;    ///< PTS is found
+    uint64_t    pts;        ///< Lowest (head) or highest (tail) PTS
+};
+
+/**
+********************************************************************************
+* @brief        Reads block of the file at the offset
+* @param        [in] fd     File descriptor
+* @param        [out] data  Buffer
+* @param        [in] size   Number of bytes to read
+* @param        [in] offset Offset in the file
+* @return       STATUS_OK on success, STATUS_FAIL - otherwise
+********************************************************************************
+*/
+static STATUS read_at(int fd, uint8_t* data, size_t size, uint64_t offset)
+{
+    while (0 != size)
+    {
+        ssize_t r = pread(fd, data, size, offset);
+        if (r > 0)
+        {
+            data   += r;
+            size   -= r;
+            offset += r;
+            continue;
+        }
+
+        if (-1 == r && EINTR == errno)
+        {
+            continue;
+        }
+
+        return STATUS_FAIL;
+    }
+
+    return STATUS_OK;
+}
+
+/**
+********************************************************************************
+* @brief        Searches for the packet boundary: sync byte followed by two
+*               sync bytes one and two packets later (as far as data lasts)
+* @param        [in] data   Data
+* @param        [in] size   Size of data
+* @return       Offset of the packet, size if there is none
+********************************************************************************
+*/
+static size_t find_sync(const uint8_t* data, size_t size)
+{
+    for (size_t i = 0; i + TS_PACKET_SIZE <= size; ++i)
+    {
+        if (TS_SYNC_BYTE == data[i] &&
+            (i + 2 * TS_PACKET_SIZE > size ||
+            TS_SYNC_BYTE == data[i + TS_PACKET_SIZE]) &&
+            (i + 3 * TS_PACKET_SIZE > size ||
+            TS_SYNC_BYTE == data[i + 2 * TS_PACKET_SIZE]))
+        {
+            return i;
+        }
+    }
+
+    return size;
+}
+
+/**
+********************************************************************************
+* @brief        Collects time stamps of the window. At the head PIDs are taken
+*               from the first PCR and PTS, at the tail - given by the head
+* @param        [in] data   Window data
+* @param        [in] size   Size of the window
+* @param        [in] offset Offset of the window in the file
+* @param        [in] tail   Window is the tail of the file
+* @param        [in,out] w  Time stamps of the window
+* @return       void
+********************************************************************************
+*/
+static void scan_window(const uint8_t* data, size_t size, uint64_t offset,
+    bool tail, struct stamp_window& w)
+{
+    size_t i = find_sync(data, size);
+
+    while (i + TS_PACKET_SIZE <= size)
+    {
+        const uint8_t* packet = &data[i];
+        if (TS_SYNC_BYTE != ts_sync_byte::get(packet))
+        {
+            i += 1 + find_sync(packet + 1, size - i - 1);
+            continue;
+        }
+        i += TS_PACKET_SIZE;
+
+        int pid = ts_pid::get(packet);
+        uint64_t pcr = 0;
+        if (STATUS_OK == parse_pcr(packet, pcr) &&
+            (pid == w.pcr_pid || (!tail && w.pcr_pid < 0)))
+        {
+            w.pcr_pid = pid;
+            if (tail || !w.has_pcr)
+            {
+                w.has_pcr = true;
+                w.pcr     = pcr;
+                w.pcr_pos = offset + (packet - data);
+            }
+        }
+
+        const uint8_t* payload = NULL;
+        size_t payload_size = 0;
+        struct pes_header pes;
+        if (!ts_pusi::get(packet) || 0 != ts_scrambling::get(packet) ||
+            (pid != w.pts_pid && (tail || w.pts_pid >= 0)) ||
+            STATUS_OK != parse_payload(packet, payload, payload_size) ||
+            STATUS_OK != parse_pes_header(payload, payload_size, pes) ||
+            !pes.has_pts)
+        {
+            continue;
+        }
+
+        // PTS of reordered frames go back and forth, extremes are taken
+        uint64_t delta = (pes.pts - w.pts) & PTS_MASK;
+        bool later = (0 != delta && delta <= (PTS_MASK >> 1));
+        if (!w.has_pts || (tail ? later : (0 != delta && !later)))
+        {
+            w.has_pts = true;
+            w.pts_pid = pid;
+            w.pts     = pes.pts;
+        }
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS estimate_duration(const char* filename, size_t window,
+    struct ts_duration& duration)
+{
+    STATUS result = STATUS_FAIL;
+    int fd = -1;
+
+    memset(&duration, 0, sizeof(duration));
+
+    do
+    {
+        fd = open(filename, O_RDONLY);
+        if (-1 == fd)
+        {
+            fprintf(stderr, "Can't open input file (%s). Error: %s\n",
+                filename, strerror(errno));
+            break;
+        }
+
+        struct stat st;
+        if (0 != fstat(fd, &st))
+        {
+            fprintf(stderr, "Can't get size of input file (%s). Error: %s\n",
+                filename, strerror(errno));
+            break;
+        }
+
+        duration.file_size = st.st_size;
+        size_t size = (window < duration.file_size) ? window :
+            duration.file_size;
+        std::vector<uint8_t> buffer(size + 1);
+
+        struct stamp_window head = { -1, false, 0, 0, -1, false, 0 };
+        if (STATUS_OK != read_at(fd, &buffer[0], size, 0))
+        {
+            fprintf(stderr, "Can't read head of input file (%s). Error: %s\n",
+                filename, strerror(errno));
+            break;
+        }
+        scan_window(&buffer[0], size, 0, false, head);
+
+        struct stamp_window tail = { head.pcr_pid, false, 0, 0, head.pts_pid,
+            false, 0 };
+        uint64_t offset = duration.file_size - size;
+        if (STATUS_OK != read_at(fd, &buffer[0], size, offset))
+        {
+            fprintf(stderr, "Can't read tail of input file (%s). Error: %s\n",
+                filename, strerror(errno));
+            break;
+        }
+        scan_window(&buffer[0], size, offset, true, tail);
+
+        /**
+        ************************************************************************
+        * @note     PCR gives the rate between its head and tail positions,
+        *           duration is the whole file at that rate. PTS gives the
+        *           duration directly, the rate is the whole file over it
+        ************************************************************************
+        */
+        if (head.has_pcr && tail.has_pcr && tail.pcr_pos > head.pcr_pos)
+        {
+            uint64_t span = (tail.pcr + PCR_WRAP - head.pcr) % PCR_WRAP;
+            if (0 != span)
+            {
+                double rate = (tail.pcr_pos - head.pcr_pos) * 8.0 *
+                    27000000.0 / span;
+                duration.by_pcr   = true;
+                duration.pid      = head.pcr_pid;
+                duration.bitrate  = (uint64_t)(rate + 0.5);
+                duration.duration = duration.file_size * 8.0 / rate;
+                result = STATUS_OK;
+                break;
+            }
+        }
+
+        if (head.has_pts && tail.has_pts)
+        {
+            uint64_t span = (tail.pts - head.pts) & PTS_MASK;
+            if (0 != span)
+            {
+                duration.by_pcr   = false;
+                duration.pid      = head.pts_pid;
+                duration.duration = span / 90000.0;
+                duration.bitrate  = (uint64_t)(duration.file_size * 8.0 /
+                    duration.duration + 0.5);
+                result = STATUS_OK;
+                break;
+            }
+        }
+
+        fprintf(stderr, "No PCR or PTS at the head and the tail of %s!\n",
+            filename);
+
+    } while(0);
+
+    if (-1 != fd)
+    {
+        close(fd);
+    }
+
+    return result;
+}
@@ -0,0 +1,60 @@
+/**
+********************************************************************************
+* @file         ts_duration.h
+* @brief        Estimation of duration and bitrate of MPEG-TS file by time
+*               stamps at its head and tail
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _TS_DURATION_H_
+#define _TS_DURATION_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ts_processor.h"
+
+/**
+********************************************************************************
+* @def          DURATION_WINDOW
+* @brief        Default number of bytes read at the head and at the tail
+********************************************************************************
+*/
+#define DURATION_WINDOW     (1024 * 1024)
+
+/**
+********************************************************************************
+* @struct       ts_duration
+* @brief        Estimated duration and bitrate of the file
+********************************************************************************
+*/
+struct ts_duration
+{
+    uint64_t    file_size;      ///< Size of the file
+    bool        by_pcr;         ///< Measured by PCR, otherwise by PTS
+    uint16_t    pid;            ///< PID of the time stamps
+    double      duration;       ///< Duration (seconds)
+    uint64_t    bitrate;        ///< Average bitrate (bit/s)
+};
+
+/**
+********************************************************************************
+* @brief        Estimates duration and average bitrate of MPEG-TS file from
+*               PCRs (PTSs if there are no PCRs) found in the first and in the
+*               last window bytes of the file. Two reads, regardless of size
+* @param        [in] filename   MPEG-TS file name
+* @param        [in] window     Number of bytes read at the head and the tail
+* @param        [out] duration  Estimated duration and bitrate
+* @return       STATUS_OK on success, STATUS_FAIL if file can't be read or no
+*               time stamps are found
+* @note         Time stamps are taken modulo their wrap around, so duration
+*               is correct up to 26.5 hours. Discontinuities in the middle of
+*               the file (e.g. concatenated recordings) can't be seen
+********************************************************************************
+*/
+STATUS estimate_duration(const char* filename, size_t window,
+    struct ts_duration& duration);
+
+#endif  /* !_TS_DURATION_H_ */
@@ -0,0 +1,200 @@
+/**
+********************************************************************************
+* @file         ts_fields.h
+* @brief        Bit-field descriptors of TS, PSI and PES headers
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _TS_FIELDS_H_
+#define _TS_FIELDS_H_
+
+#include <stdint.h>
+#include <string.h>
+#include <endian.h>
+
+/**
+********************************************************************************
+* @struct       be_bytes
+* @brief        Loads SIZE bytes in big-endian order from unaligned memory.
+*               memcpy of fixed size is compiled to a single load, so every
+*               specialization is one load and byte swap at most
+********************************************************************************
+*/
+template <unsigned SIZE>
+struct be_bytes;
+
+template <>
+struct be_bytes<1>
+{
+    static inline uint32_t load(const uint8_t* p)
+    {
+        return p[0];
+    }
+};
+
+template <>
+struct be_bytes<2>
+{
+    static inline uint32_t load(const uint8_t* p)
+    {
+        uint16_t v;
+        memcpy(&v, p, sizeof(v));
+        return be16toh(v);
+    }
+};
+
+template <>
+struct be_bytes<3>
+{
+    static inline uint32_t load(const uint8_t* p)
+    {
+        return (be_bytes<2>::load(p) << 8) | p[2];
+    }
+};
+
+template <>
+struct be_bytes<4>
+{
+    static inline uint32_t load(const uint8_t* p)
+    {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return be32toh(v);
+    }
+};
+
+/**
+********************************************************************************
+* @struct       bit_field
+* @brief        Descriptor of header field. All parameters are known at
+*               compile time, so get() is reduced to load, shift and mask of
+*               exactly the bytes the field occupies
+* @param        BYTE    Offset of the first byte of the field
+* @param        BIT     Offset of the field in the first byte (0 - MSB)
+* @param        WIDTH   Width of the field in bits (1..32)
+********************************************************************************
+*/
+template <unsigned BYTE, unsigned BIT, unsigned WIDTH>
+struct bit_field
+{
+    enum
+    {
+        BYTES   = (BIT + WIDTH + 7) / 8,        ///< Bytes occupied by field
+        SHIFT   = BYTES * 8 - BIT - WIDTH,      ///< Shift of loaded value
+        END     = BYTE + BYTES                  ///< Bytes required to read
+    };
+
+    /**
+    ****************************************************************************
+    * @brief    Reads field value
+    * @param    [in] p  Pointer to the beginning of the header
+    * @return   Field value
+    ****************************************************************************
+    */
+    static inline uint32_t get(const uint8_t* p)
+    {
+        // Field must fit into 32 bits load
+        typedef char check_width[
+            (0 < WIDTH && BIT < 8 && BYTES <= 4) ? 1 : -1];
+        (void)sizeof(check_width);
+
+        return (be_bytes<BYTES>::load(&p[BYTE]) >> SHIFT) &
+            (0xffffffffu >> (32 - WIDTH));
+    }
+};
+
+/**
+********************************************************************************
+* @brief        TS packet header fields (offset from packet start)
+********************************************************************************
+*/
+typedef bit_field<0, 0, 8>  ts_sync_byte;
+typedef bit_field<1, 0, 1>  ts_tei;
+typedef bit_field<1, 1, 1>  ts_pusi;
+typedef bit_field<1, 2, 1>  ts_priority;
+typedef bit_field<1, 3, 13> ts_pid;
+typedef bit_field<3, 0, 2>  ts_scrambling;
+typedef bit_field<3, 2, 2>  ts_afc;
+typedef bit_field<3, 4, 4>  ts_cc;
+
+/**
+********************************************************************************
+* @brief        Adaptation field (offset from adaptation field start)
+********************************************************************************
+*/
+typedef bit_field<0, 0, 8>  af_length;
+typedef bit_field<1, 0, 1>  af_discontinuity;
+typedef bit_field<1, 1, 1>  af_random_access;
+typedef bit_field<1, 3, 1>  af_pcr_flag;
+
+/**
+********************************************************************************
+* @brief        Pointer field preceding PSI section in payload with PUSI
+********************************************************************************
+*/
+typedef bit_field<0, 0, 8>  psi_pointer_field;
+
+/**
+********************************************************************************
+* @brief        Long form PSI section header (offset from table_id)
+********************************************************************************
+*/
+typedef bit_field<0, 0, 8>  psi_table_id;
+typedef bit_field<1, 0, 1>  psi_syntax_indicator;
+typedef bit_field<1, 4, 12> psi_section_length;
+typedef bit_field<3, 0, 16> psi_table_id_ext;
+typedef bit_field<5, 2, 5>  psi_version;
+typedef bit_field<5, 7, 1>  psi_current_next;
+typedef bit_field<6, 0, 8>  psi_section_number;
+typedef bit_field<7, 0, 8>  psi_last_section_number;
+
+/**
+********************************************************************************
+* @brief        PAT program loop entry (offset from entry start)
+********************************************************************************
+*/
+typedef bit_field<0, 0, 16> pat_program_number;
+typedef bit_field<2, 3, 13> pat_pid;
+
+/**
+********************************************************************************
+* @brief        PMT fields (offset from table_id) and ES loop entry (offset
+*               from entry start)
+********************************************************************************
+*/
+typedef bit_field<8, 3, 13>  pmt_pcr_pid;
+typedef bit_field<10, 4, 12> pmt_program_info_length;
+typedef bit_field<0, 0, 8>   pmt_stream_type;
+typedef bit_field<1, 3, 13>  pmt_elementary_pid;
+typedef bit_field<3, 4, 12>  pmt_es_info_length;
+
+/**
+********************************************************************************
+* @brief        PES header fields (offset from packet_start_code_prefix)
+********************************************************************************
+*/
+typedef bit_field<0, 0, 24> pes_start_code;
+typedef bit_field<3, 0, 8>  pes_stream_id;
+typedef bit_field<4, 0, 16> pes_packet_length;
+typedef bit_field<7, 0, 2>  pes_pts_dts_flags;
+typedef bit_field<8, 0, 8>  pes_header_data_length;
+
+/**
+********************************************************************************
+* @def          PSI_HEADER_SIZE
+* @brief        Size of long form PSI section header (up to last_section_number)
+********************************************************************************
+*/
+#define PSI_HEADER_SIZE     8
+
+/**
+********************************************************************************
+* @def          PES_HEADER_SIZE
+* @brief        Size of fixed part of PES header (up to PES_header_data_length)
+********************************************************************************
+*/
+#define PES_HEADER_SIZE     9
+
+#endif  /* !_TS_FIELDS_H_ */
@@ -0,0 +1,326 @@
+/**
+********************************************************************************
+* @file         ts_merge.cpp
+* @brief        Merge of redundant MPEG-TS inputs into single set of ES files
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "ts_merge.h"
+#include "es_writer.h"
+#include "ts_parse.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+TSMerger::TSMerger(const char* const primary, const char* const backup,
+    const char* const video, const char* const audio)
+    : m_buffer(NULL)
+{
+    const char* inputs[DEDUP_SOURCES] = { primary, backup };
+    for (unsigned i = 0; i < DEDUP_SOURCES; ++i)
+    {
+        m_inputs[i].filename  = inputs[i];
+        m_inputs[i].file      = NULL;
+        m_inputs[i].proc      = NULL;
+        m_inputs[i].active    = false;
+        m_inputs[i].failed    = false;
+        m_inputs[i].has_clock = false;
+        m_inputs[i].clock     = 0;
+        memset(m_inputs[i].kind, STREAM_UNKNOWN, sizeof(m_inputs[i].kind));
+    }
+
+    m_filenames[MERGE_VIDEO] = video;
+    m_filenames[MERGE_AUDIO] = audio;
+    for (unsigned i = 0; i < MERGE_STREAMS; ++i)
+    {
+        m_outputs[i] = NULL;
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+TSMerger::~TSMerger()
+{
+    for (unsigned i = 0; i < DEDUP_SOURCES; ++i)
+    {
+        if (NULL != m_inputs[i].file)
+        {
+            fclose(m_inputs[i].file);
+            m_inputs[i].file = NULL;
+        }
+
+        delete m_inputs[i].proc;
+        m_inputs[i].proc = NULL;
+    }
+
+    for (unsigned i = 0; i < MERGE_STREAMS; ++i)
+    {
+        delete m_outputs[i];
+        m_outputs[i] = NULL;
+    }
+
+    free(m_buffer);
+    m_buffer = NULL;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSMerger::init()
+{
+    STATUS result = STATUS_FAIL;
+
+    do
+    {
+        m_buffer = static_cast<uint8_t*>(malloc(MERGE_READ_PACKETS *
+            TS_PACKET_SIZE));
+        if (NULL == m_buffer)
+        {
+            fprintf(stderr, "Can't allocate input buffer\n");
+            break;
+        }
+
+        unsigned opened = 0;
+        for (; opened < DEDUP_SOURCES; ++opened)
+        {
+            struct merge_input& in = m_inputs[opened];
+            in.file = fopen(in.filename.c_str(), "rb");
+            if (NULL == in.file)
+            {
+                fprintf(stderr, "Can't open input file (%s). Error: %s\n",
+                    in.filename.c_str(), strerror(errno));
+                break;
+            }
+
+            // Demultiplexers only produce events, ES is written here
+            in.proc = new TSProcessor("", "", "");
+            if (STATUS_OK != in.proc->init())
+            {
+                break;
+            }
+            in.active = true;
+        }
+
+        if (DEDUP_SOURCES != opened)
+        {
+            break;
+        }
+
+        unsigned created = 0;
+        for (; created < MERGE_STREAMS; ++created)
+        {
+            m_outputs[created] = new ESWriter(m_filenames[created].c_str());
+            if (STATUS_OK != m_outputs[created]->init())
+            {
+                break;
+            }
+        }
+
+        if (MERGE_STREAMS != created)
+        {
+            break;
+        }
+
+        fprintf(stdout, "TSMerger initialized:\n"
+                        "\tPrimary input: %s\n"
+                        "\tBackup input: %s\n"
+                        "\tVideo file: %s\n"
+                        "\tAudio file: %s\n",
+                        m_inputs[0].filename.c_str(),
+                        m_inputs[1].filename.c_str(),
+                        m_filenames[MERGE_VIDEO].c_str(),
+                        m_filenames[MERGE_AUDIO].c_str());
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSMerger::run()
+{
+    STATUS result = STATUS_OK;
+
+    while (STATUS_OK == result &&
+        (m_inputs[0].active || m_inputs[1].active))
+    {
+        read_chunk(next_source());
+        result = write_units();
+    }
+
+    for (unsigned i = 0; i < MERGE_STREAMS; ++i)
+    {
+        if (STATUS_OK != m_outputs[i]->close())
+        {
+            result = STATUS_FAIL;
+        }
+    }
+
+    fprintf(stdout, "Merge finished:\n"
+                    "\tPrimary input: %s\n"
+                    "\tBackup input: %s\n"
+                    "\tUnits: %llu\n"
+                    "\tDuplicates: %llu\n",
+                    m_inputs[0].failed ? "failed" : "complete",
+                    m_inputs[1].failed ? "failed" : "complete",
+                    (unsigned long long)m_dedup.units(),
+                    (unsigned long long)m_dedup.duplicates());
+
+    return (m_inputs[0].failed && m_inputs[1].failed) ? STATUS_FAIL : result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSMerger::read_chunk(unsigned source)
+{
+    struct merge_input& in = m_inputs[source];
+    STATUS result = STATUS_FAIL;
+
+    do
+    {
+        size_t size = fread(m_buffer, 1, MERGE_READ_PACKETS *
+            TS_PACKET_SIZE, in.file);
+        if (0 == size)
+        {
+            if (ferror(in.file))
+            {
+                fprintf(stderr, "Can't read from %s file! Error: %s\n",
+                    in.filename.c_str(), strerror(errno));
+                break;
+            }
+
+            // The last unit of the input is complete
+            in.active = false;
+            result = in.proc->finish();
+            m_dedup.close(source, STATUS_OK == result);
+            break;
+        }
+
+        result = in.proc->feed(m_buffer, size);
+        while (STATUS_OK == result)
+        {
+            struct ts_event event;
+            result = in.proc->next_event(event);
+            if (STATUS_OK == result && TS_EVENT_PMT == event.type)
+            {
+                update_kinds(in);
+            }
+            else if (STATUS_OK == result && TS_EVENT_PES == event.type)
+            {
+                if (event.unit_start && event.has_pts)
+                {
+                    in.has_clock = true;
+                    in.clock     = event.pts;
+                }
+
+                m_dedup.push(source,
+                    (STREAM_VIDEO == in.kind[event.pid]) ? MERGE_VIDEO :
+                    MERGE_AUDIO, event);
+            }
+        }
+
+        result = (STATUS_AGAIN == result) ? STATUS_OK : result;
+
+    } while(0);
+
+    /**
+    ****************************************************************************
+    * @note     Unit being collected from failed input may be damaged, it is
+    *           dropped together with the input
+    ****************************************************************************
+    */
+    if (STATUS_OK != result)
+    {
+        in.active = false;
+        in.failed = true;
+        m_dedup.close(source, false);
+        fprintf(stderr, "Input %s is dropped from merge\n",
+            in.filename.c_str());
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+unsigned TSMerger::next_source() const
+{
+    const struct merge_input& a = m_inputs[0];
+    const struct merge_input& b = m_inputs[1];
+    unsigned source = a.active ? 0 : 1;
+
+    // Input without PTS yet is read until it reaches the other
+    if (a.active && b.active)
+    {
+        uint64_t delta = (a.clock - b.clock) & PTS_MASK;
+        source = (!b.has_clock || (a.has_clock && 0 != delta &&
+            delta <= (PTS_MASK >> 1))) ? 1 : 0;
+    }
+
+    return source;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSMerger::update_kinds(struct merge_input& in)
+{
+    const std::vector<struct ts_stream_info>& streams = in.proc->streams();
+
+    memset(in.kind, STREAM_UNKNOWN, sizeof(in.kind));
+    for (size_t i = 0; i < streams.size(); ++i)
+    {
+        in.kind[streams[i].pid] = streams[i].kind;
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSMerger::write_units()
+{
+    STATUS result = STATUS_OK;
+    struct dedup_unit unit;
+
+    while (STATUS_OK == result && STATUS_OK == m_dedup.next_unit(unit))
+    {
+        ESWriter* f = m_outputs[unit.stream];
+        if (unit.has_pts)
+        {
+            f->mark_unit(unit.pts);
+        }
+
+        if (!unit.data.empty())
+        {
+            result = f->write(&unit.data[0], unit.data.size());
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,158 @@
+/**
+********************************************************************************
+* @file         ts_merge.h
+* @brief        Merge of redundant MPEG-TS inputs into single set of ES files
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _TS_MERGE_H_
+#define _TS_MERGE_H_
+
+#include <string>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "ts_processor.h"
+#include "pes_dedup.h"
+
+class ESWriter;
+
+/**
+********************************************************************************
+* @def          MERGE_READ_PACKETS
+* @brief        Number of TS packets read from input at once. Small chunks
+*               keep both inputs close to each other in time
+********************************************************************************
+*/
+#define MERGE_READ_PACKETS  64
+
+/**
+********************************************************************************
+* @class        TSMerger
+* @brief        Demultiplexes two copies of the same stream (1+1 redundant
+*               feeds) and writes video and audio ES of both into one pair of
+*               files. The input which is behind by PTS is read next, units
+*               of both pass PESDedup, so a unit missing in one input is
+*               taken from the other and units present in both are written
+*               once
+* @note         Input which fails (read error, lost sync) is dropped, merge
+*               goes on with the other one
+********************************************************************************
+*/
+class TSMerger
+{
+public:
+    /**
+    ****************************************************************************
+    * @brief    The only allowed constructor for this class
+    * @param    [in] primary    Primary input MPEG-TS file name
+    * @param    [in] backup     Backup input MPEG-TS file name
+    * @param    [in] video      Output video ES file name
+    * @param    [in] audio      Output audio ES file name
+    ****************************************************************************
+    */
+    TSMerger(const char* const primary, const char* const backup,
+        const char* const video, const char* const audio);
+
+    ~TSMerger();
+
+    /**
+    ****************************************************************************
+    * @brief    Opens inputs and outputs
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS init(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Merges inputs until both are exhausted
+    * @return   STATUS_OK if at least one input was processed completely and
+    *           all units are written, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS run(void);
+
+private:
+    /**
+    ****************************************************************************
+    * @enum     MERGE_STREAM
+    * @brief    Merged streams, numbers of streams in PESDedup
+    ****************************************************************************
+    */
+    typedef enum
+    {
+        MERGE_VIDEO     = 0,    ///< Video ES
+        MERGE_AUDIO     = 1,    ///< Audio ES
+        MERGE_STREAMS   = 2     ///< Number of streams
+    } MERGE_STREAM;
+
+    /**
+    ****************************************************************************
+    * @struct   merge_input
+    * @brief    Input and its demultiplexer
+    ****************************************************************************
+    */
+    struct merge_input
+    {
+        std::string     filename;       ///< Input file name
+        FILE*           file;           ///< Input file
+        TSProcessor*    proc;           ///< Demultiplexer in event mode
+        bool            active;         ///< Input isn't exhausted or failed
+        bool            failed;         ///< Input was dropped on error
+        bool            has_clock;      ///< PTS of the input was seen
+        uint64_t        clock;          ///< The last PTS of the input
+        uint8_t         kind[TS_PID_COUNT]; ///< STREAM_KIND of PIDs
+    };
+
+    /**
+    ****************************************************************************
+    * @brief    Reads the next chunk of the input and passes its PES events
+    *           to deduplication. Input is deactivated at the end or on error
+    * @param    [in] source Number of the input
+    * @return   void
+    ****************************************************************************
+    */
+    void read_chunk(unsigned source);
+
+    /**
+    ****************************************************************************
+    * @brief    Chooses input to read: the one which is behind by PTS
+    * @return   Number of active input
+    ****************************************************************************
+    */
+    unsigned next_source(void) const;
+
+    /**
+    ****************************************************************************
+    * @brief    Updates kinds of PIDs of the input by its current PMT
+    * @param    [in] in Input
+    * @return   void
+    ****************************************************************************
+    */
+    void update_kinds(struct merge_input& in);
+
+    /**
+    ****************************************************************************
+    * @brief    Writes units which passed deduplication
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS write_units(void);
+
+private:    // Blocked implementations
+    TSMerger();
+    TSMerger(const TSMerger& r);
+    TSMerger& operator= (const TSMerger&);
+
+private:
+    struct merge_input  m_inputs[DEDUP_SOURCES];    ///< Primary and backup
+    std::string     m_filenames[MERGE_STREAMS];     ///< Output file names
+    ESWriter*       m_outputs[MERGE_STREAMS];       ///< Outputs
+    uint8_t*        m_buffer;           ///< Input chunk
+    PESDedup        m_dedup;            ///< Units of both inputs
+};
+
+#endif  /* !_TS_MERGE_H_ */
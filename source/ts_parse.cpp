@@ -0,0 +1,362 @@
+/**
+********************************************************************************
+* @file         ts_parse.cpp
+* @brief        Bounds-checked parsers of TS packet, PSI and PES structures
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "ts_parse.h"
+#include "ts_cursor.h"
+
+/**
+********************************************************************************
+* @def          PSI_CRC_SIZE
+* @brief        Size of CRC32 at the end of PSI section
+********************************************************************************
+*/
+#define PSI_CRC_SIZE    4
+
+/**
+********************************************************************************
+* @brief        Reads 33-bit time stamp of PES header (PTS or DTS)
+* @param        [in] p  Pointer to 5 bytes of time stamp
+* @return       Time stamp value
+********************************************************************************
+*/
+static inline uint64_t read_timestamp(const uint8_t* p)
+{
+    return ((uint64_t)(p[0] & 0x0e) << 29) | ((uint64_t)p[1] << 22) |
+        ((uint64_t)(p[2] & 0xfe) << 14) | ((uint64_t)p[3] << 7) |
+        ((uint64_t)p[4] >> 1);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS parse_payload(const uint8_t* packet, const uint8_t*& data,
+    size_t& size)
+{
+    STATUS result = STATUS_OK;
+
+    int afc = ts_afc::get(packet);
+    const uint8_t* payload = &packet[TS_PACKET_HEADER];
+    size_t pi = 0;
+
+    switch (afc)
+    {
+        case 1: // Payload only
+            break;
+
+        case 3: // Adaptation field followed by payload
+            pi = af_length::get(payload) + 1;
+            if (pi > TS_PACKET_PAYLOAD)
+            {
+                result = STATUS_FAIL;
+            }
+            break;
+
+        default: // Adaptation field only or reserved value
+            result = STATUS_AGAIN;
+            break;
+    }
+
+    data = &payload[pi];
+    size = (STATUS_OK == result) ? TS_PACKET_PAYLOAD - pi : 0;
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS parse_pcr(const uint8_t* packet, uint64_t& pcr)
+{
+    STATUS result = STATUS_AGAIN;
+    TSCursor cur(&packet[TS_PACKET_HEADER], TS_PACKET_PAYLOAD);
+
+    do
+    {
+        if (!(ts_afc::get(packet) & 0x02) || !cur.require(af_pcr_flag::END))
+        {
+            break;
+        }
+
+        size_t af_size = cur.get<af_length>();
+        if (af_size < 7 || af_size >= TS_PACKET_PAYLOAD ||
+            !cur.get<af_pcr_flag>())
+        {
+            break;
+        }
+
+        cur.skip(af_pcr_flag::END);
+        if (!cur.require(6))
+        {
+            break;
+        }
+
+        const uint8_t* p = cur.ptr();
+        uint64_t base = ((uint64_t)p[0] << 25) | ((uint64_t)p[1] << 17) |
+            ((uint64_t)p[2] << 9) | ((uint64_t)p[3] << 1) | (p[4] >> 7);
+        pcr = base * 300 + (((p[4] & 0x01) << 8) | p[5]);
+
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS parse_section(const uint8_t* data, size_t size,
+    const uint8_t*& section, size_t& sec_size)
+{
+    STATUS result = STATUS_FAIL;
+    TSCursor cur(data, size);
+
+    do
+    {
+        if (!cur.require(1))
+        {
+            break;
+        }
+        size_t pointer = cur.get<psi_pointer_field>();
+        cur.skip(1);
+
+        if (!cur.require(pointer + psi_section_length::END))
+        {
+            break;
+        }
+        cur.skip(pointer);
+
+        /**
+        ************************************************************************
+        * @note     Single check covers the whole section, all parsers below
+        *           work inside of this window
+        ************************************************************************
+        */
+        sec_size = psi_section_length::END + cur.get<psi_section_length>();
+        if (!cur.require(sec_size))
+        {
+            break;
+        }
+
+        section = cur.ptr();
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS parse_pat(const uint8_t* section, size_t size, struct psi_pat& pat)
+{
+    STATUS result = STATUS_FAIL;
+    TSCursor cur(section, size);
+
+    do
+    {
+        // Whole section is the window of all reads below
+        if (size < PSI_HEADER_SIZE + PSI_CRC_SIZE || !cur.require(size) ||
+            0x00 != cur.get<psi_table_id>())
+        {
+            break;
+        }
+
+        pat.stream_id = cur.get<psi_table_id_ext>();
+        pat.version   = cur.get<psi_version>();
+        pat.programs.clear();
+
+        size_t loop = size - PSI_HEADER_SIZE - PSI_CRC_SIZE;
+        cur.skip(PSI_HEADER_SIZE);
+        if (0 != loop % 4)
+        {
+            break;
+        }
+
+        for (size_t i = 0; i < loop; i += 4)
+        {
+            struct psi_program prog;
+            prog.number = cur.get<pat_program_number>();
+            prog.pid    = cur.get<pat_pid>();
+            pat.programs.push_back(prog);
+            cur.skip(4);
+        }
+
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS parse_pmt(const uint8_t* section, size_t size, struct psi_pmt& pmt)
+{
+    STATUS result = STATUS_FAIL;
+    TSCursor cur(section, size);
+
+    do
+    {
+        // Whole section is the window of all reads below
+        if (size < pmt_program_info_length::END + PSI_CRC_SIZE ||
+            !cur.require(size) || 0x02 != cur.get<psi_table_id>())
+        {
+            break;
+        }
+
+        pmt.program = cur.get<psi_table_id_ext>();
+        pmt.version = cur.get<psi_version>();
+        pmt.pcr_pid = cur.get<pmt_pcr_pid>();
+        pmt.streams.clear();
+
+        size_t pinfo_size = cur.get<pmt_program_info_length>();
+        cur.skip(pmt_program_info_length::END);
+        if (cur.left() < pinfo_size + PSI_CRC_SIZE)
+        {
+            break;
+        }
+        pmt.info      = cur.ptr();
+        pmt.info_size = pinfo_size;
+        cur.skip(pinfo_size);
+
+        /**
+        ************************************************************************
+        * @note     ES loop is parsed by its own cursor which excludes CRC, so
+        *           only one check per entry is needed: entry header and its
+        *           descriptors must fit into the loop
+        ************************************************************************
+        */
+        TSCursor es(cur.ptr(), cur.left() - PSI_CRC_SIZE);
+        while (0 != es.left())
+        {
+            if (!es.require(pmt_es_info_length::END))
+            {
+                break;
+            }
+
+            struct psi_stream stream;
+            stream.type      = es.get<pmt_stream_type>();
+            stream.pid       = es.get<pmt_elementary_pid>();
+            stream.info_size = es.get<pmt_es_info_length>();
+            es.skip(pmt_es_info_length::END);
+
+            if (!es.require(stream.info_size))
+            {
+                break;
+            }
+            stream.info = es.ptr();
+            es.skip(stream.info_size);
+
+            pmt.streams.push_back(stream);
+        }
+
+        if (0 != es.left())
+        {
+            break;
+        }
+
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS parse_pes_header(const uint8_t* data, size_t size,
+    struct pes_header& pes)
+{
+    STATUS result = STATUS_FAIL;
+    TSCursor cur(data, size);
+
+    do
+    {
+        if (!cur.require(pes_packet_length::END) ||
+            0x000001 != cur.get<pes_start_code>())
+        {
+            break;
+        }
+
+        pes.stream_id     = cur.get<pes_stream_id>();
+        pes.packet_length = cur.get<pes_packet_length>();
+        pes.header_size   = pes_packet_length::END;
+        pes.has_pts       = false;
+        pes.has_dts       = false;
+        pes.pts           = 0;
+        pes.dts           = 0;
+
+        /**
+        ************************************************************************
+        * @note     Streams without optional PES header: program stream map,
+        *           padding, private stream 2, ECM, EMM, DSMCC, H.222.1 type E
+        *           and program stream directory
+        ************************************************************************
+        */
+        switch (pes.stream_id)
+        {
+            case 0xbc: case 0xbe: case 0xbf: case 0xf0:
+            case 0xf1: case 0xf2: case 0xf8: case 0xff:
+                result = STATUS_OK;
+                break;
+        }
+
+        if (STATUS_OK == result)
+        {
+            break;
+        }
+
+        if (!cur.require(PES_HEADER_SIZE))
+        {
+            break;
+        }
+
+        int flags = cur.get<pes_pts_dts_flags>();
+        pes.header_size = PES_HEADER_SIZE + cur.get<pes_header_data_length>();
+        if (!cur.require(pes.header_size))
+        {
+            break;
+        }
+        cur.skip(PES_HEADER_SIZE);
+
+        if ((2 == flags || 3 == flags) &&
+            pes.header_size >= PES_HEADER_SIZE + 5)
+        {
+            pes.has_pts = true;
+            pes.pts = read_timestamp(cur.ptr());
+        }
+
+        if (3 == flags && pes.header_size >= PES_HEADER_SIZE + 10)
+        {
+            pes.has_dts = true;
+            pes.dts = read_timestamp(cur.ptr() + 5);
+        }
+
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
@@ -0,0 +1,180 @@
+/**
+********************************************************************************
+* @file         ts_parse.h
+* @brief        Bounds-checked parsers of TS packet, PSI and PES structures
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _TS_PARSE_H_
+#define _TS_PARSE_H_
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ts_processor.h"
+
+/**
+********************************************************************************
+* @def          PCR_WRAP
+* @brief        PCR values wrap around at 2^33 * 300 (27 MHz)
+********************************************************************************
+*/
+#define PCR_WRAP            (0x200000000ull * 300)
+
+/**
+********************************************************************************
+* @def          PTS_MASK
+* @brief        PTS/DTS values are 33-bit wide and wrap around
+********************************************************************************
+*/
+#define PTS_MASK            0x1ffffffffull
+
+/**
+********************************************************************************
+* @struct       psi_program
+* @brief        Program entry of PAT
+********************************************************************************
+*/
+struct psi_program
+{
+    uint16_t    number;     ///< Program number (0 - network PID)
+    uint16_t    pid;        ///< PMT PID (or network PID)
+};
+
+/**
+********************************************************************************
+* @struct       psi_pat
+* @brief        Program Association Table
+********************************************************************************
+*/
+struct psi_pat
+{
+    uint16_t                    stream_id;  ///< Transport stream ID
+    uint8_t                     version;    ///< Version number
+    std::vector<psi_program>    programs;   ///< Programs of the stream
+};
+
+/**
+********************************************************************************
+* @struct       psi_stream
+* @brief        Elementary stream entry of PMT
+********************************************************************************
+*/
+struct psi_stream
+{
+    uint8_t         type;       ///< Stream type
+    uint16_t        pid;        ///< Elementary stream PID
+    const uint8_t*  info;       ///< ES info descriptors (points to section)
+    uint16_t        info_size;  ///< Size of ES info descriptors
+};
+
+/**
+********************************************************************************
+* @struct       psi_pmt
+* @brief        Program Map Table
+********************************************************************************
+*/
+struct psi_pmt
+{
+    uint16_t                    program;    ///< Program number
+    uint8_t                     version;    ///< Version number
+    uint16_t                    pcr_pid;    ///< PCR PID
+    const uint8_t*              info;       ///< Program info descriptors
+    uint16_t                    info_size;  ///< Size of program info
+    std::vector<psi_stream>     streams;    ///< Elementary streams
+};
+
+/**
+********************************************************************************
+* @struct       pes_header
+* @brief        Parsed PES header
+********************************************************************************
+*/
+struct pes_header
+{
+    uint8_t     stream_id;      ///< Stream ID
+    uint16_t    packet_length;  ///< PES packet length (0 - unbounded)
+    size_t      header_size;    ///< Size of the whole PES header
+    bool        has_pts;        ///< PTS is present
+    bool        has_dts;        ///< DTS is present
+    uint64_t    pts;            ///< Presentation time stamp (90 kHz)
+    uint64_t    dts;            ///< Decoding time stamp (90 kHz)
+};
+
+/**
+********************************************************************************
+* @brief        Locates payload of TS packet after adaptation field
+* @param        [in] packet     TS packet (TS_PACKET_SIZE bytes)
+* @param        [out] data      Payload of the packet
+* @param        [out] size      Size of payload
+* @return       STATUS_OK on success, STATUS_AGAIN if packet has no payload,
+*               STATUS_FAIL if adaptation field is broken
+********************************************************************************
+*/
+STATUS parse_payload(const uint8_t* packet, const uint8_t*& data,
+    size_t& size);
+
+/**
+********************************************************************************
+* @brief        Reads PCR of adaptation field of TS packet
+* @param        [in] packet     TS packet (TS_PACKET_SIZE bytes)
+* @param        [out] pcr       PCR value (base * 300 + extension, 27 MHz)
+* @return       STATUS_OK if packet carries PCR, STATUS_AGAIN - otherwise
+********************************************************************************
+*/
+STATUS parse_pcr(const uint8_t* packet, uint64_t& pcr);
+
+/**
+********************************************************************************
+* @brief        Locates PSI section which starts in payload of TS packet with
+*               PUSI flag (pointer field is taken into account)
+* @param        [in] data       Payload of TS packet
+* @param        [in] size       Size of payload
+* @param        [out] section   Beginning of section (table_id)
+* @param        [out] sec_size  Size of the whole section including CRC
+* @return       STATUS_OK if the whole section is inside of payload,
+*               STATUS_FAIL - otherwise
+********************************************************************************
+*/
+STATUS parse_section(const uint8_t* data, size_t size,
+    const uint8_t*& section, size_t& sec_size);
+
+/**
+********************************************************************************
+* @brief        Parses PAT section
+* @param        [in] section    Section (starting with table_id)
+* @param        [in] size       Size of the whole section
+* @param        [out] pat       Parsed PAT
+* @return       STATUS_OK on success, STATUS_FAIL if section is broken
+********************************************************************************
+*/
+STATUS parse_pat(const uint8_t* section, size_t size, struct psi_pat& pat);
+
+/**
+********************************************************************************
+* @brief        Parses PMT section
+* @param        [in] section    Section (starting with table_id)
+* @param        [in] size       Size of the whole section
+* @param        [out] pmt       Parsed PMT. Descriptors point into section
+* @return       STATUS_OK on success, STATUS_FAIL if section is broken
+********************************************************************************
+*/
+STATUS parse_pmt(const uint8_t* section, size_t size, struct psi_pmt& pmt);
+
+/**
+********************************************************************************
+* @brief        Parses PES header at the beginning of PES packet
+* @param        [in] data   Beginning of PES packet
+* @param        [in] size   Size of available data
+* @param        [out] pes   Parsed PES header
+* @return       STATUS_OK on success, STATUS_FAIL if header is broken or
+*               doesn't fit into data
+********************************************************************************
+*/
+STATUS parse_pes_header(const uint8_t* data, size_t size,
+    struct pes_header& pes);
+
+#endif  /* !_TS_PARSE_H_ */
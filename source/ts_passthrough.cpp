@@ -0,0 +1,329 @@
+/**
+********************************************************************************
+* @file         ts_passthrough.cpp
+* @brief        Output of unmodified TS packets class implementation
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "ts_passthrough.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/sendfile.h>
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+TSPassthrough::TSPassthrough(const char* const filename)
+    : m_filename(filename)
+    , m_fd(-1)
+    , m_input_fd(-1)
+    , m_buffer(NULL)
+    , m_buffer_size(0)
+    , m_run_offset(0)
+    , m_run_size(0)
+    , m_run_kernel(false)
+    , m_method(METHOD_COPY_FILE_RANGE)
+    , m_written(0)
+    , m_moved(0)
+{
+
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+TSPassthrough::~TSPassthrough()
+{
+    if (-1 != m_fd)
+    {
+        fprintf(stdout, "TS output %s: %llu bytes (%llu bytes moved by "
+            "kernel)\n", m_filename.c_str(), (unsigned long long)m_written,
+            (unsigned long long)m_moved);
+        close(m_fd);
+        m_fd = -1;
+    }
+
+    free(m_buffer);
+    m_buffer = NULL;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSPassthrough::init(int input_fd)
+{
+    STATUS result = STATUS_FAIL;
+
+    do
+    {
+        m_fd = open(m_filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (-1 == m_fd)
+        {
+            fprintf(stderr, "Can't open/create TS output file (%s). Error: "
+                "%s\n", m_filename.c_str(), strerror(errno));
+            break;
+        }
+
+        m_buffer = static_cast<uint8_t*>(malloc(PASSTHROUGH_BUFFER_SIZE));
+        if (NULL == m_buffer)
+        {
+            fprintf(stderr, "Can't allocate TS output buffer\n");
+            break;
+        }
+
+        m_input_fd = input_fd;
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSPassthrough::write_packet(uint64_t offset, const uint8_t* packet)
+{
+    STATUS result = STATUS_OK;
+
+    do
+    {
+        if (0 != m_run_size && offset != m_run_offset + m_run_size)
+        {
+            result = end_run();
+            if (STATUS_OK != result)
+            {
+                break;
+            }
+        }
+
+        if (m_run_kernel)
+        {
+            m_run_size += TS_PACKET_SIZE;
+            break;
+        }
+
+        if (PASSTHROUGH_BUFFER_SIZE - m_buffer_size < TS_PACKET_SIZE)
+        {
+            /**
+            ********************************************************************
+            * @note     Buffered part of the run is written, so the rest of
+            *           the run starts from the current packet
+            ********************************************************************
+            */
+            result = flush_buffer();
+            if (STATUS_OK != result)
+            {
+                break;
+            }
+            m_run_size = 0;
+        }
+
+        if (0 == m_run_size)
+        {
+            m_run_offset = offset;
+        }
+
+        m_run_size += TS_PACKET_SIZE;
+        memcpy(&m_buffer[m_buffer_size], packet, TS_PACKET_SIZE);
+        m_buffer_size += TS_PACKET_SIZE;
+
+        if (-1 != m_input_fd && PASSTHROUGH_MIN_RUN <= m_run_size)
+        {
+            /**
+            ********************************************************************
+            * @note     Run is long enough. Its copy is dropped from the buffer
+            *           and the whole run will be moved by the kernel directly
+            *           from the input file
+            ********************************************************************
+            */
+            m_buffer_size -= m_run_size;
+            m_run_kernel = true;
+            result = flush_buffer();
+        }
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSPassthrough::flush()
+{
+    STATUS result = end_run();
+    if (STATUS_OK == result)
+    {
+        result = flush_buffer();
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSPassthrough::end_run()
+{
+    STATUS result = STATUS_OK;
+
+    if (m_run_kernel)
+    {
+        result = copy_run();
+    }
+
+    m_run_size   = 0;
+    m_run_kernel = false;
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSPassthrough::copy_run()
+{
+    STATUS result = STATUS_OK;
+
+    loff_t offset = m_run_offset;
+    uint64_t left = m_run_size;
+
+    while (0 != left && STATUS_OK == result)
+    {
+        ssize_t r = -1;
+
+        switch (m_method)
+        {
+            case METHOD_COPY_FILE_RANGE:
+                r = copy_file_range(m_input_fd, &offset, m_fd, NULL, left, 0);
+                break;
+
+            case METHOD_SENDFILE:
+            {
+                off_t off = offset;
+                r = sendfile(m_fd, m_input_fd, &off, left);
+                if (r > 0)
+                {
+                    offset = off;
+                }
+                break;
+            }
+
+            case METHOD_READ_WRITE:
+            {
+                size_t size = (left < PASSTHROUGH_BUFFER_SIZE) ? left :
+                    PASSTHROUGH_BUFFER_SIZE;
+                r = pread(m_input_fd, m_buffer, size, offset);
+                if (r > 0)
+                {
+                    result = write_all(m_buffer, r);
+                    offset += r;
+                }
+                break;
+            }
+        }
+
+        if (r > 0)
+        {
+            left -= r;
+            if (METHOD_READ_WRITE != m_method)
+            {
+                m_written += r;
+                m_moved   += r;
+            }
+            continue;
+        }
+
+        if (-1 == r && EINTR == errno)
+        {
+            continue;
+        }
+
+        /**
+        ************************************************************************
+        * @note     Method isn't supported by file systems of input and output
+        *           (e.g. EXDEV, EINVAL, ENOSYS), next slower one is used
+        ************************************************************************
+        */
+        if (-1 == r && METHOD_READ_WRITE != m_method)
+        {
+            m_method = static_cast<METHOD>(m_method + 1);
+            continue;
+        }
+
+        fprintf(stderr, "Can't copy packets to TS output file (%s). Error: "
+            "%s\n", m_filename.c_str(), (0 == r) ? "unexpected end of input" :
+            strerror(errno));
+        result = STATUS_FAIL;
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSPassthrough::flush_buffer()
+{
+    STATUS result = write_all(m_buffer, m_buffer_size);
+    m_buffer_size = 0;
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSPassthrough::write_all(const uint8_t* data, size_t size)
+{
+    STATUS result = STATUS_OK;
+
+    while (0 != size)
+    {
+        ssize_t r = write(m_fd, data, size);
+        if (r < 0)
+        {
+            if (EINTR == errno)
+            {
+                continue;
+            }
+
+            fprintf(stderr, "Can't write to TS output file (%s). Error: %s\n",
+                m_filename.c_str(), strerror(errno));
+            result = STATUS_FAIL;
+            break;
+        }
+
+        data      += r;
+        size      -= r;
+        m_written += r;
+    }
+
+    return result;
+}
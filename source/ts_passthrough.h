@@ -0,0 +1,161 @@
+/**
+********************************************************************************
+* @file         ts_passthrough.h
+* @brief        Output of unmodified TS packets class declaration
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _TS_PASSTHROUGH_H_
+#define _TS_PASSTHROUGH_H_
+
+#include <string>
+#include <stdint.h>
+
+#include "ts_processor.h"
+
+/**
+********************************************************************************
+* @def          PASSTHROUGH_BUFFER_SIZE
+* @brief        Size of buffer collecting short runs of packets
+********************************************************************************
+*/
+#define PASSTHROUGH_BUFFER_SIZE     (4096 * TS_PACKET_SIZE)
+
+/**
+********************************************************************************
+* @def          PASSTHROUGH_MIN_RUN
+* @brief        Minimal run of contiguous input packets which is moved by the
+*               kernel instead of copying through user space. Shorter runs
+*               are cheaper to collect into the buffer than to issue a
+*               syscall per run
+********************************************************************************
+*/
+#define PASSTHROUGH_MIN_RUN         (256 * TS_PACKET_SIZE)
+
+/**
+********************************************************************************
+* @class        TSPassthrough
+* @brief        Writes selected TS packets unmodified to the output file. Long
+*               runs of packets which are contiguous in the input file are
+*               moved from input to output descriptor inside the kernel
+*               (copy_file_range, sendfile), short runs are copied from the
+*               packet memory into the buffer
+********************************************************************************
+*/
+class TSPassthrough
+{
+public:
+    /**
+    ****************************************************************************
+    * @brief    The only allowed constructor for this class
+    * @param    [in] filename    Output TS file name
+    ****************************************************************************
+    */
+    explicit TSPassthrough(const char* const filename);
+
+    ~TSPassthrough();
+
+    /**
+    ****************************************************************************
+    * @brief    Creates output file and allocates buffer
+    * @param    [in] input_fd   Descriptor of regular input file packets are
+    *                           read from, -1 if input isn't a file (packets
+    *                           are always copied in this case)
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS init(int input_fd);
+
+    /**
+    ****************************************************************************
+    * @brief    Appends packet to the output
+    * @param    [in] offset Offset of the packet in the input file
+    * @param    [in] packet Packet data (TS_PACKET_SIZE bytes)
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS write_packet(uint64_t offset, const uint8_t* packet);
+
+    /**
+    ****************************************************************************
+    * @brief    Writes everything pending to the output file
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS flush(void);
+
+private:
+    /**
+    ****************************************************************************
+    * @brief    Finishes current run of contiguous packets
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS end_run(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Moves current run from input to output file inside the kernel.
+    *           Falls back to sendfile() and then to pread()/write() if file
+    *           systems don't support faster method
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS copy_run(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Writes collected packets to the output file
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS flush_buffer(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Writes whole memory block to the output file
+    * @param    [in] data   Data to write
+    * @param    [in] size   Size of data in bytes
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS write_all(const uint8_t* data, size_t size);
+
+    /**
+    ****************************************************************************
+    * @enum     METHOD
+    * @brief    Method used to move runs inside the kernel
+    ****************************************************************************
+    */
+    typedef enum
+    {
+        METHOD_COPY_FILE_RANGE  = 0,
+        METHOD_SENDFILE         = 1,
+        METHOD_READ_WRITE       = 2
+    } METHOD;
+
+private:    // Blocked implementations
+    TSPassthrough();
+    TSPassthrough(const TSPassthrough& r);
+    TSPassthrough& operator= (const TSPassthrough&);
+
+private:
+    std::string     m_filename;     ///< Output TS file name
+    int             m_fd;           ///< Output file descriptor
+    int             m_input_fd;     ///< Input file descriptor or -1
+
+    uint8_t*        m_buffer;       ///< Collected packets of short runs
+    size_t          m_buffer_size;  ///< Bytes stored in m_buffer
+
+    uint64_t        m_run_offset;   ///< Input offset of current run
+    uint64_t        m_run_size;     ///< Size of current run in bytes
+    bool            m_run_kernel;   ///< Current run is moved by kernel
+    METHOD          m_method;       ///< Method for moving runs
+
+    uint64_t        m_written;      ///< Bytes written in total
+    uint64_t        m_moved;        ///< Bytes moved inside the kernel
+};
+
+#endif  /* !_TS_PASSTHROUGH_H_ */
@@ -0,0 +1,395 @@
+/**
+********************************************************************************
+* @file         ts_playout.cpp
+* @brief        Output of TS packets to UDP destination paced by PCR
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "ts_playout.h"
+#include "ts_fields.h"
+#include "ts_parse.h"
+
+#include <errno.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/net_tstamp.h>
+
+/**
+********************************************************************************
+* @brief        Reads clock datagrams are scheduled by
+* @return       CLOCK_MONOTONIC time in nanoseconds
+********************************************************************************
+*/
+static uint64_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+TSPlayout::TSPlayout(const char* const destination)
+    : m_destination(destination)
+    , m_fd(-1)
+    , m_txtime(false)
+    , m_pcr_pid(-1)
+    , m_started(false)
+    , m_last_pcr(0)
+    , m_time(0)
+    , m_remainder(0)
+    , m_step(0)
+    , m_packets(0)
+    , m_last_packet(0)
+    , m_datagrams(0)
+    , m_batches(0)
+    , m_late(0)
+{
+
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+TSPlayout::~TSPlayout()
+{
+    if (-1 != m_fd)
+    {
+        fprintf(stdout, "UDP output %s: %llu datagrams in %llu batches "
+            "(late: %llu)\n", m_destination.c_str(),
+            (unsigned long long)m_datagrams, (unsigned long long)m_batches,
+            (unsigned long long)m_late);
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSPlayout::init()
+{
+    STATUS result = STATUS_FAIL;
+
+    do
+    {
+        if (0 != m_destination.compare(0, 6, "udp://"))
+        {
+            fprintf(stderr, "Wrong UDP output (%s). Expected: "
+                "udp://<address>:<port>\n", m_destination.c_str());
+            break;
+        }
+
+        std::string host = m_destination.substr(6);
+        size_t colon = host.rfind(':');
+        if (std::string::npos == colon)
+        {
+            fprintf(stderr, "Port is missing in %s\n", m_destination.c_str());
+            break;
+        }
+        std::string port = host.substr(colon + 1);
+        host.erase(colon);
+
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family   = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+
+        struct addrinfo* ai = NULL;
+        int r = getaddrinfo(host.c_str(), port.c_str(), &hints, &ai);
+        if (0 != r)
+        {
+            fprintf(stderr, "Can't resolve %s. Error: %s\n",
+                m_destination.c_str(), gai_strerror(r));
+            break;
+        }
+
+        m_fd = socket(AF_INET, SOCK_DGRAM, 0);
+        r = (-1 == m_fd) ? -1 : connect(m_fd, ai->ai_addr, ai->ai_addrlen);
+        freeaddrinfo(ai);
+        if (0 != r)
+        {
+            fprintf(stderr, "Can't connect to %s. Error: %s\n",
+                m_destination.c_str(), strerror(errno));
+            break;
+        }
+
+        /**
+        ************************************************************************
+        * @note     Kernel without SO_TXTIME (or headers without it) leaves
+        *           pacing to clock_nanosleep() of every batch
+        ************************************************************************
+        */
+#ifdef SO_TXTIME
+        struct sock_txtime txtime;
+        txtime.clockid = CLOCK_MONOTONIC;
+        txtime.flags   = 0;
+        m_txtime = (0 == setsockopt(m_fd, SOL_SOCKET, SO_TXTIME, &txtime,
+            sizeof(txtime)));
+#endif
+
+        fprintf(stdout, "TSPlayout initialized:\n"
+                        "\tDestination: %s\n"
+                        "\tSO_TXTIME: %s\n",
+                        m_destination.c_str(), m_txtime ? "yes" : "no");
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSPlayout::push(const uint8_t* packet, bool selected)
+{
+    STATUS result = STATUS_OK;
+    uint64_t position = m_packets++;
+
+    if (selected)
+    {
+        m_data.insert(m_data.end(), packet, packet + TS_PACKET_SIZE);
+        m_pending.push_back(position);
+    }
+
+    uint64_t pcr = 0;
+    bool has_pcr = (STATUS_OK == parse_pcr(packet, pcr));
+    if (has_pcr && m_pcr_pid < 0)
+    {
+        m_pcr_pid = ts_pid::get(packet);
+    }
+
+    if (has_pcr && m_pcr_pid == (int)ts_pid::get(packet))
+    {
+        /**
+        ************************************************************************
+        * @note     The first PCR is sent at once. PCR jump is discontinuity,
+        *           time goes on with the bitrate of the previous interval
+        ************************************************************************
+        */
+        uint64_t delta = (pcr + PCR_WRAP - m_last_pcr) % PCR_WRAP;
+        uint64_t span  = position - m_last_packet;
+        uint64_t time  = 0;
+        if (!m_started)
+        {
+            m_started = true;
+            m_time = now_ns();
+            time   = m_time;
+        }
+        else if (0 == delta || PLAYOUT_MAX_PCR_GAP < delta)
+        {
+            time = m_time + (span * m_step >> 16);
+        }
+        else
+        {
+            // Remainder keeps 27 MHz to ns conversion from drifting
+            uint64_t scaled = delta * 1000 + m_remainder;
+            time = m_time + scaled / 27;
+            m_remainder = scaled % 27;
+            m_step = (0 == span) ? m_step : ((time - m_time) << 16) / span;
+        }
+
+        m_last_pcr = pcr;
+        set_times(position, time);
+        result = send_ready(false);
+    }
+    else if (PLAYOUT_MAX_PENDING <= m_pending.size())
+    {
+        if (!m_started)
+        {
+            m_time = now_ns();
+        }
+
+        set_times(position, m_time + ((position - m_last_packet) * m_step >>
+            16));
+        result = send_ready(false);
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSPlayout::flush()
+{
+    if (!m_pending.empty())
+    {
+        if (!m_started)
+        {
+            m_time = now_ns();
+        }
+
+        uint64_t position = m_pending.back();
+        set_times(position, m_time + ((position - m_last_packet) * m_step >>
+            16));
+    }
+
+    return send_ready(true);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSPlayout::set_times(uint64_t position, uint64_t time)
+{
+    uint64_t span = position - m_last_packet;
+    size_t first = m_data.size() / TS_PACKET_SIZE - m_pending.size();
+
+    // Unsent data starts with datagram, so datagrams start every N packets
+    for (size_t i = 0; i < m_pending.size(); ++i)
+    {
+        if (0 == (first + i) % PLAYOUT_PACKETS)
+        {
+            m_times.push_back((0 == span) ? time : m_time + (time - m_time) *
+                (m_pending[i] - m_last_packet) / span);
+        }
+    }
+
+    m_pending.clear();
+    m_time        = time;
+    m_last_packet = position;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSPlayout::send_ready(bool all)
+{
+    STATUS result = STATUS_OK;
+
+    size_t complete = m_data.size() / PLAYOUT_DATAGRAM;
+    size_t ready = (all || m_times.size() < complete) ? m_times.size() :
+        complete;
+
+    size_t sent = 0;
+    while (STATUS_OK == result && sent < ready)
+    {
+        // Batch is limited by count and by time span of its datagrams
+        size_t count = 1;
+        while (sent + count < ready && PLAYOUT_BATCH > count &&
+            m_times[sent + count] <= m_times[sent] + PLAYOUT_BATCH_SPAN)
+        {
+            ++count;
+        }
+
+        result = send_batch(sent, count);
+        sent += count;
+    }
+
+    size_t bytes = sent * PLAYOUT_DATAGRAM;
+    m_data.erase(m_data.begin(), m_data.begin() +
+        ((bytes < m_data.size()) ? bytes : m_data.size()));
+    m_times.erase(m_times.begin(), m_times.begin() + sent);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSPlayout::send_batch(size_t first, size_t count)
+{
+    STATUS result = STATUS_OK;
+
+    uint64_t due  = m_times[first];
+    uint64_t wake = (m_txtime && PLAYOUT_LEAD < due) ? due - PLAYOUT_LEAD :
+        due;
+    struct timespec ts;
+    ts.tv_sec  = wake / 1000000000ull;
+    ts.tv_nsec = wake % 1000000000ull;
+    while (EINTR == clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts,
+        NULL))
+    {
+
+    }
+
+    struct mmsghdr msgs[PLAYOUT_BATCH];
+    struct iovec iov[PLAYOUT_BATCH];
+    union
+    {
+        char            buf[CMSG_SPACE(sizeof(uint64_t))];
+        struct cmsghdr  align;
+    } control[PLAYOUT_BATCH];
+    memset(msgs, 0, sizeof(msgs));
+
+    uint64_t now = now_ns();
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t offset = (first + i) * PLAYOUT_DATAGRAM;
+        size_t left = m_data.size() - offset;
+        iov[i].iov_base = &m_data[offset];
+        iov[i].iov_len  = (left < PLAYOUT_DATAGRAM) ? left : PLAYOUT_DATAGRAM;
+        msgs[i].msg_hdr.msg_iov    = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+
+        uint64_t time = m_times[first + i];
+        m_late += (time + PLAYOUT_BATCH_SPAN < now) ? 1 : 0;
+
+        // Datagram which is already due is sent without delay
+#ifdef SO_TXTIME
+        if (m_txtime && now < time)
+        {
+            msgs[i].msg_hdr.msg_control    = control[i].buf;
+            msgs[i].msg_hdr.msg_controllen = sizeof(control[i].buf);
+            struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msgs[i].msg_hdr);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type  = SCM_TXTIME;
+            cmsg->cmsg_len   = CMSG_LEN(sizeof(uint64_t));
+            memcpy(CMSG_DATA(cmsg), &time, sizeof(time));
+        }
+#endif
+    }
+
+    /**
+    ****************************************************************************
+    * @note     Connected socket reports ICMP port unreachable of previous
+    *           datagrams once (nobody listens yet), sending goes on
+    ****************************************************************************
+    */
+    size_t done = 0;
+    while (done < count)
+    {
+        int r = sendmmsg(m_fd, &msgs[done], count - done, 0);
+        if (0 < r)
+        {
+            done += r;
+        }
+        else if (EINTR != errno && ECONNREFUSED != errno)
+        {
+            fprintf(stderr, "Can't send to %s. Error: %s\n",
+                m_destination.c_str(), strerror(errno));
+            result = STATUS_FAIL;
+            break;
+        }
+    }
+
+    m_datagrams += done;
+    m_batches   += 1;
+
+    return result;
+}
@@ -0,0 +1,198 @@
+/**
+********************************************************************************
+* @file         ts_playout.h
+* @brief        Output of TS packets to UDP destination paced by PCR
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _TS_PLAYOUT_H_
+#define _TS_PLAYOUT_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "ts_processor.h"
+
+/**
+********************************************************************************
+* @def          PLAYOUT_PACKETS
+* @brief        Number of TS packets in datagram (1316 bytes fit Ethernet MTU)
+********************************************************************************
+*/
+#define PLAYOUT_PACKETS     7
+
+/**
+********************************************************************************
+* @def          PLAYOUT_DATAGRAM
+* @brief        Size of complete datagram
+********************************************************************************
+*/
+#define PLAYOUT_DATAGRAM    (PLAYOUT_PACKETS * TS_PACKET_SIZE)
+
+/**
+********************************************************************************
+* @def          PLAYOUT_BATCH
+* @brief        Maximal number of datagrams given to sendmmsg() at once
+********************************************************************************
+*/
+#define PLAYOUT_BATCH       16
+
+/**
+********************************************************************************
+* @def          PLAYOUT_BATCH_SPAN
+* @brief        Maximal distance between send times of the first and the last
+*               datagram of batch (nanoseconds, 2 ms)
+********************************************************************************
+*/
+#define PLAYOUT_BATCH_SPAN  2000000ull
+
+/**
+********************************************************************************
+* @def          PLAYOUT_LEAD
+* @brief        Time batch is given to the kernel before its first datagram
+*               is due when send times are set by SO_TXTIME (nanoseconds)
+********************************************************************************
+*/
+#define PLAYOUT_LEAD        500000ull
+
+/**
+********************************************************************************
+* @def          PLAYOUT_MAX_PCR_GAP
+* @brief        Maximal PCR distance between neighbour PCR packets (27 MHz,
+*               1 second). Larger step or step back is discontinuity, time
+*               of output goes on from the last PCR
+********************************************************************************
+*/
+#define PLAYOUT_MAX_PCR_GAP 27000000ull
+
+/**
+********************************************************************************
+* @def          PLAYOUT_MAX_PENDING
+* @brief        Maximal number of selected packets waiting for PCR. Stream
+*               without PCR is sent with the last known bitrate (or at once)
+********************************************************************************
+*/
+#define PLAYOUT_MAX_PENDING 65536
+
+/**
+********************************************************************************
+* @class        TSPlayout
+* @brief        Sends selected TS packets to UDP destination in real time.
+*               Send time of packets between two PCRs of PCR PID is
+*               interpolated by their position in the input (constant bitrate
+*               between PCRs), PCR time is mapped to CLOCK_MONOTONIC at the
+*               first PCR. Datagrams of PLAYOUT_PACKETS packets are sent in
+*               batches by sendmmsg(): the caller sleeps (clock_nanosleep)
+*               until the batch is due, send time of each datagram of the
+*               batch is given to the kernel by SO_TXTIME
+* @note         SO_TXTIME is honoured by fq (or etf) qdisc only. Without it
+*               datagrams of batch leave at once, so jitter is bounded by
+*               PLAYOUT_BATCH_SPAN. Packets are sent from the packet loop,
+*               so input is read no faster than it is played
+********************************************************************************
+*/
+class TSPlayout
+{
+public:
+    /**
+    ****************************************************************************
+    * @brief    The only allowed constructor for this class
+    * @param    [in] destination    udp://<address>:<port>
+    ****************************************************************************
+    */
+    explicit TSPlayout(const char* const destination);
+
+    ~TSPlayout();
+
+    /**
+    ****************************************************************************
+    * @brief    Creates socket connected to the destination
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS init(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Takes the next packet of the input. All packets give timing
+    *           (PCR and position), only selected ones are sent
+    * @param    [in] packet     TS packet
+    * @param    [in] selected   Packet is sent
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS push(const uint8_t* packet, bool selected);
+
+    /**
+    ****************************************************************************
+    * @brief    Sends packets left after the last PCR with the bitrate of the
+    *           last PCR interval
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS flush(void);
+
+private:
+    /**
+    ****************************************************************************
+    * @brief    Gives send times to packets waiting for PCR. Times are
+    *           interpolated between the previous PCR and the given position
+    * @param    [in] position   Input position of the packet
+    * @param    [in] time       Send time of the packet (ns)
+    * @return   void
+    ****************************************************************************
+    */
+    void set_times(uint64_t position, uint64_t time);
+
+    /**
+    ****************************************************************************
+    * @brief    Sends datagrams whose send time is known
+    * @param    [in] all    Incomplete datagram is sent as well
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS send_ready(bool all);
+
+    /**
+    ****************************************************************************
+    * @brief    Waits for the first datagram of the batch and sends the batch
+    * @param    [in] first  Index of the first datagram of the batch
+    * @param    [in] count  Number of datagrams in the batch
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS send_batch(size_t first, size_t count);
+
+private:    // Blocked implementations
+    TSPlayout();
+    TSPlayout(const TSPlayout& r);
+    TSPlayout& operator= (const TSPlayout&);
+
+private:
+    std::string     m_destination;      ///< udp://<address>:<port>
+    int             m_fd;               ///< Connected UDP socket
+    bool            m_txtime;           ///< SO_TXTIME is enabled
+
+    int             m_pcr_pid;          ///< PCR PID, -1 until found
+    bool            m_started;          ///< The first PCR was found
+    uint64_t        m_last_pcr;         ///< The last PCR
+    uint64_t        m_time;             ///< Send time of the last PCR (ns)
+    uint64_t        m_remainder;        ///< Part of ns left of PCR ticks / 27
+    uint64_t        m_step;             ///< ns * 2^16 per input packet
+
+    uint64_t        m_packets;          ///< Input packets pushed
+    uint64_t        m_last_packet;      ///< Input position of the last PCR
+    std::vector<uint64_t> m_pending;    ///< Input positions of untimed packets
+
+    std::vector<uint8_t> m_data;        ///< Packets of unsent datagrams
+    std::vector<uint64_t> m_times;      ///< Send times of the datagrams
+
+    uint64_t        m_datagrams;        ///< Datagrams sent
+    uint64_t        m_batches;          ///< Calls of sendmmsg()
+    uint64_t        m_late;             ///< Datagrams sent after their time
+};
+
+#endif  /* !_TS_PLAYOUT_H_ */
@@ -0,0 +1,551 @@
+/**
+********************************************************************************
+* @file         ts_probe.cpp
+* @brief        Probe of MPEG-TS file: programs, services and stream
+*               properties from the head of the file
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "ts_probe.h"
+#include "ts_fields.h"
+#include "ts_parse.h"
+#include "ts_descriptors.h"
+
+#include <errno.h>
+#include <string.h>
+
+/**
+********************************************************************************
+* @def          PROBE_PES_MAX
+* @brief        PES payload collected for headers search. Parameter sets are
+*               at the beginning of key frame, audio header - of each PES
+********************************************************************************
+*/
+#define PROBE_PES_MAX       (256 * 1024)
+
+/**
+********************************************************************************
+* @def          PROBE_SDT_WINDOW
+* @brief        Bytes read for SDT after everything else is known (SDT is
+*               repeated at least every 2 s)
+********************************************************************************
+*/
+#define PROBE_SDT_WINDOW    (2 * 1024 * 1024)
+
+/**
+********************************************************************************
+* @brief        Prints JSON string. Bytes above ASCII are taken as Latin-1
+* @param        [in] out    Output stream
+* @param        [in] text   Text
+* @return       void
+********************************************************************************
+*/
+static void print_json_string(FILE* out, const std::string& text)
+{
+    fputc('"', out);
+    for (size_t i = 0; i < text.size(); ++i)
+    {
+        uint8_t c = static_cast<uint8_t>(text[i]);
+        if ('"' == c || '\\' == c)
+        {
+            fprintf(out, "\\%c", c);
+        }
+        else if (c < 0x20 || c >= 0x80)
+        {
+            fprintf(out, "\\u%04x", c);
+        }
+        else
+        {
+            fputc(c, out);
+        }
+    }
+    fputc('"', out);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+TSProbe::TSProbe(const char* const filename, uint64_t limit)
+    : m_filename(filename)
+    , m_limit(limit)
+    , m_bytes(0)
+    , m_complete(false)
+    , m_has_pat(false)
+    , m_stream_id(0)
+    , m_has_sdt(false)
+    , m_sdt_wait(0)
+{
+    // PAT and SDT, assemblers of PMTs are added by PAT
+    m_sections[0];
+    m_sections[SI_PID_SDT];
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSProbe::run()
+{
+    STATUS result = STATUS_FAIL;
+    FILE* file = NULL;
+
+    do
+    {
+        file = fopen(m_filename.c_str(), "rb");
+        if (NULL == file)
+        {
+            fprintf(stderr, "Can't open input file (%s). Error: %s\n",
+                m_filename.c_str(), strerror(errno));
+            break;
+        }
+
+        std::vector<uint8_t> buffer(TS_READ_PACKETS * TS_PACKET_SIZE);
+        bool eof = false;
+
+        while (!m_complete && !eof && m_bytes < m_limit)
+        {
+            size_t want = buffer.size();
+            if (m_limit - m_bytes < want)
+            {
+                want = (m_limit - m_bytes + TS_PACKET_SIZE - 1) /
+                    TS_PACKET_SIZE * TS_PACKET_SIZE;
+            }
+
+            size_t read_bytes = fread(&buffer[0], 1, want, file);
+            eof = (read_bytes < want);
+
+            for (size_t i = 0; i + TS_PACKET_SIZE <= read_bytes; i +=
+                TS_PACKET_SIZE)
+            {
+                push(&buffer[i]);
+                m_bytes += TS_PACKET_SIZE;
+                if (complete())
+                {
+                    m_complete = true;
+                    break;
+                }
+            }
+        }
+
+        if (ferror(file))
+        {
+            fprintf(stderr, "Can't read input file (%s). Error: %s\n",
+                m_filename.c_str(), strerror(errno));
+            break;
+        }
+
+        if (!m_has_pat)
+        {
+            fprintf(stderr, "PAT wasn't found in first %llu bytes of %s!\n",
+                (unsigned long long)m_bytes, m_filename.c_str());
+            break;
+        }
+
+        result = STATUS_OK;
+
+    } while(0);
+
+    if (NULL != file)
+    {
+        fclose(file);
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProbe::push(const uint8_t* packet)
+{
+    do
+    {
+        if (TS_SYNC_BYTE != ts_sync_byte::get(packet) ||
+            0 != ts_scrambling::get(packet))
+        {
+            break;
+        }
+
+        uint16_t pid = ts_pid::get(packet);
+
+        std::map<uint16_t, SectionAssembler>::iterator it =
+            m_sections.find(pid);
+        if (m_sections.end() != it)
+        {
+            it->second.push(packet);
+
+            const uint8_t* section = NULL;
+            size_t size = 0;
+            while (STATUS_OK == it->second.next_section(section, size))
+            {
+                process_section(section, size, pid);
+            }
+            break;
+        }
+
+        std::map<uint16_t, probe_stream>::iterator st = m_streams.find(pid);
+        if (m_streams.end() != st)
+        {
+            process_pes(packet, st->second);
+        }
+
+    } while(0);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProbe::process_section(const uint8_t* section, size_t size,
+    uint16_t pid)
+{
+    int table_id = psi_table_id::get(section);
+
+    do
+    {
+        if (size < PSI_HEADER_SIZE + 4 || !psi_syntax_indicator::get(section) ||
+            !psi_current_next::get(section) || 0 != psi_crc32(section, size))
+        {
+            break;
+        }
+
+        if (0 == pid && 0x00 == table_id && !m_has_pat)
+        {
+            struct psi_pat pat;
+            if (STATUS_OK != parse_pat(section, size, pat))
+            {
+                break;
+            }
+
+            m_has_pat = true;
+            m_stream_id = pat.stream_id;
+            for (size_t i = 0; i < pat.programs.size(); ++i)
+            {
+                if (0 == pat.programs[i].number)
+                {
+                    continue;   // Network PID
+                }
+
+                probe_program program;
+                program.number      = pat.programs[i].number;
+                program.pmt_pid     = pat.programs[i].pid;
+                program.has_pmt     = false;
+                program.pcr_pid     = 0x1fff;
+                program.has_service = false;
+                m_programs.push_back(program);
+                m_sections[program.pmt_pid];
+            }
+            break;
+        }
+
+        if (0x02 == table_id)
+        {
+            uint16_t number = psi_table_id_ext::get(section);
+            for (size_t i = 0; i < m_programs.size(); ++i)
+            {
+                probe_program& program = m_programs[i];
+                struct psi_pmt pmt;
+                if (program.has_pmt || pid != program.pmt_pid ||
+                    number != program.number ||
+                    STATUS_OK != parse_pmt(section, size, pmt))
+                {
+                    continue;
+                }
+
+                program.has_pmt = true;
+                program.pcr_pid = pmt.pcr_pid;
+
+                for (size_t j = 0; j < pmt.streams.size(); ++j)
+                {
+                    probe_stream stream;
+                    parse_stream_info(pmt.streams[j], stream.info);
+                    stream.done      = (STREAM_VIDEO != stream.info.kind &&
+                        STREAM_AUDIO != stream.info.kind);
+                    stream.started   = false;
+                    stream.has_pts   = false;
+                    stream.pts       = 0;
+                    stream.has_props = false;
+                    memset(&stream.props, 0, sizeof(stream.props));
+
+                    program.pids.push_back(stream.info.pid);
+                    if (m_streams.end() == m_streams.find(stream.info.pid) &&
+                        m_sections.end() == m_sections.find(stream.info.pid))
+                    {
+                        m_streams[stream.info.pid] = stream;
+                    }
+                }
+            }
+            break;
+        }
+
+        // SDT actual may have several sections, all of them are collected
+        if (SI_PID_SDT == pid && 0x42 == table_id && !m_has_sdt)
+        {
+            std::vector<struct si_service> services;
+            if (STATUS_OK != parse_sdt(section, size, services))
+            {
+                break;
+            }
+
+            if (m_sdt_sections.empty())
+            {
+                m_sdt_sections.resize(psi_last_section_number::get(section) +
+                    1, false);
+            }
+
+            size_t number = psi_section_number::get(section);
+            if (number < m_sdt_sections.size())
+            {
+                m_sdt_sections[number] = true;
+            }
+
+            for (size_t i = 0; i < services.size(); ++i)
+            {
+                for (size_t j = 0; j < m_programs.size(); ++j)
+                {
+                    if (services[i].service_id == m_programs[j].number)
+                    {
+                        m_programs[j].has_service = true;
+                        m_programs[j].service = services[i];
+                    }
+                }
+            }
+
+            m_has_sdt = true;
+            for (size_t i = 0; i < m_sdt_sections.size(); ++i)
+            {
+                m_has_sdt = m_has_sdt && m_sdt_sections[i];
+            }
+        }
+
+    } while(0);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProbe::process_pes(const uint8_t* packet, probe_stream& stream)
+{
+    const uint8_t* data = NULL;
+    size_t size = 0;
+
+    do
+    {
+        if (STATUS_OK != parse_payload(packet, data, size) || 0 == size)
+        {
+            break;
+        }
+
+        if (ts_pusi::get(packet))
+        {
+            if (stream.started)
+            {
+                finish_pes(stream);
+            }
+
+            struct pes_header pes;
+            if (STATUS_OK != parse_pes_header(data, size, pes))
+            {
+                break;
+            }
+
+            if (!stream.has_pts && pes.has_pts)
+            {
+                stream.has_pts = true;
+                stream.pts = pes.pts;
+            }
+
+            if (stream.done)
+            {
+                break;
+            }
+
+            stream.started = true;
+            stream.pes.assign(data + pes.header_size, data + size);
+        }
+        else if (stream.started)
+        {
+            stream.pes.insert(stream.pes.end(), data, data + size);
+        }
+
+        if (stream.started && stream.pes.size() >= PROBE_PES_MAX)
+        {
+            finish_pes(stream);
+        }
+
+    } while(0);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProbe::finish_pes(probe_stream& stream)
+{
+    STATUS result = STATUS_AGAIN;
+
+    if (!stream.pes.empty())
+    {
+        result = parse_es_props(stream.info.codec, &stream.pes[0],
+            stream.pes.size(), stream.props);
+    }
+
+    // Not supported codecs are done with the first PES
+    stream.has_props = (STATUS_OK == result);
+    stream.done      = (STATUS_AGAIN != result);
+    stream.started   = false;
+    stream.pes.clear();
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+bool TSProbe::complete()
+{
+    if (!m_has_pat)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < m_programs.size(); ++i)
+    {
+        if (!m_programs[i].has_pmt)
+        {
+            return false;
+        }
+    }
+
+    std::map<uint16_t, probe_stream>::const_iterator it = m_streams.begin();
+    for (; m_streams.end() != it; ++it)
+    {
+        if (!it->second.done)
+        {
+            return false;
+        }
+    }
+
+    if (0 == m_sdt_wait)
+    {
+        m_sdt_wait = m_bytes;
+    }
+
+    return m_has_sdt || m_bytes - m_sdt_wait >= PROBE_SDT_WINDOW;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProbe::print_json(FILE* out) const
+{
+    fprintf(out, "{\n  \"file\": ");
+    print_json_string(out, m_filename);
+    fprintf(out, ",\n  \"bytes_read\": %llu,\n  \"complete\": %s,\n"
+        "  \"transport_stream_id\": %u,\n  \"programs\": [",
+        (unsigned long long)m_bytes, m_complete ? "true" : "false",
+        m_stream_id);
+
+    for (size_t i = 0; i < m_programs.size(); ++i)
+    {
+        const probe_program& program = m_programs[i];
+        fprintf(out, "%s\n    {\n      \"number\": %u,\n      \"pmt_pid\": %u",
+            (0 == i) ? "" : ",", program.number, program.pmt_pid);
+        if (program.has_pmt)
+        {
+            fprintf(out, ",\n      \"pcr_pid\": %u", program.pcr_pid);
+        }
+
+        if (program.has_service)
+        {
+            fprintf(out, ",\n      \"service\": { \"type\": %u, \"provider\": ",
+                program.service.type);
+            print_json_string(out, program.service.provider);
+            fprintf(out, ", \"name\": ");
+            print_json_string(out, program.service.name);
+            fprintf(out, " }");
+        }
+
+        fprintf(out, ",\n      \"streams\": [");
+        size_t printed = 0;
+        for (size_t j = 0; j < program.pids.size(); ++j)
+        {
+            std::map<uint16_t, probe_stream>::const_iterator it =
+                m_streams.find(program.pids[j]);
+            if (m_streams.end() == it)
+            {
+                continue;
+            }
+
+            const probe_stream& stream = it->second;
+            const struct es_props& props = stream.props;
+            fprintf(out, "%s\n        { \"pid\": %u, \"stream_type\": %u, "
+                "\"kind\": \"%s\", \"codec\": \"%s\"", (0 == printed++) ? "" :
+                ",", stream.info.pid, stream.info.type,
+                kind_name(stream.info.kind), codec_name(stream.info.codec));
+
+            if (0 != stream.info.language[0])
+            {
+                fprintf(out, ", \"language\": ");
+                print_json_string(out, stream.info.language);
+            }
+
+            if (stream.has_pts)
+            {
+                fprintf(out, ", \"start_pts\": %llu",
+                    (unsigned long long)stream.pts);
+            }
+
+            if (stream.has_props && STREAM_VIDEO == stream.info.kind)
+            {
+                fprintf(out, ", \"width\": %u, \"height\": %u", props.width,
+                    props.height);
+                if (0 != props.frame_rate_den)
+                {
+                    fprintf(out, ", \"frame_rate\": %.6g",
+                        (double)props.frame_rate_num / props.frame_rate_den);
+                }
+
+                if (0 != props.profile)
+                {
+                    fprintf(out, ", \"profile\": %d, \"level\": %d",
+                        props.profile, props.level);
+                }
+            }
+
+            if (stream.has_props && STREAM_AUDIO == stream.info.kind)
+            {
+                fprintf(out, ", \"sample_rate\": %u, \"channels\": %u",
+                    props.sample_rate, props.channels);
+                if (0 != props.profile)
+                {
+                    fprintf(out, ", \"%s\": %d", (CODEC_MPA ==
+                        stream.info.codec) ? "layer" : "object_type",
+                        props.profile);
+                }
+            }
+
+            if (stream.has_props && 0 != props.bitrate)
+            {
+                fprintf(out, ", \"bitrate\": %u", props.bitrate);
+            }
+            fprintf(out, " }");
+        }
+        fprintf(out, "%s]\n    }", program.pids.empty() ? "" : "\n      ");
+    }
+
+    fprintf(out, "%s]\n}\n", m_programs.empty() ? "" : "\n  ");
+}
@@ -0,0 +1,180 @@
+/**
+********************************************************************************
+* @file         ts_probe.h
+* @brief        Probe of MPEG-TS file: programs, services and stream
+*               properties from the head of the file
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _TS_PROBE_H_
+#define _TS_PROBE_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "ts_processor.h"
+#include "ts_section.h"
+#include "es_headers.h"
+#include "dvb_si.h"
+
+/**
+********************************************************************************
+* @def          PROBE_DEFAULT_LIMIT
+* @brief        Default number of bytes probe reads at most
+********************************************************************************
+*/
+#define PROBE_DEFAULT_LIMIT     (32 * 1024 * 1024)
+
+/**
+********************************************************************************
+* @class        TSProbe
+* @brief        Reads MPEG-TS file only until PAT, all PMTs, SDT and the
+*               first describing header of each video and audio stream (SPS
+*               or sequence header, audio frame header) are seen, or until
+*               byte limit is reached, and prints them as JSON
+* @note         SDT is optional: it is waited for PROBE_SDT_WINDOW bytes
+*               after everything else is known. Subtitle, teletext and data
+*               streams are sparse, they are reported from PMT only
+********************************************************************************
+*/
+class TSProbe
+{
+public:
+    /**
+    ****************************************************************************
+    * @brief    The only allowed constructor for this class
+    * @param    [in] filename   Input MPEG-TS file name
+    * @param    [in] limit      Maximal number of bytes to read
+    ****************************************************************************
+    */
+    TSProbe(const char* const filename, uint64_t limit);
+
+    /**
+    ****************************************************************************
+    * @brief    Reads the file until everything is known or limit is reached
+    * @return   STATUS_OK on success (even if limit was reached), STATUS_FAIL
+    *           if file can't be read or has no PAT
+    ****************************************************************************
+    */
+    STATUS run(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Prints probe result as JSON object
+    * @param    [in] out    Output stream
+    * @return   void
+    ****************************************************************************
+    */
+    void print_json(FILE* out) const;
+
+private:
+    /**
+    ****************************************************************************
+    * @struct   probe_stream
+    * @brief    Elementary stream of PMT and its properties
+    ****************************************************************************
+    */
+    struct probe_stream
+    {
+        struct ts_stream_info   info;       ///< Metadata of PMT
+        bool                    done;       ///< Nothing to wait for
+        bool                    started;    ///< PES payload is collected
+        bool                    has_pts;    ///< First PTS is known
+        uint64_t                pts;        ///< First PTS
+        bool                    has_props;  ///< Properties are known
+        struct es_props         props;      ///< Properties of headers
+        std::vector<uint8_t>    pes;        ///< Collected PES payload
+    };
+
+    /**
+    ****************************************************************************
+    * @struct   probe_program
+    * @brief    Program of PAT
+    ****************************************************************************
+    */
+    struct probe_program
+    {
+        uint16_t                number;     ///< Program number
+        uint16_t                pmt_pid;    ///< PMT PID
+        bool                    has_pmt;    ///< PMT is parsed
+        uint16_t                pcr_pid;    ///< PCR PID
+        std::vector<uint16_t>   pids;       ///< Elementary streams
+        bool                    has_service;    ///< SDT entry is known
+        struct si_service       service;    ///< SDT entry
+    };
+
+    /**
+    ****************************************************************************
+    * @brief    Processes packet of the file
+    * @param    [in] packet TS packet
+    * @return   void
+    ****************************************************************************
+    */
+    void push(const uint8_t* packet);
+
+    /**
+    ****************************************************************************
+    * @brief    Processes sections of PAT, PMT and SDT
+    * @param    [in] section    Complete section
+    * @param    [in] size       Size of the section
+    * @param    [in] pid        PID of the section
+    * @return   void
+    ****************************************************************************
+    */
+    void process_section(const uint8_t* section, size_t size, uint16_t pid);
+
+    /**
+    ****************************************************************************
+    * @brief    Collects PES of the stream and parses its headers
+    * @param    [in] packet TS packet
+    * @param    [in] stream Stream of the packet
+    * @return   void
+    ****************************************************************************
+    */
+    void process_pes(const uint8_t* packet, probe_stream& stream);
+
+    /**
+    ****************************************************************************
+    * @brief    Parses headers of collected PES payload
+    * @param    [in] stream Stream
+    * @return   void
+    ****************************************************************************
+    */
+    void finish_pes(probe_stream& stream);
+
+    /**
+    ****************************************************************************
+    * @brief    Checks whether everything is known
+    * @return   true if reading can be stopped
+    ****************************************************************************
+    */
+    bool complete(void);
+
+private:    // Blocked implementations
+    TSProbe();
+    TSProbe(const TSProbe& r);
+    TSProbe& operator= (const TSProbe&);
+
+private:
+    std::string     m_filename;         ///< Input file name
+    uint64_t        m_limit;            ///< Maximal number of bytes to read
+    uint64_t        m_bytes;            ///< Bytes read
+    bool            m_complete;         ///< Everything was found
+
+    bool            m_has_pat;          ///< PAT is parsed
+    uint16_t        m_stream_id;        ///< Transport stream ID
+    std::vector<probe_program>  m_programs; ///< Programs of PAT
+    std::map<uint16_t, probe_stream> m_streams; ///< Streams by PID
+    std::map<uint16_t, SectionAssembler> m_sections; ///< PSI/SI assemblers
+
+    std::vector<bool> m_sdt_sections;   ///< Sections of SDT actual received
+    bool            m_has_sdt;          ///< All sections of SDT are received
+    uint64_t        m_sdt_wait;         ///< Position since SDT is waited
+};
+
+#endif  /* !_TS_PROBE_H_ */
@@ -8,11 +8,26 @@
 */
 
 #include "ts_processor.h"
+#include "ts_fields.h"
+#include "ts_parse.h"
+#include "ts_descriptors.h"
+#include "stream_select.h"
+#include "scte35.h"
+#include "dvb_si.h"
+#include "ts_analyzer.h"
+#include "affinity.h"
+#include "ts_passthrough.h"
+#include "es_writer.h"
+#include "ts_checkpoint.h"
+#include "ts_switch.h"
+#include "pcap_input.h"
+#include "ts_playout.h"
+#include "ts_segments.h"
+#include "ts_section.h"
 
 #include <errno.h>
 #include <string.h>
 #include <unistd.h>
-#include <endian.h>
 #include <stdlib.h>
 
 /*
@@ -26,14 +41,46 @@ TSProcessor::TSProcessor(const char* const input, const char* const video,
     , m_video_filename(video)
     , m_audio_filename(audio)
     , m_input_file(NULL)
-    , m_video_file(NULL)
-    , m_audio_file(NULL)
+    , m_outputs(OUTPUT_AUDIO + 1, static_cast<ESWriter*>(NULL))
+    , m_preallocated(0)
+    , m_lazy(false)
     , m_input_filesize(0)
+    , m_buffer(NULL)
+    , m_numa_node(NUMA_NODE_ANY)
+    , m_state(STATE_PAT)
+    , m_data(NULL)
+    , m_data_size(0)
+    , m_data_pos(0)
+    , m_carry_size(0)
+    , m_packets(0)
+    , m_input_packets(0)
+    , m_ts_output(NULL)
+    , m_playout(NULL)
+    , m_cues(NULL)
+    , m_si(NULL)
+    , m_analysis(false)
+    , m_analyzer(NULL)
+    , m_checkpoint_interval(CHECKPOINT_INTERVAL)
+    , m_checkpoint_pos(0)
+    , m_input_pos(0)
+    , m_resume(false)
+    , m_resume_point(NULL)
+    , m_switch(NULL)
+    , m_pcap(false)
+    , m_capture(NULL)
+    , m_playlist(false)
+    , m_segments(NULL)
     , m_pmt_pid(0x1fff)
+    , m_pmt_sections(new SectionAssembler())
+    , m_checked(new SectionCache())
+    , m_pmt_version(-1)
     , m_video_pid(0x1fff)
     , m_audio_pid(0x1fff)
 {
-
+    memset(m_route, OUTPUT_NONE, sizeof(m_route));
+    memset(m_subscribed, SUB_NONE, sizeof(m_subscribed));
+    m_pcap_filter.address = 0;
+    m_pcap_filter.port    = 0;
 }
 
 /*
@@ -49,17 +96,47 @@ TSProcessor::~TSProcessor()
         m_input_file = NULL;
     }
 
-    if (NULL != m_video_file)
+    for (size_t i = 0; i < m_outputs.size(); ++i)
     {
-        fclose(m_video_file);
-        m_video_file = NULL;
+        delete m_outputs[i];
+        m_outputs[i] = NULL;
     }
 
-    if (NULL != m_audio_file)
-    {
-        fclose(m_audio_file);
-        m_audio_file = NULL;
-    }
+    delete m_ts_output;
+    m_ts_output = NULL;
+
+    delete m_playout;
+    m_playout = NULL;
+
+    delete m_cues;
+    m_cues = NULL;
+
+    delete m_si;
+    m_si = NULL;
+
+    delete m_analyzer;
+    m_analyzer = NULL;
+
+    delete m_resume_point;
+    m_resume_point = NULL;
+
+    delete m_switch;
+    m_switch = NULL;
+
+    delete m_capture;
+    m_capture = NULL;
+
+    delete m_segments;
+    m_segments = NULL;
+
+    delete m_pmt_sections;
+    m_pmt_sections = NULL;
+
+    delete m_checked;
+    m_checked = NULL;
+
+    numa_free(m_buffer, TS_READ_PACKETS * TS_PACKET_SIZE);
+    m_buffer = NULL;
 }
 
 /*
@@ -71,6 +148,288 @@ STATUS TSProcessor::init()
 {
     STATUS result = STATUS_FAIL;
 
+    do
+    {
+        /**
+        ************************************************************************
+        * @note     Input file is optional. Without it the object is driven by
+        *           process() or feed()/next_event() calls
+        ************************************************************************
+        */
+        if (!m_input_filename.empty())
+        {
+            if (STATUS_OK != open_input())
+            {
+                break;
+            }
+        }
+
+        if (!m_backup_filename.empty() && NULL != m_input_file)
+        {
+            m_switch = new TSSwitcher(m_input_file, m_input_filename.c_str(),
+                m_backup_filename.c_str());
+            if (STATUS_OK != m_switch->init())
+            {
+                break;
+            }
+        }
+
+        if (m_pcap && NULL != m_input_file)
+        {
+            m_capture = new PcapInput(fileno(m_input_file),
+                m_input_filename.c_str(), m_pcap_filter);
+            if (STATUS_OK != m_capture->init())
+            {
+                break;
+            }
+        }
+
+        if (m_playlist && NULL != m_input_file)
+        {
+            m_segments = new TSSegments(m_input_file,
+                m_input_filename.c_str());
+            if (STATUS_OK != m_segments->init())
+            {
+                break;
+            }
+            m_input_filesize = m_segments->size();
+        }
+
+        if (m_resume)
+        {
+            m_resume_point = new ts_checkpoint();
+            if (STATUS_OK != load_checkpoint(m_checkpoint_filename.c_str(),
+                *m_resume_point))
+            {
+                break;
+            }
+        }
+
+        // Video and audio files are optional when selection rules are given
+        if (!m_video_filename.empty())
+        {
+            m_outputs[OUTPUT_VIDEO] = open_output(m_video_filename);
+            if (NULL == m_outputs[OUTPUT_VIDEO])
+            {
+                break;
+            }
+        }
+
+        if (!m_audio_filename.empty())
+        {
+            m_outputs[OUTPUT_AUDIO] = open_output(m_audio_filename);
+            if (NULL == m_outputs[OUTPUT_AUDIO])
+            {
+                break;
+            }
+        }
+
+        if (!m_ts_output_filename.empty())
+        {
+            m_ts_output = new TSPassthrough(m_ts_output_filename.c_str());
+            // Packets of backup, capture or segments aren't at their input
+            // offsets
+            if (STATUS_OK != m_ts_output->init((NULL != m_input_file &&
+                NULL == m_switch && NULL == m_capture &&
+                NULL == m_segments) ?
+                fileno(m_input_file) : -1))
+            {
+                break;
+            }
+        }
+
+        if (!m_udp_destination.empty())
+        {
+            m_playout = new TSPlayout(m_udp_destination.c_str());
+            if (STATUS_OK != m_playout->init())
+            {
+                break;
+            }
+        }
+
+        if (!m_cue_filename.empty())
+        {
+            m_cues = new CueWriter(m_cue_filename.c_str());
+            if (STATUS_OK != m_cues->init())
+            {
+                break;
+            }
+        }
+
+        if (!m_si_filename.empty())
+        {
+            m_si = new SITables(m_si_filename.c_str());
+            if (STATUS_OK != m_si->init())
+            {
+                break;
+            }
+        }
+
+        if (m_analysis)
+        {
+            m_analyzer = new TSAnalyzer();
+        }
+
+        fprintf(stdout, "TSProcessor initialized:\n"
+                        "\tInput file: %s (size: %lu bytes)\n"
+                        "\tVideo file: %s\n"
+                        "\tAudio file: %s\n",
+                        m_input_filename.c_str(), m_input_filesize,
+                        m_video_filename.c_str(), m_audio_filename.c_str());
+        for (size_t i = 0; i < m_rules.size(); ++i)
+        {
+            fprintf(stdout, "\tSelect: %s\n", m_rules[i].text.c_str());
+        }
+
+        result = m_resume ? restore_state() : STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProcessor::set_numa_node(int node)
+{
+    m_numa_node = node;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProcessor::set_ts_output(const char* const filename)
+{
+    m_ts_output_filename = filename;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProcessor::set_udp_output(const char* const destination)
+{
+    m_udp_destination = destination;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProcessor::add_select(const struct select_rule& rule)
+{
+    m_rules.push_back(rule);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProcessor::set_cue_output(const char* const filename)
+{
+    m_cue_filename = filename;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProcessor::set_si_output(const char* const filename)
+{
+    m_si_filename = filename;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProcessor::enable_analysis()
+{
+    m_analysis = true;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProcessor::set_checkpoint(const char* const filename,
+    uint64_t interval)
+{
+    m_checkpoint_filename = filename;
+    m_checkpoint_interval = interval;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProcessor::enable_resume()
+{
+    m_resume = true;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProcessor::set_backup(const char* const filename)
+{
+    m_backup_filename = filename;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProcessor::set_pcap(const struct pcap_filter& filter)
+{
+    m_pcap        = true;
+    m_pcap_filter = filter;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProcessor::set_playlist()
+{
+    m_playlist = true;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+const TSAnalyzer* TSProcessor::analyzer() const
+{
+    return m_analyzer;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSProcessor::open_input()
+{
+    STATUS result = STATUS_FAIL;
+
     do
     {
         m_input_file = fopen(m_input_filename.c_str(), "rb");
@@ -81,28 +440,17 @@ STATUS TSProcessor::init()
             break;
         }
 
-        m_video_file = fopen(m_video_filename.c_str(), "wb");
-        if (NULL == m_video_file)
+        m_buffer = static_cast<uint8_t*>(numa_alloc(TS_READ_PACKETS *
+            TS_PACKET_SIZE, m_numa_node));
+        if (NULL == m_buffer)
         {
-            fprintf(stderr,
-                "Can't open/create video stream file (%s). Error: %s\n",
-                m_video_filename.c_str(), strerror(errno));
+            fprintf(stderr, "Can't allocate input buffer\n");
             break;
         }
 
-        m_audio_file = fopen(m_audio_filename.c_str(), "wb");
-        if (NULL == m_audio_file)
-        {
-            fprintf(stderr,
-                "Can't open/create audio stream file (%s). Error: %s\n",
-                m_video_filename.c_str(), strerror(errno));
-            break;
-        }
-        
         int r = fseek(m_input_file, 0, SEEK_END);
         if (0 != r)
         {
-            result = STATUS_FAIL;
             fprintf(stderr, "Can't seek to the end of file\n");
             break;
         }
@@ -115,17 +463,467 @@ STATUS TSProcessor::init()
         }
         m_input_filesize = size;
         rewind(m_input_file);
-        fprintf(stdout, "TSProcessor initialized:\n"
-                        "\tInput file: %s (size: %lu bytes)\n"
-                        "\tVideo file: %s\n"
-                        "\tAudio file: %s\n",
-                        m_input_filename.c_str(), m_input_filesize,
-                        m_video_filename.c_str(), m_audio_filename.c_str());
+
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSProcessor::process_pat(const struct ts_packet& packet)
+{
+    STATUS result = STATUS_AGAIN;
+
+    do
+    {
+        // Skip packet if it's not 0 (which has PAT) or doesn't start section
+        if (0 != ts_pid::get(packet.header) || !ts_pusi::get(packet.header))
+        {
+            break;
+        }
+
+        /**
+        ************************************************************************
+        * @note     Broken section (or section which doesn't fit into single
+        *           packet) is skipped, the search goes on with next PAT
+        ************************************************************************
+        */
+        const uint8_t* data = NULL;
+        const uint8_t* section = NULL;
+        size_t size = 0;
+        struct psi_pat pat;
+        if (STATUS_OK != parse_payload(packet.header, data, size) ||
+            STATUS_OK != parse_section(data, size, section, size) ||
+            !check_section(0, section, size) ||
+            STATUS_OK != parse_pat(section, size, pat))
+        {
+            break;
+        }
+
+        /**
+        ************************************************************************
+        * @warning  The STRONG assumption of this implementation is that file
+        *           on input is SPTS (Single Program Transport Stream). Program
+        *           number 0 refers to network PID and isn't counted
+        ************************************************************************
+        */
+        const struct psi_program* prog = NULL;
+        int prog_num = 0;
+        for (size_t i = 0; i < pat.programs.size(); ++i)
+        {
+            if (0 != pat.programs[i].number)
+            {
+                prog = &pat.programs[i];
+                prog_num += 1;
+            }
+        }
+
+        if (prog_num != 1)
+        {
+            result = STATUS_FAIL;
+            fprintf(stderr, "Number of programs different than 1 (%d)\n",
+                prog_num);
+            fprintf(stderr, "MPTS (Multiple Program Transport Stream) is not "
+                "supported by this implementation\n");
+            break;
+        }
+
+        m_pmt_pid = prog->pid;
         result = STATUS_OK;
 
-    } while(0);
+        fprintf(stdout, "PAT found:\n");
+        fprintf(stdout, "\tMPEG-TS Stream ID: %d  (0x%x)\n", pat.stream_id,
+            pat.stream_id);
+        fprintf(stdout, "\tProgram ID: %d (0x%x)\n", prog->number,
+            prog->number);
+        fprintf(stdout, "\tPMT PID: %d (0x%x)\n", m_pmt_pid, m_pmt_pid);
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSProcessor::process_pmt(const struct ts_packet& packet)
+{
+    STATUS result = STATUS_AGAIN;
+
+    do
+    {
+        // Skip packet if it's not PMT
+        if (m_pmt_pid != ts_pid::get(packet.header))
+        {
+            break;
+        }
+
+        /**
+        ************************************************************************
+        * @note     PMT may span several packets. Section which lost its
+        *           packets is dropped by assembler, the search goes on with
+        *           next PMT
+        ************************************************************************
+        */
+        m_pmt_sections->push(packet.header);
+
+        const uint8_t* section = NULL;
+        size_t size = 0;
+        while (STATUS_FAIL != result &&
+            STATUS_OK == m_pmt_sections->next_section(section, size))
+        {
+            STATUS r = process_pmt_section(section, size);
+            result = (STATUS_AGAIN == r) ? result : r;
+        }
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSProcessor::process_pmt_section(const uint8_t* section, size_t size)
+{
+    STATUS result = STATUS_AGAIN;
+
+    do
+    {
+        // Corrupted section must not replace routes of the current one.
+        // PMT is repeated often, only a new version is parsed
+        if (!check_section(m_pmt_pid, section, size) ||
+            !psi_current_next::get(section) ||
+            m_pmt_version == (int)psi_version::get(section))
+        {
+            break;
+        }
+
+        struct psi_pmt pmt;
+        if (STATUS_OK != parse_pmt(section, size, pmt))
+        {
+            break;
+        }
+
+        // Streams removed by the new version are neither kept nor routed
+        m_route[m_video_pid] = OUTPUT_NONE;
+        m_route[m_audio_pid] = OUTPUT_NONE;
+        m_video_pid = 0x1fff;
+        m_audio_pid = 0x1fff;
+
+        m_streams.resize(pmt.streams.size());
+        for (size_t i = 0; i < pmt.streams.size(); ++i)
+        {
+            // Broken descriptor loop keeps metadata parsed before it
+            parse_stream_info(pmt.streams[i], m_streams[i]);
+            save_pid(m_streams[i]);
+        }
+        m_pmt_version = pmt.version;
+        m_pmt_section.assign(section, section + size);
+
+        result = STATUS_OK;
+
+        fprintf(stdout, "PMT found:\n");
+        fprintf(stdout, "\tProgram number: %d (0x%x)\n", pmt.program,
+            pmt.program);
+        fprintf(stdout, "\tVersion: %d\n", pmt.version);
+        fprintf(stdout, "\tVideo PID: %d (0x%x)\n", m_video_pid, m_video_pid);
+        fprintf(stdout, "\tAudio PID: %d (0x%x)\n", m_audio_pid, m_audio_pid);
+        fprintf(stdout, "\tPCR PID:   %d (0x%x)\n", pmt.pcr_pid, pmt.pcr_pid);
+
+        for (size_t i = 0; i < m_streams.size(); ++i)
+        {
+            const struct ts_stream_info& info = m_streams[i];
+            fprintf(stdout, "\tStream PID: %d (0x%x) type 0x%02x %s %s",
+                info.pid, info.pid, info.type, kind_name(info.kind),
+                codec_name(info.codec));
+            if ('\0' != info.language[0])
+            {
+                fprintf(stdout, " [%s]", info.language);
+            }
+            fprintf(stdout, "\n");
+        }
+
+        result = route_streams();
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+bool TSProcessor::check_section(uint16_t pid, const uint8_t* section,
+    size_t size)
+{
+    bool result = m_checked->find(pid, section, size);
+
+    if (!result && size >= PSI_HEADER_SIZE + 4 &&
+        0 == psi_crc32(section, size))
+    {
+        m_checked->insert(pid, section, size);
+        result = true;
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSProcessor::demux()
+{
+    STATUS result = STATUS_FAIL;
+
+    do
+    {
+        size_t read_bytes = 0;
+        const uint8_t* data = m_buffer;
+        if (NULL != m_capture)
+        {
+            // Datagrams are demultiplexed in place, inside of the mapping
+            if (STATUS_OK != m_capture->next(data, read_bytes))
+            {
+                result = STATUS_FAIL;
+                break;
+            }
+        }
+        else if (NULL != m_segments)
+        {
+            if (STATUS_OK != m_segments->read(m_buffer,
+                TS_READ_PACKETS * TS_PACKET_SIZE, read_bytes))
+            {
+                result = STATUS_FAIL;
+                break;
+            }
+        }
+        else if (NULL != m_switch)
+        {
+            if (STATUS_OK != m_switch->read(m_buffer,
+                TS_READ_PACKETS * TS_PACKET_SIZE, read_bytes))
+            {
+                result = STATUS_FAIL;
+                fprintf(stderr, "Can't read from %s and %s files!\n",
+                    m_input_filename.c_str(), m_backup_filename.c_str());
+                break;
+            }
+        }
+        else
+        {
+            read_bytes = fread(m_buffer, 1, TS_READ_PACKETS * TS_PACKET_SIZE,
+                m_input_file);
+        }
+
+        if (0 == read_bytes)
+        {
+            if (NULL == m_switch && ferror(m_input_file))
+            {
+                result = STATUS_FAIL;
+                fprintf(stderr, "Can't read from %s file! Error: %s\n",
+                    m_input_filename.c_str(), strerror(errno));
+                break;
+            }
+
+            result = finish();
+            break;
+        }
+
+        result = process(data, read_bytes);
+        m_input_pos += read_bytes;
+
+        // Checkpoint is taken only at packet boundary
+        if (STATUS_OK == result && !m_checkpoint_filename.empty() &&
+            0 == m_carry_size &&
+            m_input_pos - m_checkpoint_pos >= m_checkpoint_interval)
+        {
+            result = save_state();
+        }
+
+    } while(STATUS_OK == result);
+
+    // Finished job doesn't need its checkpoint anymore
+    if (STATUS_OK == result && !m_checkpoint_filename.empty())
+    {
+        unlink(m_checkpoint_filename.c_str());
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+ESWriter* TSProcessor::open_output(const std::string& filename)
+{
+    ESWriter* output = new ESWriter(filename.c_str());
+
+    for (size_t i = 0; NULL != m_resume_point &&
+        i < m_resume_point->outputs.size(); ++i)
+    {
+        const struct checkpoint_output& out = m_resume_point->outputs[i];
+        if (filename == out.filename)
+        {
+            output->resume_at(out.size, out.index_size);
+            break;
+        }
+    }
+
+    if (STATUS_OK != output->init())
+    {
+        delete output;
+        output = NULL;
+    }
+
+    return output;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSProcessor::save_state()
+{
+    STATUS result = STATUS_OK;
+
+    struct ts_checkpoint cp;
+    cp.input   = m_input_filename;
+    cp.offset  = m_input_pos;
+    cp.packets = m_packets;
+    cp.state   = m_state;
+    cp.pmt_pid = m_pmt_pid;
+    cp.pmt     = m_pmt_section;
+
+    // Outputs are synced first, so checkpoint never refers to lost data
+    for (size_t i = OUTPUT_VIDEO; STATUS_OK == result &&
+        i < m_outputs.size(); ++i)
+    {
+        struct checkpoint_output out;
+        if (NULL != m_outputs[i])
+        {
+            out.filename = m_outputs[i]->filename();
+            result = m_outputs[i]->checkpoint(out.size, out.index_size);
+            cp.outputs.push_back(out);
+        }
+    }
+
+    if (STATUS_OK == result)
+    {
+        result = save_checkpoint(m_checkpoint_filename.c_str(), cp);
+        m_checkpoint_pos = m_input_pos;
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSProcessor::restore_state()
+{
+    STATUS result = STATUS_FAIL;
+    const struct ts_checkpoint& cp = *m_resume_point;
+
+    do
+    {
+        if (cp.input != m_input_filename || NULL == m_input_file)
+        {
+            fprintf(stderr, "Checkpoint (%s) belongs to other input (%s)\n",
+                m_checkpoint_filename.c_str(), cp.input.c_str());
+            break;
+        }
+
+        if (cp.offset > m_input_filesize || cp.state > STATE_ES ||
+            (STATE_ES == cp.state && cp.pmt.empty()))
+        {
+            fprintf(stderr, "Checkpoint (%s) doesn't match input file\n",
+                m_checkpoint_filename.c_str());
+            break;
+        }
+
+        if (0 != fseeko(m_input_file, cp.offset, SEEK_SET))
+        {
+            fprintf(stderr, "Can't seek to %llu of %s. Error: %s\n",
+                (unsigned long long)cp.offset, m_input_filename.c_str(),
+                strerror(errno));
+            break;
+        }
+
+        fprintf(stdout, "Resumed from checkpoint:\n"
+                        "\tCheckpoint: %s\n"
+                        "\tOffset: %llu (packet %llu)\n",
+                        m_checkpoint_filename.c_str(),
+                        (unsigned long long)cp.offset,
+                        (unsigned long long)cp.packets);
+
+        m_input_pos      = cp.offset;
+        m_checkpoint_pos = cp.offset;
+        m_packets        = cp.packets;
+        m_input_packets  = cp.offset / TS_PACKET_SIZE;
+        m_pmt_pid        = cp.pmt_pid;
+        m_state          = static_cast<STATE>(cp.state);
+
+        // Streams are routed again by the PMT of the checkpoint
+        if (!cp.pmt.empty() &&
+            STATUS_OK != process_pmt_section(&cp.pmt[0], cp.pmt.size()))
+        {
+            fprintf(stderr, "Checkpoint (%s) has broken PMT\n",
+                m_checkpoint_filename.c_str());
+            break;
+        }
+
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSProcessor::process(const uint8_t* data, size_t size)
+{
+    STATUS result = feed(data, size);
+
+    while (STATUS_OK == result)
+    {
+        struct ts_event event;
+        result = next_event(event);
+        if (STATUS_OK == result && TS_EVENT_PES == event.type)
+        {
+            result = write_es(event);
+        }
+        else if (STATUS_OK == result && TS_EVENT_PMT == event.type &&
+            NULL != m_input_file && NULL == m_capture &&
+            NULL == m_segments && m_preallocated < m_outputs.size())
+        {
+            preallocate_es();
+        }
+    }
 
-    return result;
+    return (STATUS_AGAIN == result) ? STATUS_OK : result;
 }
 
 /*
@@ -133,103 +931,91 @@ STATUS TSProcessor::init()
 *
 ********************************************************************************
 */
-STATUS TSProcessor::process_pat()
+STATUS TSProcessor::finish()
 {
     STATUS result = STATUS_FAIL;
 
-    uint16_t stream_id  = 0;
-    uint16_t prog_id    = 0;
-
     do
     {
-        struct ts_packet packet;
-        result = read_packet(packet);
-        if (0 != result)
+        if (NULL != m_ts_output && STATUS_OK != m_ts_output->flush())
         {
             break;
         }
 
-        int pid  = (packet.header & PID_MASK) >> 8;
-        int pusi = (packet.header & PUSI_MASK);
+        if (NULL != m_playout && STATUS_OK != m_playout->flush())
+        {
+            break;
+        }
 
-        // Skip packet if it's not 0 (which has PAT)
-        if (0 != pid)
+        STATUS closed = STATUS_OK;
+        for (size_t i = 0; i < m_outputs.size(); ++i)
         {
-            continue;
+            if (NULL != m_outputs[i] && STATUS_OK != m_outputs[i]->close())
+            {
+                closed = STATUS_FAIL;
+            }
         }
 
-        size_t pi = (pusi) ? 1 : 0;
+        if (NULL != m_cues && STATUS_OK != m_cues->close())
+        {
+            closed = STATUS_FAIL;
+        }
 
-        // Skip table ID
-        pi += 1;
+        if (NULL != m_si && STATUS_OK != m_si->close())
+        {
+            closed = STATUS_FAIL;
+        }
 
-        /**
-        ************************************************************************
-        * @note     Section size is actually 12 bites you can recognize it as a
-        *           mask, but because in this implementation syntax_indicator
-        *           and reserved bits will be ignored I decided to read 2 bytes
-        *           and mask it to get proper value
-        * @note     Next 16 bits is TS stream ID
-        ************************************************************************
-        */
-        uint16_t sec_len = htobe16(*(uint16_t*)&packet.payload[pi]) & 0xfff;
-        pi += 2;
+        if (NULL != m_analyzer)
+        {
+            m_analyzer->finish();
+            m_analyzer->report(stdout);
+        }
 
-        stream_id = htobe16(*(uint16_t*)&packet.payload[pi]);
-        pi += 2;
+        if (NULL != m_switch)
+        {
+            m_switch->report(stdout);
+        }
 
-        /**
-        ************************************************************************
-        * @note     In bits: 2 - reserved, 5 - version, 1 - next indicator,
-        *           8 - section number, 8 - last section number 
-        * @note     This bits currently ignored, so position was advanced
-        ************************************************************************
-        */
-        pi += 3;
+        if (NULL != m_capture)
+        {
+            m_capture->report(stdout);
+        }
 
-        /**
-        ************************************************************************
-        * @note     Calculating number of programs we need to read:
-        *           first 4 is Packet CRC bits
-        *           5 is table ID, sec_len (including unused bits) and stream_id
-        *           last 4 is Program size
-        *           prog_num = ((sec_len) - pat_header - CRC) / prog_size
-        ************************************************************************
-        */
-        int prog_num = (sec_len - 5 - 4) / 4;
+        if (NULL != m_segments)
+        {
+            m_segments->report(stdout);
+        }
+
+        if (STATUS_OK != closed)
+        {
+            break;
+        }
+
+        if (0 != m_carry_size)
+        {
+            fprintf(stderr, "Can't read TS packet from %s! "
+                "Last packet is truncated\n", m_input_filename.c_str());
+            break;
+        }
 
         /**
         ************************************************************************
-        * @warning  The STRONG assumption of this implementation is that file
-        *           on input is SPTS (Single Program Transport Stream)
+        * @note     End of stream is reached. Processing is successful only in
+        *           case if both PAT and PMT were found
         ************************************************************************
         */
-        if (prog_num != 1)
+        if (STATE_ES != m_state)
         {
-            result = STATUS_FAIL;
-            fprintf(stderr, "Number of programs different than 1 (%d)\n",
-                prog_num);
-            fprintf(stderr, "MPTS (Multiple Program Transport Stream) is not "
-                "supported by this implementation\n");
+            fprintf(stderr, "%s wasn't found in %s!\n",
+                (STATE_PAT == m_state) ? "PAT" : "PMT",
+                m_input_filename.c_str());
             break;
         }
 
-        prog_id = htobe16(*(uint16_t*)&packet.payload[pi]);
-        pi += 2;
-
-        m_pmt_pid = htobe16(*(uint16_t*)&packet.payload[pi]) & 0x1fff;
-        pi += 2;
-
         result = STATUS_OK;
 
-        fprintf(stdout, "PAT found:\n");
-        fprintf(stdout, "\tMPEG-TS Stream ID: %d  (0x%x)\n", stream_id,
-            stream_id);
-        fprintf(stdout, "\tProgram ID: %d (0x%x)\n", prog_id, prog_id);
-        fprintf(stdout, "\tPMT PID: %d (0x%x)\n", m_pmt_pid, m_pmt_pid);
-        break;
-
-    } while((size_t)ftell(m_input_file) < m_input_filesize);
+    } while(0);
 
     return result;
 }
@@ -239,105 +1025,118 @@ STATUS TSProcessor::process_pat()
 *
 ********************************************************************************
 */
-STATUS TSProcessor::process_pmt()
+STATUS TSProcessor::feed(const uint8_t* data, size_t size)
 {
     STATUS result = STATUS_FAIL;
 
     do
     {
-        struct ts_packet packet;
-        result = read_packet(packet);
-        if (0 != result)
+        if (m_data_pos != m_data_size)
         {
+            fprintf(stderr, "Previous chunk wasn't processed completely\n");
             break;
         }
 
-        int pid  = (packet.header & PID_MASK) >> 8;
-        int pusi = (packet.header & PUSI_MASK);
-
-        // Skip packet if it's not PMT
-        if (pid != m_pmt_pid)
-        {
-            continue;
-        }
-
-        size_t pi = (pusi) ? 1 : 0;
-
-        pi += 1; // Skipped table_id
-
-        /**
-        ************************************************************************
-        * @note     Section size is actually 12 bites you can recognize it as a
-        *           mask, but because in this implementation syntax_indicator
-        *           and reserved bits will be ignored I decided to read 2 bytes
-        *           and mask it to get proper value
-        * @note     Next 16 bits is TS stream ID
-        ************************************************************************
-        */
-        uint16_t sec_len = htobe16(*(uint16_t*)&packet.payload[pi]) & 0xfff;
-        pi += 2;
+        m_data      = data;
+        m_data_size = size;
+        m_data_pos  = 0;
 
-        int prog_num = htobe16(*(uint16_t*)&packet.payload[pi]);
-        pi += 2;
+        result = STATUS_OK;
 
-        /**
-        ************************************************************************
-        * @note     Skip 3 bytes which corresponds to fields in bits:
-        *           2 - reserved, 5 version_number, 1 - next_inducator,
-        *           8 - section_number, 8 - last section number.
-        ************************************************************************
-        */
-        pi += 3;
+    } while(0);
 
-        uint16_t pcr_pid = htobe16(*(uint16_t*)&packet.payload[pi]) & 0x1fff;
-        pi += 2;
+    return result;
+}
 
-        uint16_t pinfo_size = htobe16(*(uint16_t*)&packet.payload[pi]) & 0xfff;
-        pi += 2;
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSProcessor::next_event(struct ts_event& event)
+{
+    STATUS result = STATUS_AGAIN;
 
-        // All bytes read + crc
-        int left = sec_len - 9 - pinfo_size - 4;
+    while (STATUS_AGAIN == result)
+    {
+        const uint8_t* raw = NULL;
+        size_t left = m_data_size - m_data_pos;
 
-        while(left > 0)
+        if (0 != m_carry_size)
         {
             /**
             ********************************************************************
-            * @note  Stream type (Audir, Video, etc.)
-            ********************************************************************
-            */
-            int st = packet.payload[pi];
-            pi += 1;
-            left -= 1;
-            
-            /**
-            ********************************************************************
-            * @note  Elementary stream PID of type st
+            * @note     Packet was split between chunks. It has to be completed
+            *           from the current chunk before processing
             ********************************************************************
             */
-            uint16_t el = htobe16(*(uint16_t*)&packet.payload[pi]) & 0x1fff;
-            pi += 2;
-            left -= 2;
+            size_t need = TS_PACKET_SIZE - m_carry_size;
+            size_t take = (left < need) ? left : need;
+
+            memcpy(&m_carry[m_carry_size], &m_data[m_data_pos], take);
+            m_carry_size += take;
+            m_data_pos += take;
+
+            if (TS_PACKET_SIZE != m_carry_size)
+            {
+                break;
+            }
+
+            m_carry_size = 0;
+            raw = m_carry;
+        }
+        else if (left < TS_PACKET_SIZE)
+        {
+            if (0 != left)
+            {
+                memcpy(m_carry, &m_data[m_data_pos], left);
+                m_carry_size = left;
+                m_data_pos += left;
+            }
+            break;
+        }
+        else
+        {
+            raw = &m_data[m_data_pos];
+            m_data_pos += TS_PACKET_SIZE;
+        }
 
-            uint16_t es_ilen = htobe16(*(uint16_t*)&packet.payload[pi]) & 0xfff;
-            pi += 2;
-            left -= 2;
+        struct ts_packet packet;
+        packet.header = raw;
+        packet.payload = &raw[TS_PACKET_HEADER];
 
-            pi += es_ilen;
-            left -= es_ilen;
-            save_pid(el, st);
+        if (NULL != m_analyzer)
+        {
+            m_analyzer->push(raw);
         }
 
-        result = STATUS_OK;
+        if (TS_SYNC_BYTE != ts_sync_byte::get(packet.header))
+        {
+            // Analyzer has counted the packet, processing goes on
+            if (NULL != m_analyzer)
+            {
+                m_input_packets += 1;
+                continue;
+            }
 
-        fprintf(stdout, "PMT found:\n");
-        fprintf(stdout, "\tProgram number: %d (0x%x)\n", prog_num, prog_num);
-        fprintf(stdout, "\tVideo PID: %d (0x%x)\n", m_video_pid, m_video_pid);
-        fprintf(stdout, "\tAudio PID: %d (0x%x)\n", m_audio_pid, m_audio_pid);
-        fprintf(stdout, "\tPCR PID:   %d (0x%x)\n", pcr_pid, pcr_pid);
+            result = STATUS_FAIL;
+            fprintf(stderr, "Sync byte of TS packet has wrong value\n");
+            break;
+        }
 
-        break;
+        if (NULL != m_ts_output || NULL != m_playout)
+        {
+            result = passthrough(packet, raw);
+            if (STATUS_OK != result)
+            {
+                break;
+            }
+        }
 
-    } while((size_t)ftell(m_input_file) < m_input_filesize);
+        m_input_packets += 1;
+        m_packets += 1;
+        result = process_packet(packet, event);
+    }
 
     return result;
 }
@@ -347,51 +1146,193 @@ STATUS TSProcessor::process_pmt()
 *
 ********************************************************************************
 */
-STATUS TSProcessor::demux()
+const std::vector<struct ts_stream_info>& TSProcessor::streams() const
+{
+    return m_streams;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProcessor::enable_lazy()
+{
+    m_lazy = true;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProcessor::subscribe(uint16_t pid)
+{
+    if (pid < TS_PID_COUNT && SUB_NONE == m_subscribed[pid])
+    {
+        m_subscribed[pid] = SUB_PENDING;
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProcessor::unsubscribe(uint16_t pid)
+{
+    if (pid < TS_PID_COUNT)
+    {
+        m_subscribed[pid] = SUB_NONE;
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSProcessor::process_packet(const struct ts_packet& packet,
+    struct ts_event& event)
 {
     STATUS result = STATUS_FAIL;
 
-    do
+    switch (m_state)
     {
         /**
         ************************************************************************
         * @note     At this moment all packets will be ignored except PID 0.
-        *           After this function is finished execution PMT PID is known
+        *           After PAT is found PMT PID is known
         ************************************************************************
         */
-        result = process_pat();
-        if (STATUS_OK != result)
+        case STATE_PAT:
         {
+            result = process_pat(packet);
+            if (STATUS_OK == result)
+            {
+                m_state = STATE_PMT;
+                event.type       = TS_EVENT_PAT;
+                event.pid        = 0;
+                event.unit_start = true;
+                event.data       = NULL;
+                event.size       = 0;
+                event.has_pts    = false;
+                event.pts        = 0;
+            }
             break;
         }
 
         /**
         ************************************************************************
         * @note     At this moment all packets will be ignored expept PID
-        *           equals to PMT (found in PAT). This function has to
-        *           find Video PID and audio PID and initialize corresponding
-        *           class members
+        *           equals to PMT (found in PAT). PMT has to provide video PID
+        *           and audio PID
         ************************************************************************
         */
-        result = process_pmt();
-        if (STATUS_OK != result)
+        case STATE_PMT:
         {
+            result = process_pmt(packet);
+            if (STATUS_OK == result)
+            {
+                m_state = STATE_ES;
+                event.type       = TS_EVENT_PMT;
+                event.pid        = m_pmt_pid;
+                event.unit_start = true;
+                event.data       = NULL;
+                event.size       = 0;
+                event.has_pts    = false;
+                event.pts        = 0;
+            }
             break;
         }
 
         /**
         ************************************************************************
         * @note     At this moment all packets will be ignored except video and
-        *           audio PID
+        *           audio PID. PMT is watched for a new version
         ************************************************************************
         */
-        result = process_file();
-        if (STATUS_OK != result)
+        case STATE_ES:
         {
+            int pid = ts_pid::get(packet.header);
+            if (NULL != m_cues && m_cues->accepts(pid) &&
+                STATUS_OK != m_cues->push(packet.header))
+            {
+                result = STATUS_FAIL;
+                break;
+            }
+
+            if (NULL != m_si && m_si->accepts(pid) &&
+                STATUS_OK != m_si->push(packet.header))
+            {
+                result = STATUS_FAIL;
+                break;
+            }
+
+            result = process_es(packet, event);
+
+            // Cues and SI time are aligned to video PTS (audio PTS if there
+            // is no video)
+            if (STATUS_OK == result && event.has_pts &&
+                (pid == m_video_pid ||
+                (0x1fff == m_video_pid && pid == m_audio_pid)))
+            {
+                if (NULL != m_cues)
+                {
+                    m_cues->set_clock(event.pts);
+                }
+
+                if (NULL != m_si)
+                {
+                    m_si->set_clock(event.pts);
+                }
+            }
+
+            if (STATUS_AGAIN == result &&
+                STATUS_OK == process_pmt(packet))
+            {
+                // New PMT version, streams and PIDs are updated
+                event.type       = TS_EVENT_PMT;
+                event.pid        = m_pmt_pid;
+                event.unit_start = true;
+                event.data       = NULL;
+                event.size       = 0;
+                event.has_pts    = false;
+                event.pts        = 0;
+                result = STATUS_OK;
+            }
             break;
         }
+    }
 
-    } while(0);
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSProcessor::passthrough(const struct ts_packet& packet,
+    const uint8_t* raw)
+{
+    STATUS result = STATUS_OK;
+
+    int pid = ts_pid::get(packet.header);
+    bool selected = (0 == pid) ||
+        (STATE_PAT != m_state && pid == m_pmt_pid) ||
+        (STATE_ES == m_state && OUTPUT_NONE != m_route[pid]);
+
+    if (NULL != m_ts_output && selected)
+    {
+        result = m_ts_output->write_packet(m_input_packets * TS_PACKET_SIZE,
+            raw);
+    }
+
+    if (NULL != m_playout && STATUS_OK == result)
+    {
+        result = m_playout->push(raw, selected);
+    }
 
     return result;
 }
@@ -401,37 +1342,69 @@ STATUS TSProcessor::demux()
 *
 ********************************************************************************
 */
-STATUS TSProcessor::read_packet(struct ts_packet& packet)
+STATUS TSProcessor::process_es(const struct ts_packet& packet,
+    struct ts_event& event)
 {
-    STATUS result = STATUS_FAIL;
+    STATUS result = STATUS_AGAIN;
 
     do
     {
-        size_t read_bytes = fread(&packet.header, 1, TS_PACKET_HEADER,
-            m_input_file);
-        if (TS_PACKET_HEADER != read_bytes)
+        int pid  = ts_pid::get(packet.header);
+        int pusi = ts_pusi::get(packet.header);
+
+        /**
+        ************************************************************************
+        * @note     Subscriber gets whole PES units, so packets before the first
+        *           unit start are skipped
+        ************************************************************************
+        */
+        if (SUB_PENDING == m_subscribed[pid] && pusi)
         {
-            fprintf(stderr, "Can't read TS packet header from %s file!\n",
-                m_input_filename.c_str());
-            break;
+            m_subscribed[pid] = SUB_ACTIVE;
         }
 
-        packet.header = htobe32(packet.header);
-        if (!IS_PACKET_VALID(packet.header))
+        if (OUTPUT_NONE == m_route[pid] && SUB_ACTIVE != m_subscribed[pid])
         {
-            fprintf(stderr, "Sync byte of TS packet has wrong value\n");
             break;
         }
 
-        read_bytes = fread(&packet.payload, 1, TS_PACKET_PAYLOAD, m_input_file);
-        if (TS_PACKET_PAYLOAD != read_bytes)
+        const uint8_t* data = NULL;
+        size_t size = 0;
+        if (STATUS_OK != parse_payload(packet.header, data, size))
         {
-            fprintf(stderr, "Can't read TS packet payload from %s file!",
-                m_input_filename.c_str());
             break;
         }
 
+        event.has_pts = false;
+        event.pts     = 0;
+
+        if (pusi)
+        {
+            /**
+            ********************************************************************
+            * @note     PES header (including optional fields) is stripped.
+            *           Packet with broken header is dropped
+            ********************************************************************
+            */
+            struct pes_header pes;
+            if (STATUS_OK != parse_pes_header(data, size, pes))
+            {
+                break;
+            }
+            data += pes.header_size;
+            size -= pes.header_size;
+            event.has_pts = pes.has_pts;
+            event.pts     = pes.pts;
+        }
+
+        event.type       = TS_EVENT_PES;
+        event.pid        = pid;
+        event.unit_start = (0 != pusi);
+        event.data       = data;
+        event.size       = size;
+
         result = STATUS_OK;
+
     } while(0);
 
     return result;
@@ -442,66 +1415,94 @@ STATUS TSProcessor::read_packet(struct ts_packet& packet)
 *
 ********************************************************************************
 */
-STATUS TSProcessor::process_file()
+STATUS TSProcessor::write_es(const struct ts_event& event)
 {
     STATUS result = STATUS_OK;
-    
-    do
+
+    ESWriter* f = m_outputs[m_route[event.pid]];
+    if (NULL != f)
     {
-        struct ts_packet packet;
-        result = read_packet(packet);
-        if (0 != result)
+        if (event.unit_start && event.has_pts)
         {
-            break;
+            f->mark_unit(event.pts);
         }
+        result = f->write(event.data, event.size);
+    }
 
-        int pid  = (packet.header & PID_MASK) >> 8;
-        int pusi = (packet.header & PUSI_MASK);
-        int afc  = (packet.header & AFC_MASK) >> 4;
-        if (pid != m_video_pid && pid != m_audio_pid)
-        {
-            continue;
-        }
+    return result;
+}
 
-        size_t pi = 0;
-        if (2 == afc || 3 == afc) // 10 or 11 in bin
-        {
-            pi = packet.payload[pi];
-            pi += 1;
-        }
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProcessor::preallocate_es()
+{
+    uint64_t routed[OUTPUT_MAX + 1] = { 0 };
+    uint64_t total = 0;
+
+    /**
+    ****************************************************************************
+    * @note     Head of the file was just read, so it is taken from page cache
+    ****************************************************************************
+    */
+    uint8_t* sample = static_cast<uint8_t*>(malloc(ES_SHARE_SAMPLE));
+    ssize_t size = (NULL == sample) ? -1 :
+        pread(fileno(m_input_file), sample, ES_SHARE_SAMPLE, 0);
+
+    for (ssize_t i = 0; i + TS_PACKET_SIZE <= size; i += TS_PACKET_SIZE)
+    {
+        routed[m_route[ts_pid::get(&sample[i])]] += 1;
+        total += 1;
+    }
+    free(sample);
 
-        if (pusi)
+    if (0 != total)
+    {
+        /**
+        ************************************************************************
+        * @note     Estimation is increased by 1/8, unused space is released
+        *           when file is closed
+        ************************************************************************
+        */
+        uint64_t packets = m_input_filesize / TS_PACKET_SIZE;
+        uint64_t margin  = TS_PACKET_PAYLOAD + TS_PACKET_PAYLOAD / 8;
+        size_t first = (OUTPUT_VIDEO < m_preallocated) ? m_preallocated :
+            (size_t)OUTPUT_VIDEO;
+        for (size_t i = first; i < m_outputs.size(); ++i)
         {
-            /**
-            ********************************************************************
-            * @warning  Start code compliance is not checked since there is an
-            *           assumption that valid input stream goes on input
-            * @note     PES packet lenght and start code is skipped start code
-            *           is 4 bytes including stream ID and Size of PES is
-            *           bytes.
-            ********************************************************************
-            */
-            pi += 4 + 2;
-
-            uint32_t opes = (htobe32(*(uint32_t*)&packet.payload[pi])
-                & 0x0000ff00) >> 8;
-            pi += 3 + opes;
+            if (NULL != m_outputs[i])
+            {
+                m_outputs[i]->preallocate(packets * routed[i] / total *
+                    margin);
+            }
         }
+    }
 
-        FILE* f = (pid == m_video_pid) ? m_video_file : m_audio_file;
-        size_t w_bytes = fwrite(&packet.payload[pi], 1, TS_PACKET_PAYLOAD - pi,
-            f);
-        if (TS_PACKET_PAYLOAD - pi != w_bytes)
-        {
-            result = STATUS_FAIL;
-            fprintf(stderr, "Can't write to (%s) file (%lu) bytes!\n",
-                "test", TS_PACKET_PAYLOAD - pi);
+    m_preallocated = m_outputs.size();
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSProcessor::save_pid(const struct ts_stream_info& info)
+{
+    switch(info.kind)
+    {
+        case STREAM_VIDEO:
+            m_video_pid = info.pid;
             break;
-        }
 
-    } while((size_t)ftell(m_input_file) < m_input_filesize);
+        case STREAM_AUDIO:
+            m_audio_pid = info.pid;
+            break;
 
-    return result;
+        default:
+            break;
+    }
 }
 
 /*
@@ -509,24 +1510,89 @@ STATUS TSProcessor::process_file()
 *
 ********************************************************************************
 */
-void TSProcessor::save_pid(uint16_t pid, int type)
+STATUS TSProcessor::route_streams()
 {
-    // List may be not full (H.264 and AAC here)
-    switch(type)
+    STATUS result = STATUS_OK;
+
+    memset(m_route, OUTPUT_NONE, sizeof(m_route));
+
+    /**
+    ****************************************************************************
+    * @note     Without rules video and audio PIDs are routed even if there
+    *           are no files, so PES events are produced for feed()/next_event()
+    *           users. Lazy users subscribe to PIDs they need instead
+    ****************************************************************************
+    */
+    bool implicit = m_rules.empty() && !m_lazy;
+    if (0x1fff != m_video_pid &&
+        (NULL != m_outputs[OUTPUT_VIDEO] || implicit))
     {
-        // Video types
-        case 0x01:
-        case 0x02:
-        case 0x10:
-        case 0x1B:
-        case 0x24:
-            m_video_pid = pid;
-            break;
+        m_route[m_video_pid] = OUTPUT_VIDEO;
+    }
+
+    if (0x1fff != m_audio_pid &&
+        (NULL != m_outputs[OUTPUT_AUDIO] || implicit))
+    {
+        m_route[m_audio_pid] = OUTPUT_AUDIO;
+    }
 
-        // Audio types
-        case 0x03:
-        case 0x0F:
-            m_audio_pid = pid;
+    for (size_t i = 0; i < m_streams.size() && STATUS_OK == result; ++i)
+    {
+        const struct ts_stream_info& info = m_streams[i];
+        if (NULL != m_cues && CODEC_SCTE35 == info.codec)
+        {
+            m_cues->add_pid(info.pid);
+        }
+
+        for (size_t r = 0; r < m_rules.size(); ++r)
+        {
+            if (OUTPUT_NONE != m_route[info.pid] ||
+                !match_select_rule(m_rules[r], info))
+            {
+                continue;
+            }
+
+            // Rules may put several streams into one file
+            std::string name = select_output_name(m_rules[r], info);
+            size_t out = OUTPUT_VIDEO;
+            while (out < m_outputs.size() && (NULL == m_outputs[out] ||
+                name != m_outputs[out]->filename()))
+            {
+                ++out;
+            }
+
+            if (out == m_outputs.size())
+            {
+                if (OUTPUT_MAX < out)
+                {
+                    fprintf(stderr, "Too many outputs of selection rules "
+                        "(max: %d)\n", OUTPUT_MAX - OUTPUT_AUDIO);
+                    result = STATUS_FAIL;
+                    break;
+                }
+
+                m_outputs.push_back(open_output(name));
+                if (NULL == m_outputs[out])
+                {
+                    result = STATUS_FAIL;
+                    break;
+                }
+            }
+
+            if ((STREAM_SUBTITLE == info.kind ||
+                STREAM_TELETEXT == info.kind) &&
+                STATUS_OK != m_outputs[out]->enable_pts_index())
+            {
+                result = STATUS_FAIL;
+                break;
+            }
+
+            m_route[info.pid] = out;
+            fprintf(stdout, "\tSelected PID: %d (0x%x) -> %s\n", info.pid,
+                info.pid, name.c_str());
             break;
+        }
     }
+
+    return result;
 }
@@ -11,9 +11,23 @@
 #define _TS_PROCESSOR_H_
 
 #include <string>
+#include <vector>
 #include <stdio.h>
 #include <stdint.h>
 
+class TSPassthrough;
+class ESWriter;
+class CueWriter;
+class SITables;
+class TSAnalyzer;
+struct ts_checkpoint;
+class TSSwitcher;
+class PcapInput;
+class TSSegments;
+class TSPlayout;
+class SectionAssembler;
+class SectionCache;
+
 /**
 ********************************************************************************
 * @enum         STATUS
@@ -23,73 +37,66 @@
 typedef enum
 {
     STATUS_OK   = 0,
-    STATUS_FAIL = 1
+    STATUS_FAIL = 1,
+    STATUS_AGAIN = 2    ///< More input is required to continue
 } STATUS;
 
 /**
 ********************************************************************************
-* @def          SYNC_BYTE_MASK
-* @brief        TS packet synchronization byte mask (for big-endian structure)
+* @def          TS_SYNC_BYTE
+* @brief        Value of TS packet synchronization byte
 ********************************************************************************
 */
-#define SYNC_BYTE_MASK  0xff000000
+#define TS_SYNC_BYTE    0x47
 
 /**
 ********************************************************************************
-* @def          IS_PACKET_VALID
-* @brief        Macro which validates TS Packet header (header value must be
-*               in big-endian structure)
+* @def          TS_PACKET_HEADER
+* @brief        Size of TS packet header
 ********************************************************************************
 */
-#define IS_PACKET_VALID(header) (((header & SYNC_BYTE_MASK) >> 24) == 0x47)
+#define TS_PACKET_HEADER    4
 
 /**
 ********************************************************************************
-* @def          PUSI_MASK
-* @brief        PUSI mask (for bit-endian structure)
+* @def          TS_PACKET_PAYLOAD
+* @brief        Size of TS packet payload (including adaptation field)
 ********************************************************************************
 */
-#define PUSI_MASK       0x00400000
+#define TS_PACKET_PAYLOAD   184
 
 /**
 ********************************************************************************
-* @def          PID_MASK
-* @brief        TS packet ID mask (for big-endian structure)
+* @def          TS_PACKET_SIZE
+* @brief        Size of TS packet (header + payload)
 ********************************************************************************
 */
-#define PID_MASK        0x001fff00
+#define TS_PACKET_SIZE      (TS_PACKET_HEADER + TS_PACKET_PAYLOAD)
 
 /**
 ********************************************************************************
-* @def          AFC_MASK
-* @brief        Adaptation field control mask (for big-endian structure)
+* @def          TS_PID_COUNT
+* @brief        Number of PIDs (13-bit PID field)
 ********************************************************************************
 */
-#define AFC_MASK        0x00000030
+#define TS_PID_COUNT    8192
 
 /**
 ********************************************************************************
-* @def          TS_PACKET_HEADER
-* @brief        Size of TS packet header
+* @def          TS_READ_PACKETS
+* @brief        Number of TS packets read from input file at once
 ********************************************************************************
 */
-#define TS_PACKET_HEADER    4
+#define TS_READ_PACKETS     1024
 
 /**
 ********************************************************************************
-* @def          TS_PACKET_PAYLOAD
-* @brief        Size of TS packet payload (including adaptation field)
+* @def          ES_SHARE_SAMPLE
+* @brief        Size of input file head used to estimate share of video and
+*               audio packets for preallocation of output files
 ********************************************************************************
 */
-#define TS_PACKET_PAYLOAD   184
-
-/**
-********************************************************************************
-* @def          TS_PACKET_SIZE
-* @brief        Size of TS packet (header + payload)
-********************************************************************************
-*/
-#define TS_PACKET_SIZE      (TS_PACKET_HEADER + TS_PACKET_PAYLOAD)
+#define ES_SHARE_SAMPLE     (8 * 1024 * TS_PACKET_SIZE)
 
 /**
 ********************************************************************************
@@ -101,19 +108,160 @@ struct ts_packet
 {
     /**
     ****************************************************************************
-    * @brief    TS packet header
-    * @note     Structure of a header (Big Endian):
+    * @brief    TS packet header. Fields are read with descriptors from
+    *           ts_fields.h (ts_pid, ts_pusi, ts_afc, etc.)
     ****************************************************************************
     */
-    uint32_t header;
+    const uint8_t* header;
 
     /**
     ****************************************************************************
-    * @brief    Payload of TS packet, including Adaptation field
+    * @brief    Payload of TS packet, including Adaptation field. Points
+    *           directly into the input chunk given to TSProcessor::feed()
     ****************************************************************************
     */
-    uint8_t  payload[184];
+    const uint8_t* payload;
+
+};
+
+/**
+********************************************************************************
+* @enum         TS_EVENT
+* @brief        Types of events produced by TSProcessor::next_event()
+********************************************************************************
+*/
+typedef enum
+{
+    TS_EVENT_PAT = 0,   ///< PAT found, PMT PID is known
+    TS_EVENT_PMT = 1,   ///< PMT found, video and audio PIDs are known
+    TS_EVENT_PES = 2    ///< Part of video or audio PES payload
+} TS_EVENT;
+
+/**
+********************************************************************************
+* @struct       ts_event
+* @brief        Single demultiplexer event. Data pointer is valid until next
+*               call of TSProcessor::next_event() or TSProcessor::feed()
+********************************************************************************
+*/
+struct ts_event
+{
+    TS_EVENT        type;       ///< Type of the event
+    uint16_t        pid;        ///< PID of the packet produced the event
+    bool            unit_start; ///< Data starts new PES unit (TS_EVENT_PES)
+    const uint8_t*  data;       ///< ES data without PES header (TS_EVENT_PES)
+    size_t          size;       ///< Size of ES data in bytes (TS_EVENT_PES)
+    bool            has_pts;    ///< PES header of the unit has PTS
+    uint64_t        pts;        ///< PTS of the unit (90 kHz, if has_pts)
+};
+
+/**
+********************************************************************************
+* @enum         STREAM_KIND
+* @brief        Kind of elementary stream
+********************************************************************************
+*/
+typedef enum
+{
+    STREAM_UNKNOWN  = 0,
+    STREAM_VIDEO    = 1,
+    STREAM_AUDIO    = 2,
+    STREAM_SUBTITLE = 3,    ///< DVB subtitles
+    STREAM_TELETEXT = 4,    ///< EBU teletext (including teletext subtitles)
+    STREAM_DATA     = 5     ///< Other data (SCTE-35, metadata, etc.)
+} STREAM_KIND;
 
+/**
+********************************************************************************
+* @enum         STREAM_CODEC
+* @brief        Codec of elementary stream resolved from stream type and
+*               descriptors
+********************************************************************************
+*/
+typedef enum
+{
+    CODEC_UNKNOWN   = 0,
+    CODEC_MPEG1V,
+    CODEC_MPEG2V,
+    CODEC_MPEG4V,
+    CODEC_H264,
+    CODEC_HEVC,
+    CODEC_MPA,          ///< MPEG-1/2 audio layer I-III
+    CODEC_AAC,          ///< AAC in ADTS
+    CODEC_AAC_LATM,     ///< AAC in LATM
+    CODEC_AC3,
+    CODEC_EAC3,
+    CODEC_DTS,
+    CODEC_DVBSUB,
+    CODEC_TELETEXT,
+    CODEC_SCTE35,
+    CODEC_COUNT         ///< Number of codecs (not a codec)
+} STREAM_CODEC;
+
+/**
+********************************************************************************
+* @def          REG_FOURCC
+* @brief        Builds format identifier of registration descriptor
+********************************************************************************
+*/
+#define REG_FOURCC(a, b, c, d) \
+    (((uint32_t)(a) << 24) | ((uint32_t)(b) << 16) | \
+     ((uint32_t)(c) << 8) | (uint32_t)(d))
+
+/**
+********************************************************************************
+* @struct       ts_stream_info
+* @brief        Metadata of elementary stream collected from PMT
+********************************************************************************
+*/
+struct ts_stream_info
+{
+    uint16_t        pid;            ///< Elementary stream PID
+    uint8_t         type;           ///< Stream type from PMT
+    STREAM_KIND     kind;           ///< Kind of the stream
+    STREAM_CODEC    codec;          ///< Codec of the stream
+    char            language[4];    ///< ISO 639-2 code, empty if unknown
+    uint8_t         audio_type;     ///< ISO 639 audio type (0 - undefined)
+    uint32_t        registration;   ///< Format identifier, 0 if absent
+    int             component_tag;  ///< Stream identifier, -1 if absent
+    uint8_t         sub_type;       ///< Subtitling or teletext type
+    uint16_t        sub_page;       ///< Composition page or teletext page
+    uint16_t        sub_ancillary;  ///< Ancillary page (DVB subtitles)
+};
+
+/**
+********************************************************************************
+* @struct       select_rule
+* @brief        Compiled selection rule. Rule text has the form
+*               "KIND[:KEY=VALUE[,KEY=VALUE...]] -> OUTPUT", where KIND is
+*               video, audio, subtitle, teletext, data or any, KEY is lang,
+*               codec, pid or type. OUTPUT may contain %pid%, %lang%, %codec%
+*               and %kind% which are replaced by values of the stream
+********************************************************************************
+*/
+struct select_rule
+{
+    std::string     text;           ///< Rule as given by user
+    bool            any_kind;       ///< Kind isn't checked
+    STREAM_KIND     kind;           ///< Kind of stream
+    char            language[4];    ///< ISO 639-2 code, empty - any
+    int             codec;          ///< STREAM_CODEC, -1 - any
+    int             pid;            ///< PID, -1 - any
+    int             type;           ///< Stream type, -1 - any
+    std::string     output;         ///< Output file name pattern
+};
+
+/**
+********************************************************************************
+* @struct       pcap_filter
+* @brief        Destination of UDP datagrams taken from capture (see
+*               parse_pcap_filter())
+********************************************************************************
+*/
+struct pcap_filter
+{
+    uint32_t        address;        ///< IPv4 address (host order), 0 - any
+    uint16_t        port;           ///< UDP port, 0 - any
 };
 
 /**
@@ -121,6 +269,10 @@ struct ts_packet
 * @class        TSProcessor
 * @brief        Declaration of MPEG-TS file procesisng
 * @note         This class has initialization method in order to
+* @note         Besides of file processing (demux) class can be used as
+*               resumable demultiplexer: input chunks are given by feed() and
+*               events are taken by next_event() until it returns STATUS_AGAIN,
+*               so a single thread can serve many streams without blocking
 ********************************************************************************
 */
 class TSProcessor
@@ -144,11 +296,148 @@ public:
     ****************************************************************************
     * @brief    Does initialization of the object by opening all files given
     *           in constructor
+    * @note     Input file name may be empty. In this case the stream has to be
+    *           given by process() or feed() calls
     * @return   STATUS_OK on success, STATUS_FAIL - otherwise
     ****************************************************************************
     */
     STATUS init(void);
 
+    /**
+    ****************************************************************************
+    * @brief    Selects NUMA node for input buffer. Must be called before init()
+    * @param    [in] node   NUMA node or NUMA_NODE_ANY (default)
+    * @return   void
+    ****************************************************************************
+    */
+    void set_numa_node(int node);
+
+    /**
+    ****************************************************************************
+    * @brief    Enables output of unmodified TS packets of PAT, PMT, video and
+    *           audio PIDs. Must be called before init()
+    * @param    [in] filename   Output TS file name
+    * @return   void
+    ****************************************************************************
+    */
+    void set_ts_output(const char* const filename);
+
+    /**
+    ****************************************************************************
+    * @brief    Enables output of the same packets as set_ts_output() to UDP
+    *           destination in real time, paced by PCR. Must be called before
+    *           init()
+    * @param    [in] destination    udp://<address>:<port>
+    * @return   void
+    ****************************************************************************
+    */
+    void set_udp_output(const char* const destination);
+
+    /**
+    ****************************************************************************
+    * @brief    Adds rule of ES selection. Streams matched by rules are written
+    *           to the output files named by the rules, the first matching
+    *           rule wins. Must be called before init()
+    * @param    [in] rule   Compiled rule (see parse_select_rule())
+    * @return   void
+    ****************************************************************************
+    */
+    void add_select(const struct select_rule& rule);
+
+    /**
+    ****************************************************************************
+    * @brief    Enables extraction of SCTE-35 splice commands of all SCTE-35
+    *           PIDs of the program into cue list. Must be called before
+    *           init()
+    * @param    [in] filename   Output cue list file name
+    * @return   void
+    ****************************************************************************
+    */
+    void set_cue_output(const char* const filename);
+
+    /**
+    ****************************************************************************
+    * @brief    Enables decoding of DVB SI tables (SDT, EIT present/following,
+    *           NIT, TDT/TOT) into SI log. Must be called before init()
+    * @param    [in] filename   Output SI log file name
+    * @return   void
+    ****************************************************************************
+    */
+    void set_si_output(const char* const filename);
+
+    /**
+    ****************************************************************************
+    * @brief    Enables TR 101 290 priority 1 and 2 checks of every packet.
+    *           Packets with wrong sync byte are counted and skipped instead
+    *           of failing the processing. Must be called before init()
+    * @return   void
+    ****************************************************************************
+    */
+    void enable_analysis(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Enables checkpoints of demux(): input position, PSI state and
+    *           sizes of ES outputs are saved each interval bytes of input,
+    *           checkpoint is removed when demux() succeeds. Must be called
+    *           before init()
+    * @param    [in] filename   Checkpoint file name
+    * @param    [in] interval   Input bytes between checkpoints
+    * @return   void
+    ****************************************************************************
+    */
+    void set_checkpoint(const char* const filename, uint64_t interval);
+
+    /**
+    ****************************************************************************
+    * @brief    Makes init() continue the job of checkpoint given by
+    *           set_checkpoint(): outputs are truncated to checkpointed sizes
+    *           and input is read from checkpointed offset. Must be called
+    *           before init()
+    * @return   void
+    ****************************************************************************
+    */
+    void enable_resume(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Makes demux() read clean stream merged of the input file and
+    *           its backup copy: segments of input with lost packets or
+    *           missing in it are taken from backup. Must be called before
+    *           init()
+    * @param    [in] filename   Backup MPEG-TS file name
+    * @return   void
+    ****************************************************************************
+    */
+    void set_backup(const char* const filename);
+
+    /**
+    ****************************************************************************
+    * @brief    Sets input file to be pcap/pcapng capture. TS packets are taken
+    *           from UDP (RTP) datagrams sent to the destination
+    * @param    [in] filter     Destination of datagrams
+    * @return   void
+    ****************************************************************************
+    */
+    void set_pcap(const struct pcap_filter& filter);
+
+    /**
+    ****************************************************************************
+    * @brief    Sets input file to be m3u8 playlist (or list of files). Its
+    *           segments are demultiplexed as single stream
+    * @return   void
+    ****************************************************************************
+    */
+    void set_playlist(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Returns TR 101 290 analyzer
+    * @return   Analyzer, NULL if analysis isn't enabled
+    ****************************************************************************
+    */
+    const TSAnalyzer* analyzer(void) const;
+
     /**
     ****************************************************************************
     * @brief    Performs demultiplex of MPEG-TS file. This function has 3 main
@@ -161,64 +450,303 @@ public:
     */
     STATUS demux(void);
 
+    /**
+    ****************************************************************************
+    * @brief    Demultiplexes next chunk of MPEG-TS stream and writes video
+    *           and audio ES to output files. Chunk may have any size
+    * @param    [in] data   Chunk of MPEG-TS stream
+    * @param    [in] size   Size of the chunk in bytes
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS process(const uint8_t* data, size_t size);
+
+    /**
+    ****************************************************************************
+    * @brief    Checks the state of demultiplexer at the end of the stream
+    * @return   STATUS_OK if PAT and PMT were found and there is no truncated
+    *           packet left, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS finish(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Gives next chunk of MPEG-TS stream to the demultiplexer. Chunk
+    *           may have any size, partial packets are carried over to the
+    *           next chunk
+    * @param    [in] data   Chunk of MPEG-TS stream
+    * @param    [in] size   Size of the chunk in bytes
+    * @warning  Chunk is not copied, so it must stay valid until next_event()
+    *           returns STATUS_AGAIN
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS feed(const uint8_t* data, size_t size);
+
+    /**
+    ****************************************************************************
+    * @brief    Runs demultiplexer over the chunk given by feed() until the next
+    *           event is produced or the chunk is exhausted
+    * @param    [out] event Event will be returned by the function
+    * @return   STATUS_OK on event, STATUS_AGAIN if more input is required,
+    *           STATUS_FAIL - on broken stream
+    ****************************************************************************
+    */
+    STATUS next_event(struct ts_event& event);
+
+    /**
+    ****************************************************************************
+    * @brief    Returns metadata of elementary streams of the current PMT
+    *           version. Table is updated before TS_EVENT_PMT is returned
+    * @return   Streams in the order of PMT, empty until PMT is found
+    ****************************************************************************
+    */
+    const std::vector<struct ts_stream_info>& streams(void) const;
+
+    /**
+    ****************************************************************************
+    * @brief    Enables lazy demultiplex: video and audio PIDs without output
+    *           files aren't routed, so PES events are produced only for
+    *           PIDs given to subscribe(). Packets of other PIDs are skipped
+    *           after header decode
+    * @warning  Must be called before PMT is found
+    * @return   void
+    ****************************************************************************
+    */
+    void enable_lazy(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Requests PES events of the PID. PID may be subscribed at any
+    *           moment (even before PMT is found), events start with the next
+    *           packet of the PID which starts PES unit
+    * @param    [in] pid    PID of elementary stream
+    * @return   void
+    ****************************************************************************
+    */
+    void subscribe(uint16_t pid);
+
+    /**
+    ****************************************************************************
+    * @brief    Stops PES events of the PID requested by subscribe(). Events
+    *           of PIDs routed to output files go on
+    * @param    [in] pid    PID of elementary stream
+    * @return   void
+    ****************************************************************************
+    */
+    void unsubscribe(uint16_t pid);
+
 private:
     /**
     ****************************************************************************
-    * @brie     Process MPEG-TS file after video PID and audio PID is known
-    * @warning  All packets with PID different than m_video_pid and m_audio_pid
-    *           will be ignored by this function
+    * @enum     STATE
+    * @brief    Stages of demultiplexing
+    ****************************************************************************
+    */
+    typedef enum
+    {
+        STATE_PAT   = 0,    ///< Searching for PAT
+        STATE_PMT   = 1,    ///< Searching for PMT
+        STATE_ES    = 2     ///< Extracting video and audio ES
+    } STATE;
+
+    /**
+    ****************************************************************************
+    * @enum     OUTPUT
+    * @brief    Fixed indexes of m_outputs. Outputs of selection rules follow
+    ****************************************************************************
+    */
+    typedef enum
+    {
+        OUTPUT_NONE     = 0,    ///< PID isn't routed
+        OUTPUT_VIDEO    = 1,    ///< Output video file
+        OUTPUT_AUDIO    = 2,    ///< Output audio file
+        OUTPUT_MAX      = 255   ///< Maximum index (m_route is 8-bit)
+    } OUTPUT;
+
+    /**
+    ****************************************************************************
+    * @enum     SUBSCRIPTION
+    * @brief    States of PID in m_subscribed
+    ****************************************************************************
+    */
+    typedef enum
+    {
+        SUB_NONE        = 0,    ///< PID isn't subscribed
+        SUB_PENDING     = 1,    ///< Waiting for the start of PES unit
+        SUB_ACTIVE      = 2     ///< PES events are produced
+    } SUBSCRIPTION;
+
+    /**
+    ****************************************************************************
+    * @brief    Opens input file and allocates buffer for reading it
     * @return   STATUS_OK on success, STATUS_FAIL - otherwise
     ****************************************************************************
     */
-    STATUS process_file(void);
+    STATUS open_input(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Processes single TS packet depends on current stage
+    * @param    [in] packet     Packet to process
+    * @param    [out] event     Event produced by the packet (if any)
+    * @return   STATUS_OK if event was produced, STATUS_AGAIN if packet
+    *           produced nothing, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS process_packet(const struct ts_packet& packet,
+        struct ts_event& event);
 
     /**
     ****************************************************************************
-    * @brief    Read single TS packet from input file at current position
-    * @param    [out] packet    Packet will be returned by the function
+    * @brief    Writes packet to TS output if its PID is selected. PAT is
+    *           always selected, PMT - after PAT is found, routed ES - after
+    *           PMT is found. UDP output takes every packet for its timing
+    * @param    [in] packet     Packet to check
+    * @param    [in] raw        Raw packet data
     * @return   STATUS_OK on success, STATUS_FAIL - otherwise
     ****************************************************************************
     */
-    STATUS read_packet(struct ts_packet& packet);
+    STATUS passthrough(const struct ts_packet& packet, const uint8_t* raw);
+
+    /**
+    ****************************************************************************
+    * @brief    Extracts ES data from packet of routed or subscribed PID
+    * @warning  All packets with PID which isn't routed (see m_route) or
+    *           subscribed (see m_subscribed) will be ignored by this function
+    * @param    [in] packet     Packet to process
+    * @param    [out] event     PES event
+    * @return   STATUS_OK if event was produced, STATUS_AGAIN - otherwise
+    ****************************************************************************
+    */
+    STATUS process_es(const struct ts_packet& packet, struct ts_event& event);
+
+    /**
+    ****************************************************************************
+    * @brief    Writes ES data of PES event to the output file routed to PID
+    * @param    [in] event  PES event
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS write_es(const struct ts_event& event);
+
+    /**
+    ****************************************************************************
+    * @brief    Reserves space of ES output files. Expected size is
+    *           estimated as input file size multiplied by the share of
+    *           packets routed to the file at the beginning of input file.
+    *           Each output is preallocated once, input is sampled only when
+    *           a new PMT version opened more outputs
+    * @warning  Must be called only after PMT was found
+    * @return   void
+    ****************************************************************************
+    */
+    void preallocate_es(void);
 
     /**
     ****************************************************************************
     * @brief    Does search for PAT (Program Association Table) in the stream.
-    *           Basically it starts reading packet by packet from last position
-    *           in the stream and searches for packet with PID 0 and skips all
-    *           other packets. This function MUST initialize m_pmt_pid with 
-    *           PID found in PAT
+    *           All packets with PID different than 0 are skipped. This
+    *           function MUST initialize m_pmt_pid with PID found in PAT
+    * @param    [in] packet     Packet to process
     * @return   STATUS_OK on sucees (m_pmt_pid set to value found in PAT),
-    *           STATUS_FAIL - otherwise
+    *           STATUS_AGAIN if packet is not PAT, STATUS_FAIL - otherwise
     ****************************************************************************
     */
-    STATUS process_pat(void);
+    STATUS process_pat(const struct ts_packet& packet);
 
     /**
     ****************************************************************************
-    * @brief    Does search for PMT (Program Map Table) in the stream. Basically
-    *           it starts reading packet by packet (like process pat) from last
-    *           position in the stream and searches for packet with PID
-    *           m_pmt_pid and skips all other packets.
+    * @brief    Does search for PMT (Program Map Table) in the stream. All
+    *           packets with PID different than m_pmt_pid are skipped.
+    *           Sections are assembled from packets of PMT PID, descriptors
+    *           are parsed into m_streams once per PMT version, sections of
+    *           already known version are skipped
     * @warning  This function must be called only in case if process_pat was
     *           finished successfully and PMT PID was found
+    * @param    [in] packet     Packet to process
     * @return   STATUS_OK on sucees (m_video_pid and m_audio_pid set to value
-    *           found in PAT), STATUS_FAIL - otherwise
+    *           found in PAT), STATUS_AGAIN if packet is not PMT or PMT
+    *           version is not changed, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS process_pmt(const struct ts_packet& packet);
+
+    /**
+    ****************************************************************************
+    * @brief    Parses PMT section of a new version into m_streams, routes
+    *           streams and keeps the section for checkpoints
+    * @param    [in] section    Complete PMT section
+    * @param    [in] size       Size of the section
+    * @return   STATUS_OK on new version, STATUS_AGAIN if version is not
+    *           changed or section is broken (CRC), STATUS_FAIL - otherwise
     ****************************************************************************
     */
-    STATUS process_pmt(void);
+    STATUS process_pmt_section(const uint8_t* section, size_t size);
+
+    /**
+    ****************************************************************************
+    * @brief    Checks CRC of PAT/PMT section. Section which is byte for byte
+    *           the same as a checked one (repeated table, next segment of
+    *           playlist) is taken from cache without CRC calculation
+    * @param    [in] pid        PID of the section
+    * @param    [in] section    Complete section
+    * @param    [in] size       Size of the section including CRC
+    * @return   true if section is correct
+    ****************************************************************************
+    */
+    bool check_section(uint16_t pid, const uint8_t* section, size_t size);
+
+    /**
+    ****************************************************************************
+    * @brief    Creates ES output. Output of checkpoint continues the file
+    * @param    [in] filename   Output file name
+    * @return   Initialized output, NULL on failure
+    ****************************************************************************
+    */
+    ESWriter* open_output(const std::string& filename);
+
+    /**
+    ****************************************************************************
+    * @brief    Syncs ES outputs and saves checkpoint at current input
+    *           position
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS save_state(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Restores input position and PSI state of loaded checkpoint
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS restore_state(void);
 
     /**
     ****************************************************************************
     * @brief    Modifies one of 2 class members (m_video_pid or m_audio_pid)
-    *           depends on ES type passed
-    * @param    [in] pid    Packet ID
-    * @param    [in] type   Elementary stream type
+    *           depends on kind of the stream
+    * @param    [in] info   Elementary stream metadata
     * @note     It modifies m_video_pid and m_audio_pid class members
     * @return   void
     ****************************************************************************
     */
-    void save_pid(uint16_t pid, int type);
+    void save_pid(const struct ts_stream_info& info);
+
+    /**
+    ****************************************************************************
+    * @brief    Compiles PID dispatch table (m_route) from streams of current
+    *           PMT. Video and audio PIDs are routed to video and audio files,
+    *           other streams - to the output of the first matching rule.
+    *           Output files of rules are opened here, files already opened
+    *           for previous PMT version are reused. Subtitle and teletext
+    *           outputs get PTS index. SCTE-35 PIDs are given to cue list
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS route_streams(void);
 
 private:    // Blocked implementations
     TSProcessor();
@@ -231,12 +759,61 @@ private:
     std::string     m_audio_filename;   ///< Output audio ES file name
 
     FILE*           m_input_file;       ///< MPEG-TS file descriptor
-    FILE*           m_video_file;       ///< Video ES file descriptor
-    FILE*           m_audio_file;       ///< Audio ES file descriptor
+    std::vector<ESWriter*> m_outputs;   ///< ES files indexed by OUTPUT
+    size_t          m_preallocated;     ///< Leading outputs preallocated
+    std::vector<struct select_rule> m_rules; ///< ES selection rules
+    uint8_t         m_route[TS_PID_COUNT]; ///< Index of output of each PID
+    uint8_t         m_subscribed[TS_PID_COUNT]; ///< SUBSCRIPTION of each PID
+    bool            m_lazy;             ///< Only subscribed PIDs get events
 
     size_t          m_input_filesize;   ///< MPEG-TS file size
+    uint8_t*        m_buffer;           ///< Buffer for reading input file
+    int             m_numa_node;        ///< NUMA node of m_buffer
+
+    STATE           m_state;            ///< Current stage of demultiplexing
+    const uint8_t*  m_data;             ///< Chunk given by feed()
+    size_t          m_data_size;        ///< Size of the chunk
+    size_t          m_data_pos;         ///< Position of next packet in chunk
+    uint8_t         m_carry[TS_PACKET_SIZE]; ///< Packet split between chunks
+    size_t          m_carry_size;       ///< Bytes stored in m_carry
+    uint64_t        m_packets;          ///< Number of packets processed
+    uint64_t        m_input_packets;    ///< Input packets incl. skipped ones
+
+    std::string     m_ts_output_filename; ///< Output TS file name
+    TSPassthrough*  m_ts_output;        ///< Output of unmodified packets
+    std::string     m_udp_destination;  ///< UDP output destination
+    TSPlayout*      m_playout;          ///< Paced UDP output
+
+    std::string     m_cue_filename;     ///< Output cue list file name
+    CueWriter*      m_cues;             ///< SCTE-35 cue list
+
+    std::string     m_si_filename;      ///< Output SI log file name
+    SITables*       m_si;               ///< DVB SI tables
+
+    bool            m_analysis;         ///< TR 101 290 checks are enabled
+    TSAnalyzer*     m_analyzer;         ///< TR 101 290 analyzer
+
+    std::string     m_checkpoint_filename; ///< Checkpoint file name
+    uint64_t        m_checkpoint_interval; ///< Input bytes between them
+    uint64_t        m_checkpoint_pos;   ///< Input position of the last one
+    uint64_t        m_input_pos;        ///< Input bytes read by demux()
+    bool            m_resume;           ///< Job of checkpoint is continued
+    ts_checkpoint*  m_resume_point;     ///< Loaded checkpoint
+
+    std::string     m_backup_filename;  ///< Backup copy of the input
+    TSSwitcher*     m_switch;           ///< Merge of input and its backup
+    bool            m_pcap;             ///< Input file is capture
+    struct pcap_filter m_pcap_filter;   ///< Datagrams taken from capture
+    PcapInput*      m_capture;          ///< Reader of capture
+    bool            m_playlist;         ///< Input file is list of segments
+    TSSegments*     m_segments;         ///< Reader of segments
+    std::vector<uint8_t> m_pmt_section; ///< Current PMT section
 
     uint16_t        m_pmt_pid;          ///< PID TS packet which contains PMT
+    SectionAssembler* m_pmt_sections;   ///< Sections of PMT PID
+    SectionCache*   m_checked;          ///< PAT/PMT sections with correct CRC
+    int             m_pmt_version;      ///< Version of PMT, -1 if not found
+    std::vector<struct ts_stream_info> m_streams; ///< Streams of PMT
 
     uint16_t        m_video_pid;        ///< Video PID
     uint16_t        m_audio_pid;        ///< Audio PID
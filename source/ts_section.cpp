@@ -0,0 +1,281 @@
+/**
+********************************************************************************
+* @file         ts_section.cpp
+* @brief        Assembler of PSI/SI sections spanning several TS packets
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "ts_section.h"
+#include "ts_fields.h"
+#include "ts_parse.h"
+
+#include <string.h>
+
+/**
+********************************************************************************
+* @brief        Table of CRC32 remainders for each byte value
+********************************************************************************
+*/
+static uint32_t s_crc_table[256];
+
+/**
+********************************************************************************
+* @brief        Fills CRC32 table
+* @return       true
+********************************************************************************
+*/
+static bool init_crc_table()
+{
+    for (uint32_t i = 0; i < 256; ++i)
+    {
+        uint32_t crc = i << 24;
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            crc = (crc & 0x80000000u) ? (crc << 1) ^ 0x04c11db7u : crc << 1;
+        }
+        s_crc_table[i] = crc;
+    }
+
+    return true;
+}
+
+/**
+********************************************************************************
+* @brief        Table is filled during static initialization, before any
+*               thread is started
+********************************************************************************
+*/
+static const bool s_crc_ready = init_crc_table();
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+uint32_t psi_crc32(const uint8_t* data, size_t size)
+{
+    uint32_t crc = 0xffffffffu;
+    (void)s_crc_ready;
+
+    for (size_t i = 0; i < size; ++i)
+    {
+        crc = (crc << 8) ^ s_crc_table[(crc >> 24) ^ data[i]];
+    }
+
+    return crc;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+SectionAssembler::SectionAssembler()
+    : m_started(false)
+    , m_cc(-1)
+    , m_done_pos(0)
+{
+    m_partial.reserve(PSI_MAX_SECTION);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void SectionAssembler::push(const uint8_t* packet)
+{
+    const uint8_t* data = NULL;
+    size_t size = 0;
+
+    // Sections returned before are released
+    m_done.erase(m_done.begin(), m_done.begin() + m_done_pos);
+    m_done_pos = 0;
+
+    do
+    {
+        // Packets without payload don't increment continuity counter
+        if (STATUS_OK != parse_payload(packet, data, size) || 0 == size)
+        {
+            break;
+        }
+
+        int cc = ts_cc::get(packet);
+        if (cc == m_cc)
+        {
+            break;  // Duplicate packet
+        }
+
+        if (-1 != m_cc && ((m_cc + 1) & 0x0f) != cc)
+        {
+            m_partial.clear();
+            m_started = false;
+        }
+        m_cc = cc;
+
+        if (!ts_pusi::get(packet))
+        {
+            append(data, size);
+            break;
+        }
+
+        /**
+        ************************************************************************
+        * @note     Bytes before pointer finish previous section, the new one
+        *           starts after them. Section which isn't finished by then is
+        *           broken and dropped
+        ************************************************************************
+        */
+        size_t pointer = psi_pointer_field::get(data);
+        if (pointer + 1 > size)
+        {
+            m_partial.clear();
+            m_started = false;
+            break;
+        }
+
+        append(data + 1, pointer);
+        m_partial.clear();
+        m_started = true;
+        append(data + 1 + pointer, size - 1 - pointer);
+
+    } while(0);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void SectionAssembler::append(const uint8_t* data, size_t size)
+{
+    while (0 != size && m_started)
+    {
+        // Stuffing instead of table_id: the rest of the packet is unused
+        if (!m_partial.empty() && 0xff == m_partial[0])
+        {
+            m_partial.clear();
+            m_started = false;
+            break;
+        }
+
+        size_t need = (m_partial.size() < psi_section_length::END) ?
+            psi_section_length::END - m_partial.size() :
+            psi_section_length::END + psi_section_length::get(&m_partial[0]) -
+            m_partial.size();
+        size_t take = (need < size) ? need : size;
+
+        m_partial.insert(m_partial.end(), data, data + take);
+        data += take;
+        size -= take;
+
+        if (m_partial.size() < psi_section_length::END)
+        {
+            continue;
+        }
+
+        // Empty sections are dropped, they can't have even table header
+        size_t length = psi_section_length::get(&m_partial[0]);
+        if (m_partial.size() == psi_section_length::END + length)
+        {
+            if (0 != length)
+            {
+                m_done.insert(m_done.end(), m_partial.begin(),
+                    m_partial.end());
+            }
+            m_partial.clear();
+        }
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS SectionAssembler::next_section(const uint8_t*& section, size_t& size)
+{
+    STATUS result = STATUS_AGAIN;
+
+    if (m_done_pos + psi_section_length::END <= m_done.size())
+    {
+        section = &m_done[m_done_pos];
+        size = psi_section_length::END + psi_section_length::get(section);
+        m_done_pos += size;
+        result = STATUS_OK;
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+SectionCache::SectionCache()
+    : m_hits(0)
+{
+
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+bool SectionCache::find(uint16_t pid, const uint8_t* section, size_t size)
+{
+    bool found = false;
+
+    // CRC_32 field selects the only candidate, bytes confirm it
+    if (4 <= size)
+    {
+        std::map<uint64_t, std::vector<uint8_t> >::const_iterator it =
+            m_sections.find(key(pid, section, size));
+        found = (m_sections.end() != it && it->second.size() == size &&
+            0 == memcmp(&it->second[0], section, size));
+    }
+    m_hits += found ? 1 : 0;
+
+    return found;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void SectionCache::insert(uint16_t pid, const uint8_t* section, size_t size)
+{
+    if (4 <= size)
+    {
+        if (SECTION_CACHE_SIZE <= m_sections.size())
+        {
+            m_sections.clear();
+        }
+        m_sections[key(pid, section, size)].assign(section, section + size);
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+uint64_t SectionCache::hits() const
+{
+    return m_hits;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+uint64_t SectionCache::key(uint16_t pid, const uint8_t* section, size_t size)
+{
+    return ((uint64_t)pid << 32) | be_bytes<4>::load(section + size - 4);
+}
@@ -0,0 +1,169 @@
+/**
+********************************************************************************
+* @file         ts_section.h
+* @brief        Assembler of PSI/SI sections spanning several TS packets
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _TS_SECTION_H_
+#define _TS_SECTION_H_
+
+#include <map>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ts_processor.h"
+
+/**
+********************************************************************************
+* @def          PSI_MAX_SECTION
+* @brief        Maximum size of section (12-bit section_length + 3 bytes)
+********************************************************************************
+*/
+#define PSI_MAX_SECTION     (4095 + 3)
+
+/**
+********************************************************************************
+* @def          SECTION_CACHE_SIZE
+* @brief        Maximal number of sections held by SectionCache
+********************************************************************************
+*/
+#define SECTION_CACHE_SIZE  1024
+
+/**
+********************************************************************************
+* @brief        Calculates CRC32 of MPEG-2 sections (polynomial 0x04c11db7,
+*               no reflection, initial value 0xffffffff)
+* @param        [in] data   Data to check
+* @param        [in] size   Size of data in bytes
+* @return       CRC32 value. For the whole section including CRC_32 field
+*               the result is 0 if section is not corrupted
+********************************************************************************
+*/
+uint32_t psi_crc32(const uint8_t* data, size_t size);
+
+/**
+********************************************************************************
+* @class        SectionAssembler
+* @brief        Collects sections of single PID from TS packets. Sections may
+*               span several packets and several sections may share one
+*               packet. Continuity counter is checked, so partially lost
+*               sections are dropped instead of being glued together
+* @note         Usage is the same as of TSProcessor: push() packet, then
+*               take sections by next_section() until it returns STATUS_AGAIN
+********************************************************************************
+*/
+class SectionAssembler
+{
+public:
+    SectionAssembler();
+
+    /**
+    ****************************************************************************
+    * @brief    Adds payload of TS packet. Sections completed by the packet
+    *           become available from next_section()
+    * @param    [in] packet TS packet (TS_PACKET_SIZE bytes)
+    * @return   void
+    ****************************************************************************
+    */
+    void push(const uint8_t* packet);
+
+    /**
+    ****************************************************************************
+    * @brief    Returns next complete section
+    * @param    [out] section   Section (starting with table_id), valid until
+    *                           next push()
+    * @param    [out] size      Size of the section including CRC
+    * @return   STATUS_OK if section is returned, STATUS_AGAIN - otherwise
+    ****************************************************************************
+    */
+    STATUS next_section(const uint8_t*& section, size_t& size);
+
+private:
+    /**
+    ****************************************************************************
+    * @brief    Appends payload bytes to the section in progress and moves
+    *           complete sections to m_done
+    * @param    [in] data   Payload bytes
+    * @param    [in] size   Number of bytes
+    * @return   void
+    ****************************************************************************
+    */
+    void append(const uint8_t* data, size_t size);
+
+private:
+    std::vector<uint8_t>    m_partial;  ///< Section in progress
+    bool                    m_started;  ///< m_partial holds section start
+    int                     m_cc;       ///< Last continuity counter, -1 - none
+
+    std::vector<uint8_t>    m_done;     ///< Complete sections, back to back
+    size_t                  m_done_pos; ///< Next section to return
+};
+
+/**
+********************************************************************************
+* @class        SectionCache
+* @brief        Sections already checked by CRC, keyed by PID and CRC_32 field
+*               of the section. PSI/SI tables are repeated every 100 ms with
+*               the same content, so a repeated section is recognized by byte
+*               compare of the cached one instead of CRC calculation and
+*               parsing
+* @note         Cache is cleared when it is full, carousel fills it again
+********************************************************************************
+*/
+class SectionCache
+{
+public:
+    SectionCache();
+
+    /**
+    ****************************************************************************
+    * @brief    Checks whether the same section of the PID was inserted
+    * @param    [in] pid        PID of the section
+    * @param    [in] section    Section (starting with table_id)
+    * @param    [in] size       Size of the section including CRC
+    * @return   true if the section is cached
+    ****************************************************************************
+    */
+    bool find(uint16_t pid, const uint8_t* section, size_t size);
+
+    /**
+    ****************************************************************************
+    * @brief    Adds section with correct CRC
+    * @param    [in] pid        PID of the section
+    * @param    [in] section    Section (starting with table_id)
+    * @param    [in] size       Size of the section including CRC
+    * @return   void
+    ****************************************************************************
+    */
+    void insert(uint16_t pid, const uint8_t* section, size_t size);
+
+    /**
+    ****************************************************************************
+    * @brief    Returns number of sections found in the cache
+    * @return   Number of hits
+    ****************************************************************************
+    */
+    uint64_t hits(void) const;
+
+private:
+    /**
+    ****************************************************************************
+    * @brief    Makes key of the section
+    * @param    [in] pid        PID of the section
+    * @param    [in] section    Section (starting with table_id)
+    * @param    [in] size       Size of the section including CRC
+    * @return   PID in the upper half, CRC_32 field in the lower one
+    ****************************************************************************
+    */
+    static uint64_t key(uint16_t pid, const uint8_t* section, size_t size);
+
+private:
+    std::map<uint64_t, std::vector<uint8_t> > m_sections; ///< Cached sections
+    uint64_t                m_hits;     ///< Sections found
+};
+
+#endif  /* !_TS_SECTION_H_ */
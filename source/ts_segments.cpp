@@ -0,0 +1,560 @@
+/**
+********************************************************************************
+* @file         ts_segments.cpp
+* @brief        Input of MPEG-TS split into segment files (HLS recording)
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "ts_segments.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <openssl/evp.h>
+
+/**
+********************************************************************************
+* @brief        Finds attribute of m3u8 tag
+* @param        [in] list   Attribute list (NAME=VALUE,NAME="VALUE",...)
+* @param        [in] name   Name of the attribute
+* @return       Value without quotes, empty if attribute is missing
+********************************************************************************
+*/
+static std::string m3u8_attribute(const std::string& list, const char* name)
+{
+    std::string value;
+    size_t pos = 0;
+
+    while (pos < list.size())
+    {
+        size_t eq = list.find('=', pos);
+        if (std::string::npos == eq)
+        {
+            break;
+        }
+
+        // Quoted value may contain commas
+        size_t start = eq + 1;
+        size_t end = ('"' == list[start]) ? list.find('"', start + 1) :
+            list.find(',', start);
+        end = (std::string::npos == end) ? list.size() : end;
+        if (0 == list.compare(pos, eq - pos, name))
+        {
+            value = ('"' == list[start]) ? list.substr(start + 1,
+                end - start - 1) : list.substr(start, end - start);
+            break;
+        }
+
+        end = list.find(',', end);
+        pos = (std::string::npos == end) ? list.size() : end + 1;
+    }
+
+    return value;
+}
+
+/**
+********************************************************************************
+* @brief        Parses IV attribute (hexadecimal number with 0x prefix)
+* @param        [in] text   Attribute value
+* @param        [out] iv    Initialization vector
+* @return       true on success
+********************************************************************************
+*/
+static bool parse_iv(const std::string& text, uint8_t* iv)
+{
+    bool result = (2 < text.size() && text.size() <= 2 + 2 * SEGMENT_KEY_SIZE &&
+        '0' == text[0] && ('x' == text[1] || 'X' == text[1]));
+
+    // Short number is aligned to the right, as 128-bit big endian value
+    memset(iv, 0, SEGMENT_KEY_SIZE);
+    for (size_t i = 0; result && i + 2 < text.size(); ++i)
+    {
+        char c = text[text.size() - 1 - i];
+        int digit = ('0' <= c && c <= '9') ? c - '0' :
+            ('a' <= c && c <= 'f') ? c - 'a' + 10 :
+            ('A' <= c && c <= 'F') ? c - 'A' + 10 : -1;
+        result = (0 <= digit);
+        iv[SEGMENT_KEY_SIZE - 1 - i / 2] |= (result ? digit : 0) <<
+            (4 * (i % 2));
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+TSSegments::TSSegments(FILE* list, const char* const filename)
+    : m_list(list)
+    , m_filename(filename)
+    , m_size(0)
+    , m_key(-1)
+    , m_explicit_iv(false)
+    , m_sequence(0)
+    , m_current(0)
+    , m_fd(-1)
+    , m_next_fd(-1)
+    , m_cipher(NULL)
+    , m_left(0)
+    , m_read(0)
+    , m_missing(0)
+    , m_decrypted(0)
+{
+    memset(m_iv, 0, sizeof(m_iv));
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+TSSegments::~TSSegments()
+{
+    if (-1 != m_fd)
+    {
+        close(m_fd);
+        m_fd = -1;
+    }
+
+    if (-1 != m_next_fd)
+    {
+        close(m_next_fd);
+        m_next_fd = -1;
+    }
+
+    EVP_CIPHER_CTX_free(m_cipher);
+    m_cipher = NULL;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSSegments::init()
+{
+    STATUS result = STATUS_FAIL;
+
+    // Relative paths of the list are taken from its directory
+    size_t slash = m_filename.rfind('/');
+    std::string dir = (std::string::npos == slash) ? std::string() :
+        m_filename.substr(0, slash + 1);
+
+    char* line = NULL;
+    size_t capacity = 0;
+    bool broken = false;
+    while (-1 != getline(&line, &capacity, m_list))
+    {
+        std::string path(line);
+        while (!path.empty() && NULL != strchr(" \t\r\n",
+            path[path.size() - 1]))
+        {
+            path.erase(path.size() - 1);
+        }
+
+        if (0 == path.compare(0, 22, "#EXT-X-MEDIA-SEQUENCE:"))
+        {
+            m_sequence = strtoull(path.c_str() + 22, NULL, 10);
+            continue;
+        }
+
+        if (0 == path.compare(0, 11, "#EXT-X-KEY:"))
+        {
+            if (STATUS_OK != parse_key(path.substr(11), dir))
+            {
+                broken = true;
+                break;
+            }
+            continue;
+        }
+
+        if (path.empty() || '#' == path[0])
+        {
+            continue;
+        }
+
+        if (std::string::npos != path.find("://"))
+        {
+            fprintf(stderr, "Remote segment isn't supported: %s\n",
+                path.c_str());
+            broken = true;
+            break;
+        }
+
+        struct ts_segment segment;
+        segment.path = ('/' == path[0]) ? path : dir + path;
+        segment.key  = m_key;
+
+        // Without IV attribute IV is media sequence number of the segment
+        memset(segment.iv, 0, SEGMENT_KEY_SIZE);
+        for (size_t i = 0; i < sizeof(m_sequence); ++i)
+        {
+            segment.iv[SEGMENT_KEY_SIZE - 1 - i] = m_sequence >> (8 * i);
+        }
+        if (m_explicit_iv)
+        {
+            memcpy(segment.iv, m_iv, SEGMENT_KEY_SIZE);
+        }
+        m_sequence += 1;
+
+        struct stat st;
+        m_size += (0 == stat(segment.path.c_str(), &st)) ? st.st_size : 0;
+        m_segments.push_back(segment);
+    }
+    free(line);
+
+    do
+    {
+        if (broken)
+        {
+            break;
+        }
+
+        if (ferror(m_list))
+        {
+            fprintf(stderr, "Can't read list (%s). Error: %s\n",
+                m_filename.c_str(), strerror(errno));
+            break;
+        }
+
+        if (m_segments.empty())
+        {
+            fprintf(stderr, "No segments in list (%s)\n", m_filename.c_str());
+            break;
+        }
+
+        m_cipher = m_keys.empty() ? NULL : EVP_CIPHER_CTX_new();
+        if (!m_keys.empty() && NULL == m_cipher)
+        {
+            fprintf(stderr, "Can't create decryption context\n");
+            break;
+        }
+
+        m_fd      = open_segment(0);
+        m_next_fd = (1 < m_segments.size()) ? open_segment(1) : -1;
+        start_segment();
+
+        fprintf(stdout, "TSSegments initialized:\n"
+                        "\tList: %s\n"
+                        "\tSegments: %lu (size: %llu bytes)\n"
+                        "\tKeys: %lu\n",
+                        m_filename.c_str(), m_segments.size(),
+                        (unsigned long long)m_size, m_key_uris.size());
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSSegments::read(uint8_t* data, size_t size, size_t& read_bytes)
+{
+    STATUS result = STATUS_OK;
+
+    read_bytes = 0;
+    while (STATUS_OK == result && 0 == read_bytes &&
+        m_current < m_segments.size())
+    {
+        ssize_t r = 0;
+        if (-1 != m_fd && -1 != m_segments[m_current].key)
+        {
+            size_t decrypted = 0;
+            result = read_encrypted(data, size, decrypted);
+            r = decrypted;
+        }
+        else if (-1 != m_fd)
+        {
+            r = ::read(m_fd, data, size);
+        }
+
+        if (0 < r)
+        {
+            read_bytes = r;
+        }
+        else if (0 == r && STATUS_OK == result)
+        {
+            advance();
+        }
+        else if (0 != r && EINTR != errno)
+        {
+            fprintf(stderr, "Can't read segment (%s). Error: %s\n",
+                m_segments[m_current].path.c_str(), strerror(errno));
+            result = STATUS_FAIL;
+        }
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+uint64_t TSSegments::size() const
+{
+    return m_size;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSSegments::report(FILE* out) const
+{
+    fprintf(out, "Segments finished:\n"
+                 "\tRead: %llu of %lu\n"
+                 "\tDecrypted: %llu\n"
+                 "\tMissing: %llu\n",
+                 (unsigned long long)m_read, m_segments.size(),
+                 (unsigned long long)m_decrypted,
+                 (unsigned long long)m_missing);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+int TSSegments::open_segment(size_t index)
+{
+    int fd = open(m_segments[index].path.c_str(), O_RDONLY);
+
+    if (-1 == fd)
+    {
+        fprintf(stderr, "Can't open segment (%s). Error: %s\n",
+            m_segments[index].path.c_str(), strerror(errno));
+        m_missing += 1;
+    }
+    else
+    {
+        // Read ahead of the whole segment is started in background
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+    }
+
+    return fd;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSSegments::advance()
+{
+    if (-1 != m_fd)
+    {
+        close(m_fd);
+        m_read      += 1;
+        m_decrypted += (-1 != m_segments[m_current].key) ? 1 : 0;
+    }
+
+    m_current += 1;
+    m_fd       = m_next_fd;
+    m_next_fd  = (m_current + 1 < m_segments.size()) ?
+        open_segment(m_current + 1) : -1;
+
+    if (m_current < m_segments.size())
+    {
+        start_segment();
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSSegments::parse_key(const std::string& attributes,
+    const std::string& dir)
+{
+    STATUS result = STATUS_FAIL;
+
+    do
+    {
+        std::string method = m3u8_attribute(attributes, "METHOD");
+        m_explicit_iv = false;
+        if ("NONE" == method)
+        {
+            m_key  = -1;
+            result = STATUS_OK;
+            break;
+        }
+
+        if ("AES-128" != method)
+        {
+            fprintf(stderr, "Encryption method %s isn't supported\n",
+                method.c_str());
+            break;
+        }
+
+        std::string uri = m3u8_attribute(attributes, "URI");
+        if (uri.empty() || std::string::npos != uri.find("://"))
+        {
+            fprintf(stderr, "Key (%s) isn't local file\n", uri.c_str());
+            break;
+        }
+        uri = ('/' == uri[0]) ? uri : dir + uri;
+
+        std::string iv = m3u8_attribute(attributes, "IV");
+        m_explicit_iv = !iv.empty();
+        if (m_explicit_iv && !parse_iv(iv, m_iv))
+        {
+            fprintf(stderr, "Wrong IV of key: %s\n", iv.c_str());
+            break;
+        }
+
+        // Key shared by many segments is read once
+        size_t index = 0;
+        while (index < m_key_uris.size() && uri != m_key_uris[index])
+        {
+            ++index;
+        }
+
+        if (index == m_key_uris.size())
+        {
+            uint8_t key[SEGMENT_KEY_SIZE + 1];
+            FILE* file = fopen(uri.c_str(), "rb");
+            size_t size = (NULL == file) ? 0 : fread(key, 1, sizeof(key),
+                file);
+            if (NULL != file)
+            {
+                fclose(file);
+            }
+
+            if (SEGMENT_KEY_SIZE != size)
+            {
+                fprintf(stderr, "Can't read 16 bytes key (%s)\n",
+                    uri.c_str());
+                break;
+            }
+
+            m_key_uris.push_back(uri);
+            m_keys.insert(m_keys.end(), key, key + SEGMENT_KEY_SIZE);
+        }
+
+        m_key  = index;
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSSegments::start_segment()
+{
+    const struct ts_segment& segment = m_segments[m_current];
+    struct stat st;
+
+    m_left = 0;
+    if (-1 == m_fd || -1 == segment.key)
+    {
+        return;
+    }
+
+    /**
+    ****************************************************************************
+    * @note     Padding is removed by the reader: OpenSSL holds the last block
+    *           back with padding enabled, so in place decryption is refused
+    ****************************************************************************
+    */
+    if (0 != fstat(m_fd, &st) || 0 != st.st_size % SEGMENT_KEY_SIZE ||
+        1 != EVP_DecryptInit_ex(m_cipher, EVP_aes_128_cbc(), NULL,
+        &m_keys[segment.key * SEGMENT_KEY_SIZE], segment.iv) ||
+        1 != EVP_CIPHER_CTX_set_padding(m_cipher, 0))
+    {
+        fprintf(stderr, "Can't decrypt segment (%s)\n",
+            segment.path.c_str());
+        close(m_fd);
+        m_fd = -1;
+        m_missing += 1;
+        return;
+    }
+
+    m_left = st.st_size;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSSegments::read_encrypted(uint8_t* data, size_t size,
+    size_t& read_bytes)
+{
+    STATUS result = STATUS_FAIL;
+    const char* path = m_segments[m_current].path.c_str();
+
+    read_bytes = 0;
+    do
+    {
+        // Whole blocks are read, so the cipher keeps nothing between reads
+        size_t want = ((size < m_left) ? size : m_left) &
+            ~(size_t)(SEGMENT_KEY_SIZE - 1);
+        size_t got = 0;
+        errno = 0;
+        while (got < want)
+        {
+            ssize_t r = ::read(m_fd, data + got, want - got);
+            if (0 < r)
+            {
+                got += r;
+            }
+            else if (0 == r || EINTR != errno)
+            {
+                break;
+            }
+        }
+
+        if (got != want)
+        {
+            fprintf(stderr, "Can't read segment (%s). Error: %s\n", path,
+                (0 == errno) ? "truncated" : strerror(errno));
+            break;
+        }
+
+        int decrypted = 0;
+        if (0 != want && 1 != EVP_DecryptUpdate(m_cipher, data, &decrypted,
+            data, want))
+        {
+            fprintf(stderr, "Can't decrypt segment (%s)\n", path);
+            break;
+        }
+        m_left    -= want;
+        read_bytes = want;
+
+        // PKCS#7 padding fills the last block of the segment
+        uint8_t padding = (0 != want && 0 == m_left) ? data[want - 1] : 0;
+        if (0 != want && 0 == m_left &&
+            (0 == padding || SEGMENT_KEY_SIZE < padding))
+        {
+            fprintf(stderr, "Wrong padding of segment (%s), key or IV is "
+                "wrong\n", path);
+            break;
+        }
+        read_bytes -= padding;
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
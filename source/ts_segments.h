@@ -0,0 +1,191 @@
+/**
+********************************************************************************
+* @file         ts_segments.h
+* @brief        Input of MPEG-TS split into segment files (HLS recording)
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _TS_SEGMENTS_H_
+#define _TS_SEGMENTS_H_
+
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "ts_processor.h"
+
+typedef struct evp_cipher_ctx_st EVP_CIPHER_CTX;
+
+/**
+********************************************************************************
+* @def          SEGMENT_KEY_SIZE
+* @brief        Size of AES-128 key and of its initialization vector
+********************************************************************************
+*/
+#define SEGMENT_KEY_SIZE    16
+
+/**
+********************************************************************************
+* @class        TSSegments
+* @brief        Reads segment files of m3u8 playlist (or plain list, one file
+*               per line) as single stream. Lines starting with '#' are
+*               skipped, relative paths are taken from directory of the list.
+*               Demultiplexer state (PSI, PES, CC) goes on across segments,
+*               so segment boundaries cost only open() of the next file.
+*               Segments encrypted by AES-128 (EXT-X-KEY with local key file)
+*               are decrypted in place, in the buffer of the reader
+* @note         The segment after the current one is opened ahead and its
+*               read ahead is requested by posix_fadvise(POSIX_FADV_WILLNEED),
+*               so the kernel loads it while the current one is parsed.
+*               Segments must hold whole TS packets
+********************************************************************************
+*/
+class TSSegments
+{
+public:
+    /**
+    ****************************************************************************
+    * @brief    The only allowed constructor for this class
+    * @param    [in] list       Opened list (isn't closed)
+    * @param    [in] filename   List file name
+    ****************************************************************************
+    */
+    TSSegments(FILE* list, const char* const filename);
+
+    ~TSSegments();
+
+    /**
+    ****************************************************************************
+    * @brief    Reads the list and finds sizes of its segments
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS init(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Reads the next part of the stream. Segment which can't be
+    *           opened is skipped (stream has CC error there)
+    * @param    [out] data          Buffer
+    * @param    [in] size           Size of the buffer
+    * @param    [out] read_bytes    Number of bytes read, 0 at the end of the
+    *                               last segment
+    * @return   STATUS_OK on success, STATUS_FAIL if segment can't be read
+    ****************************************************************************
+    */
+    STATUS read(uint8_t* data, size_t size, size_t& read_bytes);
+
+    /**
+    ****************************************************************************
+    * @brief    Returns total size of segments
+    * @return   Size in bytes
+    ****************************************************************************
+    */
+    uint64_t size(void) const;
+
+    /**
+    ****************************************************************************
+    * @brief    Prints statistics of segment reading
+    * @param    [in] out    Output stream
+    * @return   void
+    ****************************************************************************
+    */
+    void report(FILE* out) const;
+
+private:
+    /**
+    ****************************************************************************
+    * @struct   ts_segment
+    * @brief    Segment file and its encryption
+    ****************************************************************************
+    */
+    struct ts_segment
+    {
+        std::string     path;               ///< Path of the segment
+        int             key;                ///< Index of key, -1 if clear
+        uint8_t         iv[SEGMENT_KEY_SIZE];   ///< Initialization vector
+    };
+
+    /**
+    ****************************************************************************
+    * @brief    Applies EXT-X-KEY tag to the following segments
+    * @param    [in] attributes Attribute list of the tag
+    * @param    [in] dir        Directory of the list
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS parse_key(const std::string& attributes, const std::string& dir);
+
+    /**
+    ****************************************************************************
+    * @brief    Starts decryption of the current segment. Segment which can't
+    *           be decrypted is skipped as missing one
+    * @return   void
+    ****************************************************************************
+    */
+    void start_segment(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Reads and decrypts the next part of the current segment. Read
+    *           is aligned to AES block, padding of the last block is removed
+    * @param    [out] data          Buffer
+    * @param    [in] size           Size of the buffer
+    * @param    [out] read_bytes    Number of bytes read, 0 at the end of the
+    *                               segment
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS read_encrypted(uint8_t* data, size_t size, size_t& read_bytes);
+
+    /**
+    ****************************************************************************
+    * @brief    Opens segment and requests its read ahead
+    * @param    [in] index  Index of the segment
+    * @return   File descriptor, -1 if segment can't be opened
+    ****************************************************************************
+    */
+    int open_segment(size_t index);
+
+    /**
+    ****************************************************************************
+    * @brief    Closes the current segment and makes the prefetched one
+    *           current, the segment after it is prefetched
+    * @return   void
+    ****************************************************************************
+    */
+    void advance(void);
+
+private:    // Blocked implementations
+    TSSegments();
+    TSSegments(const TSSegments& r);
+    TSSegments& operator= (const TSSegments&);
+
+private:
+    FILE*           m_list;             ///< List file
+    std::string     m_filename;         ///< List file name
+    std::vector<struct ts_segment> m_segments; ///< Segments of the list
+    uint64_t        m_size;             ///< Total size of segments
+
+    std::vector<std::string> m_key_uris; ///< Key files of the list
+    std::vector<uint8_t> m_keys;        ///< Keys, SEGMENT_KEY_SIZE each
+    int             m_key;              ///< Key of the following segments
+    bool            m_explicit_iv;      ///< IV is given by EXT-X-KEY
+    uint8_t         m_iv[SEGMENT_KEY_SIZE]; ///< That IV
+    uint64_t        m_sequence;         ///< Media sequence of next segment
+
+    size_t          m_current;          ///< Index of the current segment
+    int             m_fd;               ///< Current segment, -1 if missing
+    int             m_next_fd;          ///< Prefetched segment
+    EVP_CIPHER_CTX* m_cipher;           ///< Decryption of the current one
+    uint64_t        m_left;             ///< Encrypted bytes left in it
+
+    uint64_t        m_read;             ///< Segments read to the end
+    uint64_t        m_missing;          ///< Segments which can't be opened
+    uint64_t        m_decrypted;        ///< Encrypted segments read
+};
+
+#endif  /* !_TS_SEGMENTS_H_ */
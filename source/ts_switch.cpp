@@ -0,0 +1,546 @@
+/**
+********************************************************************************
+* @file         ts_switch.cpp
+* @brief        Seamless switching between primary and backup copies of the
+*               same MPEG-TS aligned by PCR
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#include "ts_switch.h"
+#include "ts_fields.h"
+#include "ts_parse.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+********************************************************************************
+* @brief        Compares PCRs across wrap around
+* @param        [in] a  The first PCR
+* @param        [in] b  The second PCR
+* @return       true if the first PCR is later than the second one
+********************************************************************************
+*/
+static bool pcr_later(uint64_t a, uint64_t b)
+{
+    uint64_t delta = (a + PCR_WRAP - b) % PCR_WRAP;
+    return 0 != delta && delta < PCR_WRAP / 2;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+TSSwitcher::TSSwitcher(FILE* primary, const char* const primary_name,
+    const char* const backup_name)
+    : m_buffer(NULL)
+    , m_out_pos(0)
+    , m_has_last(false)
+    , m_last_pcr(0)
+    , m_last(NULL)
+    , m_switches(0)
+{
+    struct switch_input* inputs[2] = { &m_primary, &m_backup };
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        struct switch_input& in = *inputs[i];
+        in.file       = NULL;
+        in.ended      = false;
+        in.failed     = false;
+        in.pcr_pid    = -1;
+        in.carry_size = 0;
+        in.cc_errors  = 0;
+        in.taken      = 0;
+        for (size_t pid = 0; pid < TS_PID_COUNT; ++pid)
+        {
+            in.cc[pid]       = -1;
+            in.dups[pid]     = 0;
+            in.last_seq[pid] = 0;
+        }
+
+        in.current.seq     = 0;
+        in.current.has_pcr = false;
+        in.current.pcr     = 0;
+        in.current.damaged = false;
+    }
+
+    m_primary.filename = primary_name;
+    m_primary.file     = primary;
+    m_backup.filename  = backup_name;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+TSSwitcher::~TSSwitcher()
+{
+    // Primary input belongs to the caller
+    if (NULL != m_backup.file)
+    {
+        fclose(m_backup.file);
+        m_backup.file = NULL;
+    }
+
+    free(m_buffer);
+    m_buffer = NULL;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSSwitcher::init()
+{
+    STATUS result = STATUS_FAIL;
+
+    do
+    {
+        m_buffer = static_cast<uint8_t*>(malloc(SWITCH_READ_PACKETS *
+            TS_PACKET_SIZE));
+        if (NULL == m_buffer)
+        {
+            fprintf(stderr, "Can't allocate input buffer\n");
+            break;
+        }
+
+        m_backup.file = fopen(m_backup.filename.c_str(), "rb");
+        if (NULL == m_backup.file)
+        {
+            fprintf(stderr, "Can't open backup file (%s). Error: %s\n",
+                m_backup.filename.c_str(), strerror(errno));
+            break;
+        }
+
+        fprintf(stdout, "TSSwitcher initialized:\n"
+                        "\tPrimary input: %s\n"
+                        "\tBackup input: %s\n",
+                        m_primary.filename.c_str(),
+                        m_backup.filename.c_str());
+        result = STATUS_OK;
+
+    } while(0);
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+STATUS TSSwitcher::read(uint8_t* data, size_t size, size_t& read_bytes)
+{
+    while (m_out.size() - m_out_pos < size &&
+        !(m_primary.ended && m_primary.segments.empty() &&
+        m_backup.ended && m_backup.segments.empty()))
+    {
+        step();
+    }
+
+    size_t left = m_out.size() - m_out_pos;
+    read_bytes = (left < size) ? left : size;
+    if (0 != read_bytes)
+    {
+        memcpy(data, &m_out[m_out_pos], read_bytes);
+    }
+    m_out_pos += read_bytes;
+
+    // Consumed packets are released once they take half of the buffer
+    if (m_out_pos * 2 >= m_out.size())
+    {
+        m_out.erase(m_out.begin(), m_out.begin() + m_out_pos);
+        m_out_pos = 0;
+    }
+
+    return (0 == read_bytes && m_primary.failed && m_backup.failed) ?
+        STATUS_FAIL : STATUS_OK;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSSwitcher::report(FILE* out) const
+{
+    fprintf(out, "Switching finished:\n"
+                 "\tPrimary: %s (segments: %llu, CC errors: %llu)\n"
+                 "\tBackup: %s (segments: %llu, CC errors: %llu)\n"
+                 "\tSwitches: %llu\n",
+                 m_primary.failed ? "failed" : "complete",
+                 (unsigned long long)m_primary.taken,
+                 (unsigned long long)m_primary.cc_errors,
+                 m_backup.failed ? "failed" : "complete",
+                 (unsigned long long)m_backup.taken,
+                 (unsigned long long)m_backup.cc_errors,
+                 (unsigned long long)m_switches);
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSSwitcher::fill(struct switch_input& in)
+{
+    size_t size = fread(m_buffer, 1, SWITCH_READ_PACKETS * TS_PACKET_SIZE,
+        in.file);
+
+    if (0 == size)
+    {
+        if (ferror(in.file))
+        {
+            fprintf(stderr, "Can't read from %s file! Error: %s\n",
+                in.filename.c_str(), strerror(errno));
+            in.failed = true;
+        }
+
+        // Truncated packet is lost
+        if (0 != in.carry_size)
+        {
+            in.current.damaged = true;
+            in.carry_size = 0;
+        }
+
+        in.ended = true;
+        close_segment(in);
+    }
+    else
+    {
+        size_t pos = 0;
+        if (0 != in.carry_size)
+        {
+            size_t need = TS_PACKET_SIZE - in.carry_size;
+            pos = (size < need) ? size : need;
+            memcpy(&in.carry[in.carry_size], m_buffer, pos);
+            in.carry_size += pos;
+
+            if (TS_PACKET_SIZE == in.carry_size)
+            {
+                push_packet(in, in.carry);
+                in.carry_size = 0;
+            }
+        }
+
+        for (; pos + TS_PACKET_SIZE <= size; pos += TS_PACKET_SIZE)
+        {
+            push_packet(in, &m_buffer[pos]);
+        }
+
+        if (pos < size)
+        {
+            memcpy(in.carry, &m_buffer[pos], size - pos);
+            in.carry_size = size - pos;
+        }
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSSwitcher::push_packet(struct switch_input& in, const uint8_t* packet)
+{
+    if (TS_SYNC_BYTE != ts_sync_byte::get(packet))
+    {
+        // Packet is dropped, its PID is unknown
+        in.current.damaged = true;
+        in.cc_errors += 1;
+    }
+    else
+    {
+        uint16_t pid = ts_pid::get(packet);
+        const uint8_t* af = &packet[TS_PACKET_HEADER];
+        size_t af_size = af_length::get(af);
+        bool discontinuity = (ts_afc::get(packet) & 0x02) && 0 != af_size &&
+            af_size < TS_PACKET_PAYLOAD && af_discontinuity::get(af);
+
+        uint64_t pcr = 0;
+        if (STATUS_OK == parse_pcr(packet, pcr))
+        {
+            in.pcr_pid = (in.pcr_pid < 0) ? pid : in.pcr_pid;
+            if (pid == in.pcr_pid)
+            {
+                close_segment(in);
+                in.current.has_pcr = true;
+                in.current.pcr     = pcr;
+            }
+        }
+
+        /**
+        ************************************************************************
+        * @note     Lost packets were somewhere after the previous packet of
+        *           the PID, so all segments since then are damaged
+        ************************************************************************
+        */
+        if (0x1fff != pid && check_cc(in, packet, discontinuity))
+        {
+            in.cc_errors += 1;
+            in.current.damaged = true;
+            for (size_t i = in.segments.size(); 0 != i &&
+                in.segments[i - 1].seq >= in.last_seq[pid]; --i)
+            {
+                in.segments[i - 1].damaged = true;
+            }
+        }
+
+        in.last_seq[pid] = in.current.seq;
+        in.current.data.insert(in.current.data.end(), packet,
+            packet + TS_PACKET_SIZE);
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+bool TSSwitcher::check_cc(struct switch_input& in, const uint8_t* packet,
+    bool discontinuity)
+{
+    uint16_t pid = ts_pid::get(packet);
+    int cc = ts_cc::get(packet);
+    bool lost = false;
+
+    if (-1 == in.cc[pid] || discontinuity)
+    {
+        in.dups[pid] = 0;
+    }
+    else if (0 == (ts_afc::get(packet) & 0x01))
+    {
+        // Counter isn't incremented by packets without payload
+        lost = (cc != in.cc[pid]);
+    }
+    else if (cc == in.cc[pid])
+    {
+        // Packet may be sent twice, but not more
+        in.dups[pid] += 1;
+        lost = (1 < in.dups[pid]);
+    }
+    else
+    {
+        lost = (((in.cc[pid] + 1) & 0x0f) != cc);
+        in.dups[pid] = 0;
+    }
+
+    in.cc[pid] = cc;
+    return lost;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSSwitcher::close_segment(struct switch_input& in)
+{
+    if (!in.current.data.empty())
+    {
+        in.segments.push_back(switch_segment());
+        struct switch_segment& s = in.segments.back();
+        s.seq     = in.current.seq;
+        s.has_pcr = in.current.has_pcr;
+        s.pcr     = in.current.pcr;
+        s.damaged = in.current.damaged;
+        s.data.swap(in.current.data);
+
+        in.current.seq    += 1;
+        in.current.has_pcr = false;
+        in.current.pcr     = 0;
+        in.current.damaged = false;
+        in.current.data.clear();
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+bool TSSwitcher::settled(const struct switch_input& in)
+{
+    bool result = in.ended || in.segments.size() >= SWITCH_MAX_QUEUE;
+
+    // Packets before the first PCR aren't timed, they are taken at once
+    if (!result && !in.segments.empty())
+    {
+        const struct switch_segment& s = in.segments.front();
+        result = !s.has_pcr || (in.current.has_pcr &&
+            (in.current.pcr + PCR_WRAP - s.pcr) % PCR_WRAP >= SWITCH_DELAY);
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+bool TSSwitcher::next_pcr(const struct switch_input& in, uint64_t& pcr)
+{
+    bool result = false;
+
+    if (1 < in.segments.size() && in.segments[1].has_pcr)
+    {
+        pcr = in.segments[1].pcr;
+        result = true;
+    }
+    else if (1 == in.segments.size() && in.current.has_pcr)
+    {
+        pcr = in.current.pcr;
+        result = true;
+    }
+
+    return result;
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSSwitcher::step()
+{
+    struct switch_input& p = m_primary;
+    struct switch_input& b = m_backup;
+
+    if (!settled(p))
+    {
+        fill(p);
+    }
+    else if (!settled(b))
+    {
+        fill(b);
+    }
+    else if (p.segments.empty())
+    {
+        // Primary is over, backup goes on after the last taken segment
+        const struct switch_segment& s = b.segments.front();
+        if (!m_has_last || (s.has_pcr && pcr_later(s.pcr, m_last_pcr)))
+        {
+            take(b);
+        }
+        else
+        {
+            b.segments.pop_front();
+        }
+    }
+    else if (b.segments.empty())
+    {
+        take(p);
+    }
+    else
+    {
+        const struct switch_segment& ps = p.segments.front();
+        const struct switch_segment& bs = b.segments.front();
+        uint64_t ahead  = (ps.pcr + PCR_WRAP - bs.pcr) % PCR_WRAP;
+        uint64_t behind = (bs.pcr + PCR_WRAP - ps.pcr) % PCR_WRAP;
+        uint64_t pn = 0;
+        uint64_t bn = 0;
+        bool has_pn = next_pcr(p, pn);
+        bool has_bn = next_pcr(b, bn);
+
+        /**
+        ************************************************************************
+        * @note     Backup segment earlier than primary one is missing in
+        *           primary, unless it is a copy of already taken segment.
+        *           Primary segment earlier than backup one is missing in
+        *           backup. Packets before the first PCR of backup are dropped.
+        *           Segment followed by the head of the other input is its
+        *           neighbour, however long PCR gap it has
+        ************************************************************************
+        */
+        if (!ps.has_pcr)
+        {
+            take(p);
+        }
+        else if (!bs.has_pcr)
+        {
+            b.segments.pop_front();
+        }
+        else if (0 == ahead)
+        {
+            bool lost_p = ps.damaged;
+            bool lost_b = bs.damaged;
+
+            /**
+            ********************************************************************
+            * @note     Loss may keep continuity counters by chance (lost
+            *           number of packets of each PID is multiple of 16, or
+            *           looks like a duplicate). Copy which lost PCR packets
+            *           has the next PCR later than the other one, copy which
+            *           lost other packets is shorter
+            ********************************************************************
+            */
+            if (has_pn && has_bn && pn != bn)
+            {
+                lost_p = lost_p || pcr_later(pn, bn);
+                lost_b = lost_b || pcr_later(bn, pn);
+            }
+            else
+            {
+                lost_p = lost_p || ps.data.size() < bs.data.size();
+                lost_b = lost_b || bs.data.size() < ps.data.size();
+            }
+
+            bool backup = lost_p && !lost_b;
+            take(backup ? b : p);
+            (backup ? p : b).segments.pop_front();
+        }
+        else if (ahead <= SWITCH_MAX_SKEW || (has_bn && bn == ps.pcr))
+        {
+            if (m_has_last && !pcr_later(bs.pcr, m_last_pcr))
+            {
+                b.segments.pop_front();
+            }
+            else
+            {
+                take(b);
+            }
+        }
+        else if (behind <= SWITCH_MAX_SKEW || (has_pn && pn == bs.pcr))
+        {
+            take(p);
+        }
+        else
+        {
+            take(p);
+            b.segments.pop_front();
+        }
+    }
+}
+
+/*
+********************************************************************************
+*
+********************************************************************************
+*/
+void TSSwitcher::take(struct switch_input& in)
+{
+    struct switch_segment& s = in.segments.front();
+
+    m_out.insert(m_out.end(), s.data.begin(), s.data.end());
+    if (s.has_pcr)
+    {
+        m_has_last = true;
+        m_last_pcr = s.pcr;
+    }
+
+    if (NULL != m_last && &in != m_last)
+    {
+        m_switches += 1;
+    }
+    m_last = &in;
+    in.taken += 1;
+
+    in.segments.pop_front();
+}
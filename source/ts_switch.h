@@ -0,0 +1,259 @@
+/**
+********************************************************************************
+* @file         ts_switch.h
+* @brief        Seamless switching between primary and backup copies of the
+*               same MPEG-TS aligned by PCR
+* @author       Maksym Koshel (maks.koshel@gmail.com)
+* @date         Oct 17, 2026
+********************************************************************************
+*/
+
+#ifndef _TS_SWITCH_H_
+#define _TS_SWITCH_H_
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdint.h>
+
+#include "ts_processor.h"
+
+/**
+********************************************************************************
+* @def          SWITCH_READ_PACKETS
+* @brief        Number of TS packets read from input at once
+********************************************************************************
+*/
+#define SWITCH_READ_PACKETS 64
+
+/**
+********************************************************************************
+* @def          SWITCH_DELAY
+* @brief        Time segment is held before output (27 MHz, 1 second). Loss
+*               of packets is detected by the next packet of the same PID,
+*               so the segment is final only when its PIDs went on
+********************************************************************************
+*/
+#define SWITCH_DELAY        27000000ull
+
+/**
+********************************************************************************
+* @def          SWITCH_MAX_QUEUE
+* @brief        Maximal number of segments held per input
+********************************************************************************
+*/
+#define SWITCH_MAX_QUEUE    4096
+
+/**
+********************************************************************************
+* @def          SWITCH_MAX_SKEW
+* @brief        Maximal PCR distance of segments which are compared (27 MHz,
+*               10 seconds). Inputs which are further apart (or PCR jump of
+*               one of them) are advanced segment by segment in pairs
+********************************************************************************
+*/
+#define SWITCH_MAX_SKEW     (10ull * 27000000)
+
+/**
+********************************************************************************
+* @class        TSSwitcher
+* @brief        Reads primary and backup copies of the same transport stream
+*               and produces single clean stream of TS packets. Each input is
+*               split into segments which start with PCR packet of its PCR
+*               PID. Segment with continuity counter error (or lost sync) is
+*               damaged. Segments of both inputs are aligned by PCR: damaged
+*               segment of primary is replaced with its copy from backup,
+*               segment missing in primary is taken from backup
+* @note         Both inputs must come from the same multiplexer, so packets
+*               (and continuity counters) of both are the same and output
+*               stays continuous across switches
+********************************************************************************
+*/
+class TSSwitcher
+{
+public:
+    /**
+    ****************************************************************************
+    * @brief    The only allowed constructor for this class
+    * @param    [in] primary        Opened primary input (isn't closed)
+    * @param    [in] primary_name   Primary input file name
+    * @param    [in] backup_name    Backup input file name
+    ****************************************************************************
+    */
+    TSSwitcher(FILE* primary, const char* const primary_name,
+        const char* const backup_name);
+
+    ~TSSwitcher();
+
+    /**
+    ****************************************************************************
+    * @brief    Opens backup input
+    * @return   STATUS_OK on success, STATUS_FAIL - otherwise
+    ****************************************************************************
+    */
+    STATUS init(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Reads packets of clean stream
+    * @param    [out] data          Buffer
+    * @param    [in] size           Size of the buffer
+    * @param    [out] read_bytes    Number of bytes read (whole packets), 0 at
+    *                               the end of both inputs
+    * @return   STATUS_OK on success, STATUS_FAIL if both inputs failed
+    ****************************************************************************
+    */
+    STATUS read(uint8_t* data, size_t size, size_t& read_bytes);
+
+    /**
+    ****************************************************************************
+    * @brief    Prints statistics of switching
+    * @param    [in] out    Output stream
+    * @return   void
+    ****************************************************************************
+    */
+    void report(FILE* out) const;
+
+private:
+    /**
+    ****************************************************************************
+    * @struct   switch_segment
+    * @brief    Packets from PCR packet until the next one
+    ****************************************************************************
+    */
+    struct switch_segment
+    {
+        uint64_t                seq;        ///< Number of the segment
+        bool                    has_pcr;    ///< Segment starts with PCR
+        uint64_t                pcr;        ///< PCR of the segment
+        bool                    damaged;    ///< Packets of segment were lost
+        std::vector<uint8_t>    data;       ///< TS packets
+    };
+
+    /**
+    ****************************************************************************
+    * @struct   switch_input
+    * @brief    Input and its segments
+    ****************************************************************************
+    */
+    struct switch_input
+    {
+        std::string     filename;       ///< Input file name
+        FILE*           file;           ///< Input file
+        bool            ended;          ///< Input is exhausted or failed
+        bool            failed;         ///< Input can't be read
+
+        int             pcr_pid;        ///< PCR PID, -1 until found
+        int             cc[TS_PID_COUNT];       ///< Last CC, -1 if unknown
+        uint8_t         dups[TS_PID_COUNT];     ///< Repeated packets
+        uint64_t        last_seq[TS_PID_COUNT]; ///< Segment of last packet
+
+        struct switch_segment current;  ///< Segment being collected
+        std::deque<struct switch_segment> segments; ///< Complete segments
+
+        uint8_t         carry[TS_PACKET_SIZE];  ///< Packet split by reads
+        size_t          carry_size;     ///< Bytes stored in carry
+
+        uint64_t        cc_errors;      ///< Continuity errors
+        uint64_t        taken;          ///< Segments taken to output
+    };
+
+    /**
+    ****************************************************************************
+    * @brief    Reads the next chunk of the input and splits it into segments
+    * @param    [in] in Input
+    * @return   void
+    ****************************************************************************
+    */
+    void fill(struct switch_input& in);
+
+    /**
+    ****************************************************************************
+    * @brief    Appends packet to the current segment of the input
+    * @param    [in] in     Input
+    * @param    [in] packet TS packet
+    * @return   void
+    ****************************************************************************
+    */
+    void push_packet(struct switch_input& in, const uint8_t* packet);
+
+    /**
+    ****************************************************************************
+    * @brief    Checks continuity counter of the packet
+    * @param    [in] in     Input
+    * @param    [in] packet TS packet
+    * @param    [in] discontinuity  Discontinuity indicator of the packet
+    * @return   true if packets of the PID were lost
+    ****************************************************************************
+    */
+    static bool check_cc(struct switch_input& in, const uint8_t* packet,
+        bool discontinuity);
+
+    /**
+    ****************************************************************************
+    * @brief    Completes the current segment of the input
+    * @param    [in] in Input
+    * @return   void
+    ****************************************************************************
+    */
+    static void close_segment(struct switch_input& in);
+
+    /**
+    ****************************************************************************
+    * @brief    Checks whether the first segment of the input is final: it
+    *           is held for SWITCH_DELAY or the input is over
+    * @param    [in] in Input
+    * @return   true if the first segment can be taken
+    ****************************************************************************
+    */
+    static bool settled(const struct switch_input& in);
+
+    /**
+    ****************************************************************************
+    * @brief    Finds PCR of the segment which follows the first one
+    * @param    [in] in     Input
+    * @param    [out] pcr   PCR of that segment
+    * @return   true if the segment is known and starts with PCR
+    ****************************************************************************
+    */
+    static bool next_pcr(const struct switch_input& in, uint64_t& pcr);
+
+    /**
+    ****************************************************************************
+    * @brief    Chooses the next segment of output when heads of both inputs
+    *           are settled, reads inputs otherwise
+    * @return   void
+    ****************************************************************************
+    */
+    void step(void);
+
+    /**
+    ****************************************************************************
+    * @brief    Moves the first segment of the input to output
+    * @param    [in] in Input
+    * @return   void
+    ****************************************************************************
+    */
+    void take(struct switch_input& in);
+
+private:    // Blocked implementations
+    TSSwitcher();
+    TSSwitcher(const TSSwitcher& r);
+    TSSwitcher& operator= (const TSSwitcher&);
+
+private:
+    struct switch_input m_primary;      ///< Primary input
+    struct switch_input m_backup;       ///< Backup input
+    uint8_t*        m_buffer;           ///< Input chunk
+
+    std::vector<uint8_t> m_out;         ///< Packets of output
+    size_t          m_out_pos;          ///< Packets already read
+
+    bool            m_has_last;         ///< Segment with PCR was taken
+    uint64_t        m_last_pcr;         ///< PCR of that segment
+    const struct switch_input* m_last;  ///< Input of the last segment
+    uint64_t        m_switches;         ///< Changes of input
+};
+
+#endif  /* !_TS_SWITCH_H_ */